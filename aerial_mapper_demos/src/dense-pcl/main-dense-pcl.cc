@@ -10,6 +10,7 @@
 
 // NON-SYSTEM
 #include <aerial-mapper-dense-pcl/stereo.h>
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -31,6 +32,15 @@ DEFINE_int32(dense_pcl_use_every_nth_image, 10,
 DEFINE_bool(use_BM, true,
             "Use BM Blockmatching if true. Use SGBM (=Semi-Global-) "
             "Blockmatching if false.");
+DEFINE_int32(strip_height, 0,
+             "Match the rectified pairs in horizontal strips of this height "
+             "[pixels] in parallel. 0 matches the whole image at once.");
+DEFINE_bool(use_search_range_guidance, false,
+            "Search only the disparities expected in every band of rows? "
+            "May miss disparities outside of the expected ones.");
+DEFINE_int32(guidance_pyramid_levels, 2,
+             "Pyramid levels of the downsampled pair that estimates the "
+             "expected disparities if the terrain height is unknown.");
 
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
@@ -57,19 +67,29 @@ int main(int argc, char** argv) {
   io::PoseFormat pose_format = io::PoseFormat::Standard;
   io_handler.loadPosesFromFile(pose_format, path_filename_poses, &T_G_Bs);
 
-  LOG(INFO) << "Loading images from file.";
-  size_t num_poses = T_G_Bs.size();
-  Images images;
-  io_handler.loadImagesFromFile(filename_images, num_poses, &images);
+  LOG(INFO) << "Streaming every n-th image from file.";
+  const size_t step = FLAGS_dense_pcl_use_every_nth_image;
+  io::ImageStream images(
+      io::ImageStream::getFilenames(filename_images, T_G_Bs.size(), step),
+      io::ImageStreamSettings());
+  Poses T_G_Bs_selected;
+  for (size_t i = step - 1u; i < T_G_Bs.size(); i += step) {
+    T_G_Bs_selected.push_back(T_G_Bs[i]);
+  }
 
   stereo::Settings settings_dense_pcl;
   settings_dense_pcl.use_every_nth_image = FLAGS_dense_pcl_use_every_nth_image;
   LOG(INFO) << "Perform dense reconstruction using planar rectification.";
   stereo::BlockMatchingParameters block_matching_params;
   block_matching_params.use_BM = FLAGS_use_BM;
+  block_matching_params.strip_height = FLAGS_strip_height;
+  block_matching_params.use_search_range_guidance =
+      FLAGS_use_search_range_guidance;
+  block_matching_params.guidance_pyramid_levels =
+      FLAGS_guidance_pyramid_levels;
   stereo::Stereo stereo(ncameras, settings_dense_pcl, block_matching_params);
   AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
-  stereo.addFrames(T_G_Bs, images, &point_cloud);
+  stereo.addFrames(T_G_Bs_selected, &images, &point_cloud);
 
   return 0;
 }
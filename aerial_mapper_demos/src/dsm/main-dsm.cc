@@ -9,6 +9,9 @@
 #include <aerial-mapper-dense-pcl/stereo.h>
 #include <aerial-mapper-dsm/dsm.h>
 #include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
+#include <aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-binary-point-cloud.h>
+#include <aerial-mapper-io/aerial-mapper-geotiff.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
 #include <gflags/gflags.h>
@@ -39,6 +42,25 @@ DEFINE_double(delta_easting, 0.0,
 DEFINE_double(delta_northing, 0.0,
               "Height [m] of the grid_map, starting from center");
 DEFINE_double(resolution, 1.0, "Resolution of the grid_map [m].");
+DEFINE_bool(use_grid_accumulation, false,
+            "Compute the DSM by accumulating the points per cell instead of "
+            "interpolating every cell with a kd-tree radius search.");
+DEFINE_string(tiled_map_filename, "",
+              "If not empty, compute the DSM out-of-core in a tiled map that "
+              "is backed by this file, instead of an in-memory grid_map.");
+DEFINE_int32(tiled_map_max_tiles_in_memory, 16,
+             "Number of tiles of the tiled map that are kept in memory.");
+DEFINE_string(dsm_geotiff_filename, "",
+              "Name of the GeoTIFF the elevation is exported to. Required for "
+              "the tiled map, optional otherwise.");
+DEFINE_int32(utm_zone, 32,
+             "UTM zone (northern hemisphere) of the grid_map coordinates.");
+DEFINE_double(downsampling_bin_size_ratio, 0.0,
+              "Reduce the points to one per bin of this fraction of the "
+              "resolution before building the kd-tree. 0 keeps all points.");
+DEFINE_bool(dense_pcl_fuse_to_grid, false,
+            "Fuse the point clouds of all stereo pairs into a height grid of "
+            "the grid_map resolution instead of concatenating them.");
 DEFINE_bool(use_BM, true,
             "Use BM Blockmatching if true. Use SGBM (=Semi-Global-) "
             "Blockmatching if false.");
@@ -75,14 +97,26 @@ int main(int argc, char** argv) {
 
   // Retrieve dense point cloud.
   AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
+  io::BinaryPointCloud binary_point_cloud;
   if (!FLAGS_filename_point_cloud.empty()) {
     // Either load point cloud from file..
-    io_handler.loadPointCloudFromFile(FLAGS_filename_point_cloud, &point_cloud);
+    if (FLAGS_tiled_map_filename.empty() &&
+        io::BinaryPointCloud::isBinaryPointCloudFile(
+            FLAGS_filename_point_cloud)) {
+      // The DSM reads the memory-mapped points in place.
+      CHECK(binary_point_cloud.open(FLAGS_filename_point_cloud));
+    } else {
+      io_handler.loadPointCloudFromFile(FLAGS_filename_point_cloud,
+                                        &point_cloud);
+    }
   } else {
     // .. or generate via dense reconstruction from poses and images.
     stereo::Settings settings_dense_pcl;
     settings_dense_pcl.use_every_nth_image =
         FLAGS_dense_pcl_use_every_nth_image;
+    if (FLAGS_dense_pcl_fuse_to_grid) {
+      settings_dense_pcl.fusion.cell_size_m = FLAGS_resolution;
+    }
     LOG(INFO) << "Perform dense reconstruction using planar rectification.";
     stereo::BlockMatchingParameters block_matching_params;
     block_matching_params.use_BM = FLAGS_use_BM;
@@ -90,6 +124,39 @@ int main(int argc, char** argv) {
     stereo.addFrames(T_G_Bs, images, &point_cloud);
   }
 
+  dsm::Settings settings_dsm;
+  settings_dsm.center_easting = FLAGS_center_easting;
+  settings_dsm.center_northing = FLAGS_center_northing;
+  settings_dsm.use_grid_accumulation = FLAGS_use_grid_accumulation;
+  settings_dsm.downsampling_bin_size_ratio = FLAGS_downsampling_bin_size_ratio;
+
+  if (!FLAGS_tiled_map_filename.empty()) {
+    LOG(INFO) << "Create DSM (batch, tiled).";
+    grid_map::TiledGridMapSettings settings_tiled_map;
+    settings_tiled_map.center_easting = FLAGS_center_easting;
+    settings_tiled_map.center_northing = FLAGS_center_northing;
+    settings_tiled_map.delta_easting = FLAGS_delta_easting;
+    settings_tiled_map.delta_northing = FLAGS_delta_northing;
+    settings_tiled_map.resolution = FLAGS_resolution;
+    settings_tiled_map.max_tiles_in_memory =
+        FLAGS_tiled_map_max_tiles_in_memory;
+    settings_tiled_map.filename = FLAGS_tiled_map_filename;
+    settings_tiled_map.layers = {"elevation"};
+    // The backing file is only scratch space, the result is the GeoTIFF.
+    CHECK(!FLAGS_dsm_geotiff_filename.empty())
+        << "The tiled DSM is exported to --dsm_geotiff_filename.";
+    grid_map::TiledGridMap tiled_map(settings_tiled_map);
+    dsm::Dsm digital_surface_map(settings_dsm);
+    digital_surface_map.process(point_cloud, &tiled_map);
+    io::GeoTiffSettings settings_geotiff;
+    settings_geotiff.utm_zone = FLAGS_utm_zone;
+    io::writeTiledGridMapToGeoTiff(&tiled_map, {"elevation"},
+                                   io::GeoTiffPixelType::kFloat32,
+                                   FLAGS_dsm_geotiff_filename,
+                                   settings_geotiff);
+    return 0;
+  }
+
   LOG(INFO) << "Initialize layered map.";
   grid_map::Settings settings_aerial_grid_map;
   settings_aerial_grid_map.center_easting = FLAGS_center_easting;
@@ -100,11 +167,22 @@ int main(int argc, char** argv) {
   grid_map::AerialGridMap map(settings_aerial_grid_map);
 
   LOG(INFO) << "Create DSM (batch).";
-  dsm::Settings settings_dsm;
-  settings_dsm.center_easting = settings_aerial_grid_map.center_easting;
-  settings_dsm.center_northing = settings_aerial_grid_map.center_northing;
   dsm::Dsm digital_surface_map(settings_dsm, map.getMutable());
-  digital_surface_map.process(point_cloud, map.getMutable());
+  if (binary_point_cloud.isOpen()) {
+    digital_surface_map.process(binary_point_cloud.getPoints(),
+                                binary_point_cloud.getOrigin(),
+                                map.getMutable());
+  } else {
+    digital_surface_map.process(point_cloud, map.getMutable());
+  }
+
+  if (!FLAGS_dsm_geotiff_filename.empty()) {
+    io::GeoTiffSettings settings_geotiff;
+    settings_geotiff.utm_zone = FLAGS_utm_zone;
+    io::writeGridMapToGeoTiff(*map.getMutable(), {"elevation"},
+                              io::GeoTiffPixelType::kFloat32,
+                              FLAGS_dsm_geotiff_filename, settings_geotiff);
+  }
 
   LOG(INFO) << "Publish until shutdown.";
   map.publishUntilShutdown();
@@ -12,8 +12,11 @@
 #include <aerial-mapper-dense-pcl/stereo.h>
 #include <aerial-mapper-dsm/dsm.h>
 #include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
+#include <aerial-mapper-io/aerial-mapper-web-tiles.h>
 #include <aerial-mapper-ortho/ortho-backward-grid.h>
+#include <aerial-mapper-pipeline/pipeline.h>
 #include <gflags/gflags.h>
 #include <ros/ros.h>
 
@@ -57,9 +60,28 @@ DEFINE_bool(backward_grid_colored_ortho, false,
             "Generate a colored (RGB) orthomosaic? Otherwise: grayscale.");
 DEFINE_bool(backward_grid_use_multi_threads, false,
             "Use multi threads for orthomosaic generation?");
+DEFINE_double(backward_grid_max_publish_rate_hz, 1.0,
+              "Maximum rate [Hz] at which map updates are published.");
+DEFINE_string(backward_grid_web_tiles_directory, "",
+              "Directory of the web map tile pyramid that is updated after "
+              "every processed batch. Not exported if empty.");
+DEFINE_int32(backward_grid_utm_zone, 32,
+             "UTM zone (northern hemisphere) of the grid_map coordinates.");
+DEFINE_int32(pipeline_queue_capacity, 2,
+             "Number of batches that are buffered between two pipeline "
+             "stages.");
 DEFINE_bool(use_BM, true,
             "Use BM Blockmatching if true. Use SGBM (=Semi-Global-) "
             "Blockmatching if false.");
+DEFINE_int32(strip_height, 0,
+             "Match the rectified pairs in horizontal strips of this height "
+             "[pixels] in parallel. 0 matches the whole image at once.");
+DEFINE_bool(use_search_range_guidance, false,
+            "Search only the disparities expected in every band of rows? "
+            "May miss disparities outside of the expected ones.");
+DEFINE_int32(guidance_pyramid_levels, 2,
+             "Pyramid levels of the downsampled pair that estimates the "
+             "expected disparities if the terrain height is unknown.");
 
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
@@ -89,11 +111,12 @@ int main(int argc, char** argv) {
   io::PoseFormat pose_format = io::PoseFormat::Standard;
   io_handler.loadPosesFromFile(pose_format, path_filename_poses, &T_G_Bs);
 
-  // Load images from file.
-  size_t num_poses = T_G_Bs.size();
-  Images images;
-  io_handler.loadImagesFromFile(filename_images, num_poses, &images,
-                                FLAGS_backward_grid_colored_ortho);
+  // Stream images from file.
+  io::ImageStreamSettings settings_image_stream;
+  settings_image_stream.load_colored_images = FLAGS_backward_grid_colored_ortho;
+  io::ImageStream images(
+      io::ImageStream::getFilenames(filename_images, T_G_Bs.size()),
+      settings_image_stream);
 
   // Set up layered map (grid_map).
   grid_map::Settings settings_aerial_grid_map;
@@ -103,6 +126,11 @@ int main(int argc, char** argv) {
   settings_aerial_grid_map.delta_easting = FLAGS_backward_grid_delta_easting;
   settings_aerial_grid_map.delta_northing = FLAGS_backward_grid_delta_northing;
   settings_aerial_grid_map.resolution = FLAGS_backward_grid_resolution;
+  settings_aerial_grid_map.published_layers = {"elevation"};
+  settings_aerial_grid_map.published_layers.push_back(
+      FLAGS_backward_grid_colored_ortho ? "colored_ortho" : "ortho");
+  settings_aerial_grid_map.max_publish_rate_hz =
+      FLAGS_backward_grid_max_publish_rate_hz;
   grid_map::AerialGridMap map(settings_aerial_grid_map);
 
   // Set up dense reconstruction.
@@ -111,12 +139,18 @@ int main(int argc, char** argv) {
   LOG(INFO) << "Perform dense reconstruction using planar rectification.";
   stereo::BlockMatchingParameters block_matching_params;
   block_matching_params.use_BM = FLAGS_use_BM;
+  block_matching_params.strip_height = FLAGS_strip_height;
+  block_matching_params.use_search_range_guidance =
+      FLAGS_use_search_range_guidance;
+  block_matching_params.guidance_pyramid_levels =
+      FLAGS_guidance_pyramid_levels;
   stereo::Stereo stereo(ncameras, settings_dense_pcl, block_matching_params);
 
   // Set up digital surface map.
   dsm::Settings settings_dsm;
   settings_dsm.center_easting = settings_aerial_grid_map.center_easting;
   settings_dsm.center_northing = settings_aerial_grid_map.center_northing;
+  settings_dsm.incremental = true;
   dsm::Dsm digital_surface_map(settings_dsm, map.getMutable());
 
   // Set up orthomosaic.
@@ -135,35 +169,26 @@ int main(int argc, char** argv) {
   settings_ortho.use_multi_threads = FLAGS_backward_grid_use_multi_threads;
   ortho::OrthoBackwardGrid mosaic(ncameras, settings_ortho, map.getMutable());
 
-  // Run all modules incrementally.
-  Images images_subset;
-  Poses T_G_Bs_subset;
-  size_t skip = 0u;
-  size_t pcl_cnt = 0;
-  for (size_t i = 0u; i < images.size(); ++i) {
-    images_subset.push_back(images[i]);
-    T_G_Bs_subset.push_back(T_G_Bs[i]);
-    if (++skip % FLAGS_dense_pcl_use_every_nth_image == 0) {
-      LOG(INFO) << "Processing image " << i << " of " << images.size();
-      AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
-      stereo.addFrame(T_G_Bs[i], images[i], &point_cloud);
-
-      if (pcl_cnt > 0) {
-        LOG(INFO) << "Filling DSM with " << point_cloud.size() << " points";
-        digital_surface_map.process(point_cloud, map.getMutable());
-
-        LOG(INFO) << "Updating orthomosaic layer with " << T_G_Bs_subset.size()
-                  << " image-pose-pairs";
-        mosaic.process(T_G_Bs_subset, images_subset, map.getMutable());
-
-        LOG(INFO) << "Publishing";
-        map.publishOnce();
-        images_subset.clear();
-        T_G_Bs_subset.clear();
-      }
-      ++pcl_cnt;
-    }
+  // Set up web map tile export.
+  std::unique_ptr<io::WebTileExporter> web_tiles;
+  if (!FLAGS_backward_grid_web_tiles_directory.empty()) {
+    io::WebTilesSettings settings_web_tiles;
+    settings_web_tiles.directory = FLAGS_backward_grid_web_tiles_directory;
+    settings_web_tiles.utm_zone = FLAGS_backward_grid_utm_zone;
+    web_tiles.reset(
+        new io::WebTileExporter(*map.getMutable(), settings_web_tiles));
   }
 
+  // Run all modules incrementally, each stage on its own thread.
+  pipeline::Settings settings_pipeline;
+  settings_pipeline.queue_capacity = FLAGS_pipeline_queue_capacity;
+  settings_pipeline.use_every_nth_image = FLAGS_dense_pcl_use_every_nth_image;
+  pipeline::Pipeline mapping_pipeline(settings_pipeline, &stereo,
+                                      &digital_surface_map, &mosaic, &map,
+                                      web_tiles.get());
+  mapping_pipeline.process(T_G_Bs, &images);
+
+  map.stopPublishing();
+
   return 0;
 }
@@ -12,6 +12,9 @@
 #include <aerial-mapper-dense-pcl/stereo.h>
 #include <aerial-mapper-dsm/dsm.h>
 #include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
+#include <aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-geotiff.h>
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <aerial-mapper-ortho/ortho-backward-grid.h>
 #include <gflags/gflags.h>
@@ -47,6 +50,20 @@ DEFINE_double(backward_grid_orthomosaic_elevation_m, 0.0,
 DEFINE_bool(backward_grid_use_digital_elevation_map, true,
             "Use the digital elevation map for generating the orthomosaic? "
             "Otherwise use flat ground assumption.");
+DEFINE_string(backward_grid_orthomosaic_geotiff_filename, "",
+              "Name of the GeoTIFF the orthomosaic is exported to. Not "
+              "exported if empty.");
+DEFINE_int32(backward_grid_utm_zone, 32,
+             "UTM zone (northern hemisphere) of the grid_map coordinates.");
+DEFINE_bool(backward_grid_use_reduced_resolution_images, true,
+            "Decode the images at the reduced resolution that matches the "
+            "resolution of the grid_map?");
+DEFINE_string(backward_grid_tiled_map_filename, "",
+              "If not empty, compute the DSM and the orthomosaic out-of-core "
+              "in a tiled map that is backed by this file, instead of an "
+              "in-memory grid_map. Requires an orthomosaic GeoTIFF filename.");
+DEFINE_int32(backward_grid_tiled_map_max_tiles_in_memory, 16,
+             "Number of tiles of the tiled map that are kept in memory.");
 DEFINE_string(point_cloud_filename, "",
               "Name of the file that contains the point cloud. If string is "
               "empty, the point cloud is generated from the provided images, "
@@ -91,11 +108,6 @@ int main(int argc, char** argv) {
   io::PoseFormat pose_format = io::PoseFormat::Standard;
   io_handler.loadPosesFromFile(pose_format, path_filename_poses, &T_G_Bs);
 
-  // Load images from file.
-  size_t num_poses = T_G_Bs.size();
-  Images images;
-  io_handler.loadImagesFromFile(filename_images, num_poses, &images);
-
   // Retrieve dense point cloud.
   AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
   if (FLAGS_load_point_cloud_from_file) {
@@ -111,7 +123,56 @@ int main(int argc, char** argv) {
     stereo::BlockMatchingParameters block_matching_params;
     block_matching_params.use_BM = FLAGS_use_BM;
     stereo::Stereo stereo(ncameras, settings_dense_pcl, block_matching_params);
-    stereo.addFrames(T_G_Bs, images, &point_cloud);
+    const size_t step = FLAGS_dense_pcl_use_every_nth_image;
+    io::ImageStream images(
+        io::ImageStream::getFilenames(filename_images, T_G_Bs.size(), step),
+        io::ImageStreamSettings());
+    Poses T_G_Bs_selected;
+    for (size_t i = step - 1u; i < T_G_Bs.size(); i += step) {
+      T_G_Bs_selected.push_back(T_G_Bs[i]);
+    }
+    stereo.addFrames(T_G_Bs_selected, &images, &point_cloud);
+  }
+
+  if (!FLAGS_backward_grid_tiled_map_filename.empty()) {
+    // The backing file is only scratch space, the result is the GeoTIFF.
+    CHECK(!FLAGS_backward_grid_orthomosaic_geotiff_filename.empty())
+        << "The tiled orthomosaic is exported to "
+        << "--backward_grid_orthomosaic_geotiff_filename.";
+    LOG(INFO) << "Initialize tiled map.";
+    grid_map::TiledGridMapSettings settings_tiled_map;
+    settings_tiled_map.center_easting = FLAGS_backward_grid_center_easting;
+    settings_tiled_map.center_northing = FLAGS_backward_grid_center_northing;
+    settings_tiled_map.delta_easting = FLAGS_backward_grid_delta_easting;
+    settings_tiled_map.delta_northing = FLAGS_backward_grid_delta_northing;
+    settings_tiled_map.resolution = FLAGS_backward_grid_resolution;
+    settings_tiled_map.max_tiles_in_memory =
+        FLAGS_backward_grid_tiled_map_max_tiles_in_memory;
+    settings_tiled_map.filename = FLAGS_backward_grid_tiled_map_filename;
+    grid_map::TiledGridMap tiled_map(settings_tiled_map);
+
+    LOG(INFO) << "Create DSM (batch, tiled).";
+    dsm::Settings settings_dsm;
+    settings_dsm.center_easting = settings_tiled_map.center_easting;
+    settings_dsm.center_northing = settings_tiled_map.center_northing;
+    dsm::Dsm digital_surface_map(settings_dsm);
+    digital_surface_map.process(point_cloud, &tiled_map);
+
+    LOG(INFO) << "Construct the orthomosaic (batch, tiled).";
+    ortho::Settings settings_ortho;
+    parseSettingsOrtho(&settings_ortho);
+    ortho::OrthoBackwardGrid mosaic(ncameras, settings_ortho);
+    // Every tile is rendered from all images, so they are held in memory.
+    Images images;
+    io_handler.loadImagesFromFile(filename_images, T_G_Bs.size(), &images);
+    mosaic.process(T_G_Bs, images, &tiled_map);
+
+    io::GeoTiffSettings settings_geotiff;
+    settings_geotiff.utm_zone = FLAGS_backward_grid_utm_zone;
+    io::writeTiledGridMapToGeoTiff(
+        &tiled_map, {"ortho"}, io::GeoTiffPixelType::kByte,
+        FLAGS_backward_grid_orthomosaic_geotiff_filename, settings_geotiff);
+    return 0;
   }
 
   LOG(INFO) << "Initialize layered map.";
@@ -137,7 +198,23 @@ int main(int argc, char** argv) {
   ortho::OrthoBackwardGrid mosaic(ncameras, settings_ortho, map.getMutable());
   // Orthomosaic via back-projecting cell center into image
   // and quering pixel intensity in image.
-  mosaic.process(T_G_Bs, images, map.getMutable());
+  io::ImageStreamSettings settings_image_stream;
+  if (FLAGS_backward_grid_use_reduced_resolution_images) {
+    settings_image_stream.reduction_factor =
+        mosaic.computeImageReductionFactor(T_G_Bs, *map.getMutable());
+  }
+  io::ImageStream images(
+      io::ImageStream::getFilenames(filename_images, T_G_Bs.size()),
+      settings_image_stream);
+  mosaic.process(T_G_Bs, &images, map.getMutable());
+
+  if (!FLAGS_backward_grid_orthomosaic_geotiff_filename.empty()) {
+    io::GeoTiffSettings settings_geotiff;
+    settings_geotiff.utm_zone = FLAGS_backward_grid_utm_zone;
+    io::writeGridMapToGeoTiff(
+        *map.getMutable(), {"ortho"}, io::GeoTiffPixelType::kByte,
+        FLAGS_backward_grid_orthomosaic_geotiff_filename, settings_geotiff);
+  }
 
   LOG(INFO) << "Publish until shutdown.";
   map.publishUntilShutdown();
@@ -9,6 +9,7 @@
 #include <memory>
 
 // NON-SYSTEM
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <aerial-mapper-ortho/ortho-forward-homography.h>
 #include <gflags/gflags.h>
@@ -70,10 +71,10 @@ int main(int argc, char** argv) {
   io::PoseFormat pose_format = io::PoseFormat::Standard;
   io_handler.loadPosesFromFile(pose_format, path_filename_poses, &T_G_Bs);
 
-  // Load images from file.
-  size_t num_poses = T_G_Bs.size();
-  Images images;
-  io_handler.loadImagesFromFile(filename_images, num_poses, &images);
+  // Stream the images from file.
+  io::ImageStream images(
+      io::ImageStream::getFilenames(filename_images, T_G_Bs.size()),
+      io::ImageStreamSettings());
 
   // Construct the mosaic by computing the homography that projects
   // the image onto the ground plane.
@@ -89,16 +90,15 @@ int main(int argc, char** argv) {
   CHECK(ncameras);
   ortho::OrthoForwardHomography mosaic(ncameras, settings_ortho);
   if (!FLAGS_forward_homography_batch) {
-    for (size_t i = 0u; i < images.size(); ++i) {
+    Image image;
+    for (size_t i = 0u; images.next(&image); ++i) {
       LOG(INFO) << i << "/" << images.size();
-      CHECK(i < images.size());
-      const Image& image = images[i];
       CHECK(i < T_G_Bs.size());
       const Pose& T_G_B = T_G_Bs[i];
       mosaic.updateOrthomosaic(T_G_B, image);
     }
   } else {
-    mosaic.batch(T_G_Bs, images);
+    mosaic.batch(T_G_Bs, &images);
   }
 
   return 0;
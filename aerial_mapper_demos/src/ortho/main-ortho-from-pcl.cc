@@ -8,6 +8,7 @@
 // NON-SYSTEM
 #include <aerial-mapper-dense-pcl/stereo.h>
 #include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-binary-point-cloud.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <aerial-mapper-ortho/ortho-from-pcl.h>
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
@@ -53,6 +54,9 @@ DEFINE_string(filename_point_cloud, "",
               "Name of the file that contains the point cloud.");
 DEFINE_int32(dense_pcl_use_every_nth_image, 10,
              "Only use every n-th image in the densification process.");
+DEFINE_double(ortho_from_pcl_downsampling_bin_size_ratio, 0.0,
+              "Reduce the points to one per bin of this fraction of the "
+              "resolution before building the kd-tree. 0 keeps all points.");
 DEFINE_bool(use_BM, true,
             "Use BM Blockmatching if true. Use SGBM (=Semi-Global-) "
             "Blockmatching if false.");
@@ -92,11 +96,20 @@ int main(int argc, char** argv) {
   // Retrieve dense point cloud.
   AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
   std::vector<int> point_cloud_intensities;
+  io::BinaryPointCloud binary_point_cloud;
   if (FLAGS_load_point_cloud_from_file) {
     // Either load point cloud from file..
     CHECK(!FLAGS_filename_point_cloud.empty());
-    io_handler.loadPointCloudFromFile(FLAGS_filename_point_cloud, &point_cloud,
-                                      &point_cloud_intensities);
+    if (io::BinaryPointCloud::isBinaryPointCloudFile(
+            FLAGS_filename_point_cloud)) {
+      // The orthomosaic is generated from the memory-mapped points in place.
+      CHECK(binary_point_cloud.open(FLAGS_filename_point_cloud));
+      CHECK(binary_point_cloud.getIntensities() != nullptr)
+          << "The binary point cloud has no intensities.";
+    } else {
+      io_handler.loadPointCloudFromFile(FLAGS_filename_point_cloud,
+                                        &point_cloud, &point_cloud_intensities);
+    }
   } else {
     // .. or generate via dense reconstruction from poses and images.
     stereo::Settings settings_dense_pcl;
@@ -128,12 +141,20 @@ int main(int argc, char** argv) {
       FLAGS_ortho_from_pcl_show_orthomosaic_opencv;
   settings.orthomosaic_jpg_filename =
       FLAGS_ortho_from_pcl_orthomosaic_jpg_filename;
-  CHECK(point_cloud.size() > 0);
-  CHECK(point_cloud.size() == point_cloud_intensities.size());
+  settings.downsampling_bin_size_ratio =
+      FLAGS_ortho_from_pcl_downsampling_bin_size_ratio;
 
   // Generate the orthomosaic from the point cloud.
   ortho::OrthoFromPcl mosaic(settings);
-  mosaic.process(point_cloud, point_cloud_intensities, map.getMutable());
+  if (binary_point_cloud.isOpen()) {
+    mosaic.process(binary_point_cloud.getPoints(),
+                   binary_point_cloud.getOrigin(),
+                   binary_point_cloud.getIntensities(), map.getMutable());
+  } else {
+    CHECK(point_cloud.size() > 0);
+    CHECK(point_cloud.size() == point_cloud_intensities.size());
+    mosaic.process(point_cloud, point_cloud_intensities, map.getMutable());
+  }
 
   LOG(INFO) << "Publish until shutdown.";
   map.publishUntilShutdown();
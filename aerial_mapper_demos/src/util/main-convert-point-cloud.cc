@@ -0,0 +1,31 @@
+/*
+ *    Filename: main-convert-point-cloud.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// NON-SYSTEM
+#include <aerial-mapper-io/aerial-mapper-io.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+DEFINE_string(util_filename_point_cloud, "",
+              "Name of the text file that contains the point cloud, one "
+              "'x y z intensity' per line.");
+DEFINE_string(util_filename_binary_point_cloud, "",
+              "Name of the binary point cloud file to be written.");
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InstallFailureSignalHandler();
+
+  CHECK(!FLAGS_util_filename_point_cloud.empty());
+  CHECK(!FLAGS_util_filename_binary_point_cloud.empty());
+  io::AerialMapperIO io_handler;
+  io_handler.convertPointCloudToBinary(FLAGS_util_filename_point_cloud,
+                                       FLAGS_util_filename_binary_point_cloud);
+
+  return 0;
+}
@@ -8,7 +8,12 @@
 #ifndef BLOCK_MATCHING_BASE_H_
 #define BLOCK_MATCHING_BASE_H_
 
+// SYSTEM
+#include <mutex>
+#include <vector>
+
 // NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
 #include <Eigen/Core>
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -19,16 +24,84 @@
 
 namespace stereo {
 
-/// Base class for blockmatching methods.
+/// Base class for blockmatching methods. If a strip height is set, the
+/// rectified pair is matched in overlapping horizontal strips, in parallel if
+/// a thread pool is given. Only the rows of a strip without the overlap are
+/// kept. The overlap only limits the deviation at the strip borders: the SGBM
+/// paths and the speckle filter are strip-local, so the result is not
+/// identical to matching the whole image. Every strip in flight uses its own
+/// matcher and buffers, which bounds the memory by the strip size.
+///
+/// With search range guidance, every strip searches only the disparities
+/// expected in its rows. Since the matching cost is linear in the number of
+/// disparities, this speeds up the matching of flat terrain. The expected
+/// disparities are taken from the rectified pair (see DisparityRangePredictor)
+/// or estimated by matching a downsampled pair over the configured range.
 class BlockMatchingBase {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  BlockMatchingBase() {}
+  BlockMatchingBase(const BlockMatchingParameters& block_matching_params,
+                    utils::ThreadPool* thread_pool);
+
+  virtual ~BlockMatchingBase() {}
+
+  /// Disparity map (CV_32FC1) in pixels. Pixels outside of the rectification
+  /// mask are set to kMaxInvalidDisparity.
+  void computeDisparityMap(const RectifiedStereoPair& rectified_stereo_pair,
+                           DensifiedStereoPair* densified_stereo_pair) const;
+
+ protected:
+  /// Creates a configured OpenCV matcher.
+  virtual cv::Ptr<cv::StereoMatcher> createMatcher() const = 0;
+
+ private:
+  /// Takes an idle matcher or creates a new one.
+  cv::Ptr<cv::StereoMatcher> acquireMatcher() const;
+  void releaseMatcher(const cv::Ptr<cv::StereoMatcher>& matcher) const;
+
+  /// Estimates the disparities of the bands with an empty range from the
+  /// disparity map of a downsampled pair.
+  void estimateDisparityBands(const RectifiedStereoPair& rectified_stereo_pair,
+                              int band_height,
+                              std::vector<DisparityRange>* bands) const;
+
+  /// Disparities searched for the rows [begin, end): all expected ones, or
+  /// the configured range if some are unknown.
+  DisparityRange getStripSearchRange(const std::vector<DisparityRange>& bands,
+                                     int band_height, int begin,
+                                     int end) const;
+
+  /// Matches the rows [match_begin, match_end) and writes the scaled and
+  /// masked disparities of the rows [begin, end) in one pass.
+  void computeStrip(const RectifiedStereoPair& rectified_stereo_pair,
+                    const DisparityRange& search_range, int match_begin,
+                    int match_end, int begin, int end,
+                    cv::Mat* disparity_map) const;
+
+  static constexpr int kMaxInvalidDisparity = 1;
+  // OpenCV returns fixed-point disparities with 4 fractional bits.
+  static constexpr float kDisparityScale = 1.0f / 16.0f;
+  // OpenCV requires the number of disparities to be divisible by 16.
+  static constexpr int kNumDisparitiesStep = 16;
+  // Quantiles of the disparities of a band of the downsampled pair that
+  // bound its expected range; ignores sparse mismatches.
+  static constexpr double kGuidanceLowerQuantile = 0.02;
+  static constexpr double kGuidanceUpperQuantile = 0.98;
+  // Minimum number of valid disparities of a band of the downsampled pair.
+  static constexpr size_t kMinGuidanceSamples = 32u;
+
+  const int strip_height_;
+  const int strip_overlap_;
+  const DisparityRange search_range_;
+  const bool use_search_range_guidance_;
+  const int guidance_band_height_;
+  const int guidance_pyramid_levels_;
+  const int guidance_disparity_margin_;
+  utils::ThreadPool* thread_pool_;
 
-  virtual void computeDisparityMap(
-      const RectifiedStereoPair& rectified_stereo_pair,
-      DensifiedStereoPair* densified_stereo_pair) const = 0;
+  mutable std::mutex matchers_mutex_;
+  mutable std::vector<cv::Ptr<cv::StereoMatcher> > matchers_;
 };
 
 }  // namespace stereo
@@ -25,26 +25,16 @@ class BlockMatchingBM : public BlockMatchingBase {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  BlockMatchingBM(const BlockMatchingParameters::BM& bm_params) {
-    bm_ = cv::StereoBM::create(0, 0);
-    bm_->setMinDisparity(bm_params.min_disparity);
-    bm_->setNumDisparities(bm_params.num_disparities);
-    bm_->setPreFilterCap(bm_params.pre_filter_cap);
-    bm_->setPreFilterCap(bm_params.pre_filter_size);
-    bm_->setUniquenessRatio(bm_params.uniqueness_ratio);
-    bm_->setTextureThreshold(bm_params.texture_threshold);
-    bm_->setSpeckleWindowSize(bm_params.speckle_window_size);
-    bm_->setSpeckleRange(bm_params.speckle_range);
-    bm_->setBlockSize(bm_params.block_size);
-  }
-
-  void computeDisparityMap(const RectifiedStereoPair& rectified_stereo_pair,
-                           DensifiedStereoPair* densified_stereo_pair) const;
+  BlockMatchingBM(const BlockMatchingParameters& block_matching_params,
+                  utils::ThreadPool* thread_pool = nullptr)
+      : BlockMatchingBase(block_matching_params, thread_pool),
+        bm_params_(block_matching_params.bm) {}
+
+ protected:
+  cv::Ptr<cv::StereoMatcher> createMatcher() const;
 
  private:
-  cv::Ptr<cv::StereoBM> bm_;
-  BlockMatchingParameters::BM bm_parameters_;
-  static constexpr int kMaxInvalidDisparity = 1;
+  const BlockMatchingParameters::BM bm_params_;
 };
 
 }  // namespace stereo
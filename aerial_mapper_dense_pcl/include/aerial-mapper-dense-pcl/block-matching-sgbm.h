@@ -25,27 +25,16 @@ class BlockMatchingSGBM : public BlockMatchingBase {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  BlockMatchingSGBM(const BlockMatchingParameters::SGBM& sgbm_params) {
-    sgbm_ = cv::StereoSGBM::create(0, 0, 0);
-    sgbm_->setMinDisparity(sgbm_params.min_disparity);
-    sgbm_->setNumDisparities(sgbm_params.num_disparities);
-    sgbm_->setPreFilterCap(sgbm_params.pre_filter_cap);
-    sgbm_->setUniquenessRatio(sgbm_params.uniqueness_ratio);
-    sgbm_->setSpeckleWindowSize(sgbm_params.speckle_window_size);
-    sgbm_->setSpeckleRange(sgbm_params.speckle_range);
-    sgbm_->setDisp12MaxDiff(sgbm_params.disp_12_max_diff);
-    sgbm_->setP1(sgbm_params.p1);
-    sgbm_->setP2(sgbm_params.p2);
-    sgbm_->setBlockSize(sgbm_params.block_size);
-  }
-
-  void computeDisparityMap(const RectifiedStereoPair& rectified_stereo_pair,
-                           DensifiedStereoPair* densified_stereo_pair) const;
+  BlockMatchingSGBM(const BlockMatchingParameters& block_matching_params,
+                    utils::ThreadPool* thread_pool = nullptr)
+      : BlockMatchingBase(block_matching_params, thread_pool),
+        sgbm_params_(block_matching_params.sgbm) {}
+
+ protected:
+  cv::Ptr<cv::StereoMatcher> createMatcher() const;
 
  private:
-  cv::Ptr<cv::StereoSGBM> sgbm_;
-  BlockMatchingParameters::SGBM sgbm_parameters_;
-  static constexpr int kMaxInvalidDisparity = 1;
+  const BlockMatchingParameters::SGBM sgbm_params_;
 };
 
 }  // namespace stereo
@@ -8,6 +8,9 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include <algorithm>
+#include <vector>
+
 #include <aslam/cameras/ncamera.h>
 #include <aslam/pipeline/undistorter.h>
 #include <aslam/pipeline/undistorter-mapped.h>
@@ -26,12 +29,24 @@
 
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
 
+#include "aerial-mapper-dense-pcl/height-grid-fusion.h"
+
 namespace stereo {
 
 struct Settings {
   size_t use_every_nth_image = 1;
   bool images_need_undistortion = false;
   bool show_rectification = true;
+  // The rectification maps of the previous pair are reused while the
+  // rectifying transforms move no pixel by more than this [pixels]. The pair
+  // is still triangulated with its own geometry, so a positive tolerance
+  // trades a small systematic error for speed. 0 only reuses identical maps.
+  double rectification_map_tolerance_px = 0.0;
+  // Number of worker threads, 0 uses all hardware threads.
+  int num_threads = 0;
+  // Fusion of the point clouds of all pairs by addFrames() into a height
+  // grid, disabled by default.
+  FusionSettings fusion;
 };
 
 struct StereoRigParameters {
@@ -61,6 +76,51 @@ struct StereoRigParameters {
   Eigen::Matrix4d T_2;
 };
 
+/// Two consecutive frames that are processed as a stereo pair.
+struct StereoFrame {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  /// Intrinsics and the poses of camera 1 (left) and camera 2 (right).
+  StereoRigParameters stereo_rig_params;
+  /// Raw grayscale (CV_8UC1) images of camera 1 and camera 2.
+  cv::Mat image_distorted_1;
+  cv::Mat image_distorted_2;
+};
+
+/// Disparities [min_disparity, min_disparity + num_disparities) [pixels].
+struct DisparityRange {
+  DisparityRange() : min_disparity(0), num_disparities(0) {}
+  DisparityRange(int min_disparity_, int num_disparities_)
+      : min_disparity(min_disparity_), num_disparities(num_disparities_) {}
+
+  inline bool isEmpty() const { return num_disparities <= 0; }
+
+  inline int getEnd() const { return min_disparity + num_disparities; }
+
+  /// Returns the disparities that are part of both ranges.
+  inline DisparityRange intersect(const DisparityRange& other) const {
+    const int begin = std::max(min_disparity, other.min_disparity);
+    const int end = std::min(getEnd(), other.getEnd());
+    return DisparityRange(begin, std::max(end - begin, 0));
+  }
+
+  /// Grows the range to cover both ranges.
+  inline void extend(const DisparityRange& other) {
+    if (other.isEmpty()) {
+      return;
+    }
+    if (isEmpty()) {
+      *this = other;
+      return;
+    }
+    const int end = std::max(getEnd(), other.getEnd());
+    min_disparity = std::min(min_disparity, other.min_disparity);
+    num_disparities = end - min_disparity;
+  }
+
+  int min_disparity;
+  int num_disparities;
+};
+
 struct RectifiedStereoPair {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   double baseline;
@@ -68,12 +128,19 @@ struct RectifiedStereoPair {
   cv::Mat mask;
   cv::Mat image_left;
   cv::Mat image_right;
+  /// Expected disparities of the rows [i * disparity_band_height,
+  /// (i + 1) * disparity_band_height) of the rectified images, an empty range
+  /// if unknown. Only the expected disparities are searched.
+  int disparity_band_height = 0;
+  std::vector<DisparityRange> disparity_bands;
 };
 
 struct DensifiedStereoPair {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   cv::Mat disparity_map;
-  cv::Mat_<cv::Vec3f> point_cloud;
+  /// Organized point cloud (CV_32FC4: x, y, z, rgb) that views the data of
+  /// the point cloud message, i.e. it is valid as long as the message is.
+  cv::Mat point_cloud;
   AlignedType<std::vector, Eigen::Vector3d>::type point_cloud_eigen;
   std::vector<int> point_cloud_intensities;
 };
@@ -82,6 +149,33 @@ struct BlockMatchingParameters {
   // Uses SGBM if "use_BM" is false.
   bool use_BM = false;
 
+  // The rectified pair is matched in horizontal strips of this height
+  // [pixels] in parallel. 0 matches the whole image at once. Strips change
+  // the disparity map (see strip_overlap), so they are opt-in.
+  int strip_height = 0;
+  // Rows that are matched in addition above and below every strip and then
+  // discarded [pixels]. The overlap only bounds the deviation from matching
+  // the whole image at the seams: SGBM aggregates its costs along paths
+  // across the whole image, and the speckle filter only sees the strip.
+  int strip_overlap = 32;
+
+  // Search range guidance: for every band of rows, only the disparities that
+  // are expected there are searched, within the configured range. They are
+  // predicted from the terrain height if known (see TerrainHeightPrior) and
+  // else estimated by matching a downsampled pair. Disparities outside of the
+  // expected ones, e.g. of thin or tall structures that the prediction
+  // misses, are not found, so guidance is opt-in.
+  bool use_search_range_guidance = false;
+  // Height of the bands [pixels].
+  int guidance_band_height = 64;
+  // Number of pyramid levels of the downsampled pair, 0 searches the
+  // configured range where the terrain height is unknown.
+  int guidance_pyramid_levels = 2;
+  // Added below and above every expected range [pixels].
+  int guidance_disparity_margin = 4;
+  // Added below and above the terrain height range of a band [m].
+  double guidance_height_margin_m = 10.0;
+
   struct SGBM {
     int min_disparity = 1;
     int num_disparities = 80;
@@ -109,6 +203,16 @@ struct BlockMatchingParameters {
   } bm;
 };
 
+/// Disparities searched by the configured block matching method.
+inline DisparityRange getSearchRange(
+    const BlockMatchingParameters& block_matching_params) {
+  return block_matching_params.use_BM
+             ? DisparityRange(block_matching_params.bm.min_disparity,
+                              block_matching_params.bm.num_disparities)
+             : DisparityRange(block_matching_params.sgbm.min_disparity,
+                              block_matching_params.sgbm.num_disparities);
+}
+
 typedef kindr::minimal::QuatTransformation Pose;
 typedef std::vector<Pose> Poses;
 typedef cv::Mat Image;
@@ -8,7 +8,12 @@
 #ifndef DENSIFIER_H_
 #define DENSIFIER_H_
 
+// SYSTEM
+#include <limits>
+#include <memory>
+
 // NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
 #include <Eigen/Core>
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -24,9 +29,17 @@ namespace stereo {
 class Densifier {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  /// The triangulation is distributed over the rows of the image on the
+  /// thread pool if one is given.
   Densifier(const BlockMatchingParameters& block_matching_params,
-            const cv::Size& image_dimension);
+            const cv::Size& image_dimension,
+            utils::ThreadPool* thread_pool = nullptr);
 
+  /// Triangulates the valid disparities. Writes the organized cloud in place
+  /// into the message (16 bytes per pixel, NaN for invalid pixels) and the
+  /// valid points into point_cloud_eigen and point_cloud_intensities, which
+  /// are allocated once: each row writes from the number of valid pixels in
+  /// the rows above.
   void computePointCloud(const StereoRigParameters& stereo_pair,
                          const RectifiedStereoPair& rectified_stereo_pair,
                          DensifiedStereoPair* densified_stereo_pair,
@@ -40,18 +53,20 @@ class Densifier {
   }
 
  private:
-  static constexpr int kPositionX = 0;
-  static constexpr int kPositionY = 4;
-  static constexpr int kPositionZ = 8;
-  static constexpr int kPositionIntensity = 12;
+  static inline bool isValidDisparity(float disparity) {
+    return disparity > kMaxInvalidDisparity &&
+           disparity < std::numeric_limits<float>::infinity();
+  }
+
+  // Layout of a point in the message: x, y, z (float) and rgb (uint32).
+  static constexpr size_t kPointStep = 16u;
   static constexpr float kInvalidPoint =
       std::numeric_limits<float>::quiet_NaN();
   static constexpr int kMaxInvalidDisparity = 1;
-  static constexpr size_t kSizeOfFloat = sizeof(float);
-  static constexpr size_t kSizeOfUint32T = sizeof(uint32_t);
 
   std::unique_ptr<BlockMatchingBase> block_matcher_;
   const cv::Size image_resolution_;
+  utils::ThreadPool* thread_pool_;
 };
 
 }  // namespace stereo
@@ -0,0 +1,68 @@
+/*
+ *    Filename: disparity-range-predictor.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef DISPARITY_RANGE_PREDICTOR_H_
+#define DISPARITY_RANGE_PREDICTOR_H_
+
+// NON-SYSTEM
+#include <Eigen/Core>
+
+#include "aerial-mapper-dense-pcl/common.h"
+
+namespace stereo {
+
+/// Height of the terrain that is mapped already, e.g. of the DSM.
+class TerrainHeightPrior {
+ public:
+  virtual ~TerrainHeightPrior() {}
+
+  /// Minimum and maximum terrain height within the box [min_xy, max_xy] of
+  /// the global/world frame. Returns false if nothing is mapped there. Called
+  /// concurrently by the densification threads.
+  virtual bool getHeightRange(const Eigen::Vector2d& min_xy,
+                              const Eigen::Vector2d& max_xy,
+                              double* min_height, double* max_height) const = 0;
+};
+
+/// Predicts the disparities of a rectified pair from the terrain height.
+/// The disparity of a rectified pixel (u, v) that sees the height h is
+///
+///   d = baseline * r_z / (h - t_z),   r = R_G_C * [u - cx, fx / fy *
+///                                                  (v - cy), fx]^T,
+///
+/// which is monotonic in h and, for a fixed h, in u and v. The disparities of
+/// a band of rows are therefore bounded by those of its corner pixels at the
+/// minimum and maximum terrain height below the band.
+class DisparityRangePredictor {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  explicit DisparityRangePredictor(
+      const BlockMatchingParameters& block_matching_params);
+
+  /// Sets the expected disparities of every band of the rectified pair. Bands
+  /// whose footprint is not mapped yet get an empty range.
+  void predict(const StereoRigParameters& stereo_rig_params,
+               const TerrainHeightPrior& terrain_height_prior,
+               RectifiedStereoPair* rectified_stereo_pair) const;
+
+ private:
+  /// Expected disparities of the rows [begin, end).
+  DisparityRange predictBand(const StereoRigParameters& stereo_rig_params,
+                             const RectifiedStereoPair& rectified_stereo_pair,
+                             const TerrainHeightPrior& terrain_height_prior,
+                             int begin, int end) const;
+
+  const DisparityRange search_range_;
+  const int band_height_;
+  const int disparity_margin_;
+  const double height_margin_m_;
+};
+
+}  // namespace stereo
+
+#endif  // DISPARITY_RANGE_PREDICTOR_H_
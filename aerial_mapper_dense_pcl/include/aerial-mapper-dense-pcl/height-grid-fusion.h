@@ -0,0 +1,123 @@
+/*
+ *    Filename: height-grid-fusion.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef HEIGHT_GRID_FUSION_H_
+#define HEIGHT_GRID_FUSION_H_
+
+// SYSTEM
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-nearest-neighbor.h>
+#include <Eigen/Core>
+
+namespace stereo {
+
+struct FusionSettings {
+  // Cell size of the height grid [m], e.g. the resolution of the DSM. 0
+  // disables the fusion: the points of all pairs are concatenated.
+  double cell_size_m = 0.0;
+  // A pair whose mean height in a cell deviates from the fused height by more
+  // than this number of standard deviations is an outlier there.
+  double max_deviation_sigma = 3.0;
+  // Lower bound of the standard deviation of the height in a cell [m], which
+  // keeps cells seen by few, consistent pairs from rejecting everything.
+  double min_sigma_m = 0.5;
+  // Cells seen by fewer pairs are not part of the fused point cloud.
+  size_t min_num_views = 1u;
+};
+
+/// Fuses the point clouds of many stereo pairs into a height grid. Every pair
+/// is first reduced to the mean and variance of the height per cell, which
+/// are then merged into the running mean and variance of the cell. Pairs that
+/// disagree with the fused height of a cell are collected in an alternative
+/// hypothesis, which replaces the fused height once more pairs support it. A
+/// cell thus holds the dominant surface, and the fused cloud has one point
+/// per cell no matter how often the cell is observed.
+///
+/// Pairs can be inserted concurrently: the cells are distributed over shards
+/// with separate locks. The fused heights depend on the order in which the
+/// pairs are inserted.
+class HeightGridFusion {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  explicit HeightGridFusion(const FusionSettings& settings);
+
+  /// Merges the points (and intensities, may be empty) of a stereo pair.
+  void insert(
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      const std::vector<int>& point_cloud_intensities);
+
+  /// One point per fused cell at the mean position of its surface, sorted by
+  /// cell. point_cloud_intensities may be nullptr.
+  void getPointCloud(
+      AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+      std::vector<int>* point_cloud_intensities) const;
+
+  void clear();
+
+  size_t getNumCells() const;
+
+ private:
+  /// Running statistics of the points of a surface in a cell.
+  struct Surface {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    uint32_t num_points = 0u;
+    uint32_t num_views = 0u;
+    Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+    // Sum of the squared deviations of the height from the mean.
+    double m2_height = 0.0;
+    double mean_intensity = 0.0;
+
+    inline double getHeightVariance() const {
+      return num_points > 0u ? m2_height / num_points : 0.0;
+    }
+
+    /// Combines the statistics (Chan et al.).
+    void merge(const Surface& other);
+  };
+
+  struct Cell {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    Surface fused;
+    Surface alternative;
+  };
+
+  typedef std::unordered_map<
+      uint64_t, Cell, std::hash<uint64_t>, std::equal_to<uint64_t>,
+      Eigen::aligned_allocator<std::pair<const uint64_t, Cell> > >
+      CellMap;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    CellMap cells;
+  };
+
+  uint64_t getCellKey(const Eigen::Vector3d& point) const;
+
+  inline size_t getShardIndex(uint64_t key) const {
+    // Scatters neighboring cells over the shards.
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) %
+           kNumShards;
+  }
+
+  /// Merges the surface of a pair into the cell.
+  void fuse(const Surface& view, Cell* cell) const;
+
+  static constexpr size_t kNumShards = 64u;
+
+  const FusionSettings settings_;
+  std::vector<Shard> shards_;
+};
+
+}  // namespace stereo
+
+#endif  // HEIGHT_GRID_FUSION_H_
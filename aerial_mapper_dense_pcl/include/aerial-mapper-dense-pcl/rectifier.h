@@ -9,6 +9,7 @@
 #define RECTIFIER_H_
 
 // NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
 #include <Eigen/Core>
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -22,17 +23,17 @@ class Rectifier {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  Rectifier(const cv::Size& image_resolution)
-      : image_resolution_(image_resolution) {
-    map_rectify_1_x_.create(image_resolution_.height, image_resolution_.width,
-                            CV_32FC1);
-    map_rectify_1_y_.create(image_resolution_.height, image_resolution_.width,
-                            CV_32FC1);
-    map_rectify_2_x_.create(image_resolution_.height, image_resolution_.width,
-                            CV_32FC1);
-    map_rectify_2_y_.create(image_resolution_.height, image_resolution_.width,
-                            CV_32FC1);
-
+  /// The remap tables of the previous pair are reused as long as the
+  /// rectifying transforms move no pixel by more than map_reuse_tolerance_px.
+  /// The tables are built on the thread pool if one is given.
+  Rectifier(const cv::Size& image_resolution,
+            double map_reuse_tolerance_px = 0.0,
+            utils::ThreadPool* thread_pool = nullptr)
+      : image_resolution_(image_resolution),
+        map_reuse_tolerance_px_(map_reuse_tolerance_px),
+        thread_pool_(thread_pool),
+        has_maps_(false) {
+    CHECK_GE(map_reuse_tolerance_px_, 0.0);
     corner_pixel_h_.resize(3, 4);
     corner_pixel_h_.col(0) << 0, 0, 1;
     corner_pixel_h_.col(1) << image_resolution_.width - 1, 0, 1;
@@ -48,12 +49,35 @@ class Rectifier {
 
   cv::Mat computeMask(const Eigen::Matrix3d& T1_rect) const;
 
-  cv::Mat map_rectify_1_x_, map_rectify_1_y_, map_rectify_2_x_,
-      map_rectify_2_y_;
-  float* map_rectify_1_x_ptr_, *map_rectify_1_y_ptr_, *map_rectify_2_x_ptr_,
-      *map_rectify_2_y_ptr_;
+  /// Fixed-point remap tables (CV_16SC2 integer positions, CV_16UC1
+  /// interpolation table indices) as produced by cv::convertMaps().
+  cv::Mat map_rectify_1_xy_, map_rectify_1_interpolation_,
+      map_rectify_2_xy_, map_rectify_2_interpolation_;
+  cv::Mat mask_;
   const cv::Size image_resolution_;
   Eigen::MatrixXd corner_pixel_h_;
+
+ private:
+  /// Rebuilds the remap tables and the mask unless the cached ones are
+  /// within the tolerance of the new rectifying transforms.
+  void updateMaps(const Eigen::Matrix3d& T1_rect,
+                  const Eigen::Matrix3d& T2_rect);
+
+  /// Samples the unrectified position T_rect^-1 * [u_rect, v_rect, 1]^T of
+  /// every rectified pixel directly in fixed point.
+  void buildMap(const Eigen::Matrix3d& T_rect, cv::Mat* map_xy,
+                cv::Mat* map_interpolation) const;
+
+  /// Largest distance between the unrectified positions of a rectified pixel
+  /// under the two transforms, sampled on a 3x3 grid over the image.
+  double computeMaxDisplacement(const Eigen::Matrix3d& T_rect_a,
+                                const Eigen::Matrix3d& T_rect_b) const;
+
+  const double map_reuse_tolerance_px_;
+  utils::ThreadPool* thread_pool_;
+  bool has_maps_;
+  Eigen::Matrix3d T1_rect_maps_;
+  Eigen::Matrix3d T2_rect_maps_;
 };
 
 }  // namespace stereo
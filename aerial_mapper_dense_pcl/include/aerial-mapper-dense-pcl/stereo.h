@@ -11,8 +11,12 @@
 // SYSTEM
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 // NON-SYSTEM
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
+#include <aerial-mapper-utils/utils-thread-pool.h>
 #include <aslam/cameras/ncamera.h>
 #include <aslam/pipeline/undistorter.h>
 #include <aslam/pipeline/undistorter-mapped.h>
@@ -34,6 +38,7 @@
 
 // PACKAGE
 #include "aerial-mapper-dense-pcl/densifier.h"
+#include "aerial-mapper-dense-pcl/disparity-range-predictor.h"
 #include "aerial-mapper-dense-pcl/rectifier.h"
 #include "aerial-mapper-dense-pcl/common.h"
 
@@ -46,18 +51,70 @@ class Stereo {
          const Settings& settings,
          const BlockMatchingParameters& block_matching_params);
 
+  /// Batch densification: the stereo pairs are formed up front and densified
+  /// in parallel, see densifyStereoFrames(). If fusion is enabled in the
+  /// settings, the result is the height grid fused from all pairs instead of
+  /// the concatenated points of the pairs.
   void addFrames(const Poses& T_G_Bs, const Images& images,
                  AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
                  std::vector<int>* point_cloud_intensities = nullptr);
 
+  /// Processes every image of the stream, T_G_Bs holds one pose per image.
+  /// Unlike the overload above, use_every_nth_image is not applied: create
+  /// the stream from the selected images only, e.g. with
+  /// io::ImageStream::getFilenames(..., use_every_nth_image). The pairs are
+  /// densified in parallel, a few pairs per thread at a time, so only these
+  /// images are held in memory.
+  void addFrames(const Poses& T_G_Bs, io::ImageStream* images,
+                 AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+                 std::vector<int>* point_cloud_intensities = nullptr);
+
   void addFrame(const Pose& T_G_B, const Image& image,
                 AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
                 std::vector<int>* point_cloud_intensities = nullptr);
 
+  /// Pairs the image with the previous one. Returns false for the first
+  /// image, which has no partner yet.
+  bool makeStereoFrame(const Pose& T_G_B, const Image& image,
+                       StereoFrame* stereo_frame);
+
   void processStereoFrame(
+      const StereoFrame& stereo_frame,
       AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
       std::vector<int>* point_cloud_intensities);
 
+  /// First half of processStereoFrame(): undistorts and rectifies the images.
+  /// Calls must not overlap, but may run concurrently with densifyStereoFrame()
+  /// on another frame, e.g. in separate pipeline stages.
+  void rectifyStereoFrame(const StereoFrame& stereo_frame,
+                          RectifiedStereoPair* rectified_stereo_pair);
+
+  /// Second half of processStereoFrame(): block matching, triangulation and
+  /// publication of the point cloud. Calls must not overlap.
+  void densifyStereoFrame(
+      const StereoFrame& stereo_frame,
+      const RectifiedStereoPair& rectified_stereo_pair,
+      AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+      std::vector<int>* point_cloud_intensities);
+
+  /// Densifies the stereo pairs in parallel and appends their points (and
+  /// intensities) to the point cloud, in the order of the pairs. Every pair in
+  /// flight has its own rectifier and densifier, so the result is the same as
+  /// processing the pairs one by one. The rectification is not visualized.
+  /// If fusion is enabled, the points are fused into the height grid instead,
+  /// also in the order of the pairs, and the point cloud is left unchanged.
+  void densifyStereoFrames(
+      const AlignedType<std::vector, StereoFrame>::type& stereo_frames,
+      AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+      std::vector<int>* point_cloud_intensities = nullptr);
+
+  /// Narrows the disparity search range of every rectified pair to the
+  /// disparities expected from the terrain height, if search range guidance
+  /// is enabled. The prior must outlive the stereo module, nullptr resets.
+  void setTerrainHeightPrior(const TerrainHeightPrior* terrain_height_prior) {
+    terrain_height_prior_ = terrain_height_prior;
+  }
+
   void undistortRawImages(const cv::Mat& image_distorted_1,
                           const cv::Mat& image_distorted_2,
                           cv::Mat* image_undistorted_1,
@@ -82,6 +139,7 @@ class Stereo {
   std::unique_ptr<Rectifier> rectifier_;
   std::unique_ptr<Densifier> densifier_;
   std::unique_ptr<aslam::MappedUndistorter> undistorter_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
 
   bool first_frame_;
 
@@ -90,7 +148,46 @@ class Stereo {
   Settings settings_;
   aslam::Transformation T_B_C_;
   cv::Mat image_distorted_1_;
-  cv::Mat image_distorted_2_;
+
+ private:
+  /// Scratch buffers of a stereo pair that is densified in parallel.
+  struct PairWorkspace {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    std::unique_ptr<Rectifier> rectifier;
+    std::unique_ptr<Densifier> densifier;
+    sensor_msgs::PointCloud2 point_cloud_ros_msg;
+  };
+
+  void initializePointCloudMessage(
+      sensor_msgs::PointCloud2* point_cloud_ros_msg) const;
+
+  /// Takes an idle workspace or creates a new one.
+  std::unique_ptr<PairWorkspace> acquireWorkspace();
+  void releaseWorkspace(std::unique_ptr<PairWorkspace> workspace);
+
+  void undistortAndRectify(const StereoFrame& stereo_frame,
+                           Rectifier* rectifier, cv::Mat* image_undistorted_1,
+                           cv::Mat* image_undistorted_2,
+                           RectifiedStereoPair* rectified_stereo_pair) const;
+
+  /// Block matching and triangulation. Fills the message for publication.
+  void triangulate(const StereoFrame& stereo_frame,
+                   const RectifiedStereoPair& rectified_stereo_pair,
+                   const Densifier& densifier,
+                   sensor_msgs::PointCloud2* point_cloud_ros_msg,
+                   DensifiedStereoPair* densified_stereo_pair) const;
+
+  /// Number of pairs per thread that addFrames() densifies together.
+  static constexpr size_t kPairsPerThread = 2u;
+
+  cv::Size image_resolution_;
+  BlockMatchingParameters block_matching_params_;
+  std::unique_ptr<DisparityRangePredictor> disparity_range_predictor_;
+  // Fuses the pairs of addFrames() if enabled, nullptr otherwise.
+  std::unique_ptr<HeightGridFusion> fusion_;
+  const TerrainHeightPrior* terrain_height_prior_ = nullptr;
+  std::mutex workspaces_mutex_;
+  std::vector<std::unique_ptr<PairWorkspace> > workspaces_;
 };
 
 }  // namespace stereo
@@ -0,0 +1,271 @@
+/*
+ *    Filename: block-matching-base.cpp
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-dense-pcl/block-matching-base.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace stereo {
+
+namespace {
+
+/// Rows matched beyond a strip: at least half a block, so that no block of a
+/// kept row is clipped by the border of the strip.
+int getStripOverlap(const BlockMatchingParameters& block_matching_params) {
+  const int block_size = block_matching_params.use_BM
+                             ? block_matching_params.bm.block_size
+                             : block_matching_params.sgbm.block_size;
+  return std::max(block_matching_params.strip_overlap, block_size / 2 + 1);
+}
+
+}  // namespace
+
+BlockMatchingBase::BlockMatchingBase(
+    const BlockMatchingParameters& block_matching_params,
+    utils::ThreadPool* thread_pool)
+    : strip_height_(block_matching_params.strip_height),
+      strip_overlap_(getStripOverlap(block_matching_params)),
+      search_range_(getSearchRange(block_matching_params)),
+      use_search_range_guidance_(
+          block_matching_params.use_search_range_guidance),
+      guidance_band_height_(block_matching_params.guidance_band_height),
+      guidance_pyramid_levels_(block_matching_params.guidance_pyramid_levels),
+      guidance_disparity_margin_(
+          block_matching_params.guidance_disparity_margin),
+      thread_pool_(thread_pool) {
+  CHECK_GE(strip_height_, 0);
+  CHECK(!search_range_.isEmpty());
+  CHECK_EQ(search_range_.num_disparities % kNumDisparitiesStep, 0);
+  CHECK_GT(guidance_band_height_, 0);
+  CHECK_GE(guidance_pyramid_levels_, 0);
+  CHECK_GE(guidance_disparity_margin_, 0);
+}
+
+void BlockMatchingBase::computeDisparityMap(
+    const RectifiedStereoPair& rectified_stereo_pair,
+    DensifiedStereoPair* densified_stereo_pair) const {
+  CHECK(densified_stereo_pair);
+  const cv::Mat& image_left = rectified_stereo_pair.image_left;
+  CHECK_EQ(image_left.size(), rectified_stereo_pair.image_right.size());
+  CHECK_EQ(image_left.size(), rectified_stereo_pair.mask.size());
+  CHECK_EQ(rectified_stereo_pair.mask.type(), CV_8UC1);
+  const int height = image_left.rows;
+  densified_stereo_pair->disparity_map.create(image_left.size(), CV_32FC1);
+
+  // Expected disparities of the bands of rows, none without guidance.
+  int band_height = 0;
+  std::vector<DisparityRange> bands;
+  if (use_search_range_guidance_) {
+    band_height = rectified_stereo_pair.disparity_band_height;
+    bands = rectified_stereo_pair.disparity_bands;
+    if (band_height <= 0 || bands.empty()) {
+      band_height = guidance_band_height_;
+      bands.assign((height + band_height - 1) / band_height, DisparityRange());
+    }
+    const bool has_unknown_bands =
+        std::any_of(bands.begin(), bands.end(),
+                    [](const DisparityRange& band) { return band.isEmpty(); });
+    if (has_unknown_bands && guidance_pyramid_levels_ > 0) {
+      estimateDisparityBands(rectified_stereo_pair, band_height, &bands);
+    }
+  }
+
+  const int strip_height =
+      (strip_height_ > 0) ? std::min(strip_height_, height) : height;
+  const int num_strips =
+      std::max(1, (height + strip_height - 1) / std::max(1, strip_height));
+  auto compute_strips = [&](size_t strip_begin, size_t strip_end) {
+    for (size_t strip = strip_begin; strip < strip_end; ++strip) {
+      const int begin = static_cast<int>(strip) * strip_height;
+      const int end = std::min(height, begin + strip_height);
+      const int match_begin = std::max(0, begin - strip_overlap_);
+      const int match_end = std::min(height, end + strip_overlap_);
+      computeStrip(rectified_stereo_pair,
+                   getStripSearchRange(bands, band_height, match_begin,
+                                       match_end),
+                   match_begin, match_end, begin, end,
+                   &densified_stereo_pair->disparity_map);
+    }
+  };
+  if (thread_pool_ && num_strips > 1) {
+    thread_pool_->parallelFor(num_strips, compute_strips, 1u);
+  } else {
+    compute_strips(0u, num_strips);
+  }
+}
+
+void BlockMatchingBase::estimateDisparityBands(
+    const RectifiedStereoPair& rectified_stereo_pair, int band_height,
+    std::vector<DisparityRange>* bands) const {
+  CHECK_NOTNULL(bands);
+  CHECK_GT(band_height, 0);
+  const int scale = 1 << guidance_pyramid_levels_;
+  cv::Mat image_left = rectified_stereo_pair.image_left;
+  cv::Mat image_right = rectified_stereo_pair.image_right;
+  for (int level = 0; level < guidance_pyramid_levels_; ++level) {
+    cv::Mat image_left_down, image_right_down;
+    cv::pyrDown(image_left, image_left_down);
+    cv::pyrDown(image_right, image_right_down);
+    image_left = image_left_down;
+    image_right = image_right_down;
+  }
+
+  // Match the downsampled pair over the downsampled configured range.
+  const int min_disparity_down = static_cast<int>(
+      std::floor(search_range_.min_disparity / static_cast<double>(scale)));
+  const int end_disparity_down = static_cast<int>(
+      std::ceil(search_range_.getEnd() / static_cast<double>(scale)));
+  const int num_disparities_down =
+      (end_disparity_down - min_disparity_down + kNumDisparitiesStep - 1) /
+      kNumDisparitiesStep * kNumDisparitiesStep;
+  cv::Mat disparity_map_down;
+  cv::Ptr<cv::StereoMatcher> matcher = acquireMatcher();
+  matcher->setMinDisparity(min_disparity_down);
+  matcher->setNumDisparities(num_disparities_down);
+  matcher->compute(image_left, image_right, disparity_map_down);
+  releaseMatcher(matcher);
+  CHECK_EQ(disparity_map_down.type(), CV_16SC1);
+
+  // The quantiles of the valid disparities within the rectification mask
+  // bound the range of a band.
+  const cv::Mat& mask = rectified_stereo_pair.mask;
+  const int16_t min_valid_disparity =
+      static_cast<int16_t>(min_disparity_down / kDisparityScale);
+  std::vector<int16_t> disparities;
+  for (size_t band = 0u; band < bands->size(); ++band) {
+    if (!(*bands)[band].isEmpty()) {
+      continue;
+    }
+    const int begin = static_cast<int>(band) * band_height;
+    const int end = std::min(mask.rows, begin + band_height);
+    disparities.clear();
+    for (int v = begin / scale;
+         v < std::min(disparity_map_down.rows, (end + scale - 1) / scale);
+         ++v) {
+      const int16_t* disparity_ptr = disparity_map_down.ptr<int16_t>(v);
+      const uchar* mask_ptr = mask.ptr<uchar>(std::min(v * scale, end - 1));
+      for (int u = 0; u < disparity_map_down.cols; ++u) {
+        if (disparity_ptr[u] >= min_valid_disparity &&
+            mask_ptr[std::min(u * scale, mask.cols - 1)]) {
+          disparities.push_back(disparity_ptr[u]);
+        }
+      }
+    }
+    if (disparities.size() < kMinGuidanceSamples) {
+      continue;
+    }
+    const size_t lower = static_cast<size_t>(kGuidanceLowerQuantile *
+                                             (disparities.size() - 1u));
+    const size_t upper = static_cast<size_t>(kGuidanceUpperQuantile *
+                                             (disparities.size() - 1u));
+    std::nth_element(disparities.begin(), disparities.begin() + lower,
+                     disparities.end());
+    const double min_disparity = disparities[lower] * kDisparityScale * scale;
+    std::nth_element(disparities.begin() + lower,
+                     disparities.begin() + upper, disparities.end());
+    const double max_disparity = disparities[upper] * kDisparityScale * scale;
+    // The downsampled disparities are accurate to about one pixel there.
+    const int margin = guidance_disparity_margin_ + scale;
+    const int begin_disparity =
+        static_cast<int>(std::floor(min_disparity)) - margin;
+    const int end_disparity =
+        static_cast<int>(std::ceil(max_disparity)) + margin + 1;
+    (*bands)[band] =
+        DisparityRange(begin_disparity, end_disparity - begin_disparity)
+            .intersect(search_range_);
+  }
+}
+
+DisparityRange BlockMatchingBase::getStripSearchRange(
+    const std::vector<DisparityRange>& bands, int band_height, int begin,
+    int end) const {
+  if (bands.empty()) {
+    return search_range_;
+  }
+  CHECK_GT(band_height, 0);
+  DisparityRange strip_range;
+  const int end_band =
+      std::min(static_cast<int>(bands.size()),
+               (end + band_height - 1) / band_height);
+  for (int band = begin / band_height; band < end_band; ++band) {
+    if (bands[band].isEmpty()) {
+      return search_range_;
+    }
+    strip_range.extend(bands[band]);
+  }
+  if (strip_range.isEmpty()) {
+    return search_range_;
+  }
+  strip_range.num_disparities =
+      (strip_range.num_disparities + kNumDisparitiesStep - 1) /
+      kNumDisparitiesStep * kNumDisparitiesStep;
+  return strip_range;
+}
+
+void BlockMatchingBase::computeStrip(
+    const RectifiedStereoPair& rectified_stereo_pair,
+    const DisparityRange& search_range, int match_begin, int match_end,
+    int begin, int end, cv::Mat* disparity_map) const {
+  CHECK_NOTNULL(disparity_map);
+  CHECK_LE(match_begin, begin);
+  CHECK_GE(match_end, end);
+
+  // Compute the disparity map of the strip, including the overlap.
+  cv::Mat disparity_map_strip;
+  cv::Ptr<cv::StereoMatcher> matcher = acquireMatcher();
+  matcher->setMinDisparity(search_range.min_disparity);
+  matcher->setNumDisparities(search_range.num_disparities);
+  matcher->compute(
+      rectified_stereo_pair.image_left.rowRange(match_begin, match_end),
+      rectified_stereo_pair.image_right.rowRange(match_begin, match_end),
+      disparity_map_strip);
+  releaseMatcher(matcher);
+  CHECK_EQ(disparity_map_strip.type(), CV_16SC1);
+
+  // Scale to pixels and apply the rectification mask in one pass. OpenCV
+  // marks unmatched pixels with min_disparity - 1, which is not necessarily
+  // below kMaxInvalidDisparity for a guided search range.
+  const float min_valid_disparity =
+      static_cast<float>(search_range.min_disparity);
+  const int width = disparity_map->cols;
+  for (int v = begin; v < end; ++v) {
+    const int16_t* disparity_strip_ptr =
+        disparity_map_strip.ptr<int16_t>(v - match_begin);
+    const uchar* mask_ptr = rectified_stereo_pair.mask.ptr<uchar>(v);
+    float* disparity_ptr = disparity_map->ptr<float>(v);
+    for (int u = 0; u < width; ++u) {
+      const float disparity = disparity_strip_ptr[u] * kDisparityScale;
+      disparity_ptr[u] = (mask_ptr[u] && disparity >= min_valid_disparity)
+                             ? disparity
+                             : static_cast<float>(kMaxInvalidDisparity);
+    }
+  }
+}
+
+cv::Ptr<cv::StereoMatcher> BlockMatchingBase::acquireMatcher() const {
+  {
+    std::lock_guard<std::mutex> lock(matchers_mutex_);
+    if (!matchers_.empty()) {
+      cv::Ptr<cv::StereoMatcher> matcher = matchers_.back();
+      matchers_.pop_back();
+      return matcher;
+    }
+  }
+  return createMatcher();
+}
+
+void BlockMatchingBase::releaseMatcher(
+    const cv::Ptr<cv::StereoMatcher>& matcher) const {
+  std::lock_guard<std::mutex> lock(matchers_mutex_);
+  matchers_.push_back(matcher);
+}
+
+}  // namespace stereo
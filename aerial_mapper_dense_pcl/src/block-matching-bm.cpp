@@ -9,31 +9,19 @@
 #include "aerial-mapper-dense-pcl/block-matching-bm.h"
 
 namespace stereo {
-void BlockMatchingBM::computeDisparityMap(
-    const RectifiedStereoPair& rectified_stereo_pair,
-    DensifiedStereoPair* densified_stereo_pair) const {
-  CHECK(densified_stereo_pair);
 
-  // Compute the disparity map.
-  bm_->compute(rectified_stereo_pair.image_left,
-               rectified_stereo_pair.image_right,
-               densified_stereo_pair->disparity_map);
-
-  densified_stereo_pair->disparity_map.convertTo(
-      densified_stereo_pair->disparity_map, CV_32F);
-  densified_stereo_pair->disparity_map =
-      densified_stereo_pair->disparity_map / 16.0;
-
-  // Create masked disparity map.
-  cv::Mat disparity_map_masked(densified_stereo_pair->disparity_map.rows,
-                               densified_stereo_pair->disparity_map.cols,
-                               densified_stereo_pair->disparity_map.type());
-
-  // Apply the rectification mask.
-  disparity_map_masked.setTo(kMaxInvalidDisparity);
-  densified_stereo_pair->disparity_map.copyTo(disparity_map_masked,
-                                              rectified_stereo_pair.mask);
-  densified_stereo_pair->disparity_map = disparity_map_masked;
+cv::Ptr<cv::StereoMatcher> BlockMatchingBM::createMatcher() const {
+  cv::Ptr<cv::StereoBM> bm = cv::StereoBM::create(0, 0);
+  bm->setMinDisparity(bm_params_.min_disparity);
+  bm->setNumDisparities(bm_params_.num_disparities);
+  bm->setPreFilterCap(bm_params_.pre_filter_cap);
+  bm->setPreFilterSize(bm_params_.pre_filter_size);
+  bm->setUniquenessRatio(bm_params_.uniqueness_ratio);
+  bm->setTextureThreshold(bm_params_.texture_threshold);
+  bm->setSpeckleWindowSize(bm_params_.speckle_window_size);
+  bm->setSpeckleRange(bm_params_.speckle_range);
+  bm->setBlockSize(bm_params_.block_size);
+  return bm;
 }
 
 }  // namespace stereo
@@ -10,31 +10,19 @@
 
 namespace stereo {
 
-void BlockMatchingSGBM::computeDisparityMap(
-    const RectifiedStereoPair& rectified_stereo_pair,
-    DensifiedStereoPair* densified_stereo_pair) const {
-  CHECK(densified_stereo_pair);
-
-  // Compute the disparity map.
-  sgbm_->compute(rectified_stereo_pair.image_left,
-                 rectified_stereo_pair.image_right,
-                 densified_stereo_pair->disparity_map);
-
-  densified_stereo_pair->disparity_map.convertTo(
-      densified_stereo_pair->disparity_map, CV_32F);
-  densified_stereo_pair->disparity_map =
-      densified_stereo_pair->disparity_map / 16.0;
-
-  // Create masked disparity map.
-  cv::Mat disparity_map_masked(densified_stereo_pair->disparity_map.rows,
-                               densified_stereo_pair->disparity_map.cols,
-                               densified_stereo_pair->disparity_map.type());
-
-  // Apply the rectification mask.
-  disparity_map_masked.setTo(kMaxInvalidDisparity);
-  densified_stereo_pair->disparity_map.copyTo(disparity_map_masked,
-                                              rectified_stereo_pair.mask);
-  densified_stereo_pair->disparity_map = disparity_map_masked;
+cv::Ptr<cv::StereoMatcher> BlockMatchingSGBM::createMatcher() const {
+  cv::Ptr<cv::StereoSGBM> sgbm = cv::StereoSGBM::create(0, 0, 0);
+  sgbm->setMinDisparity(sgbm_params_.min_disparity);
+  sgbm->setNumDisparities(sgbm_params_.num_disparities);
+  sgbm->setPreFilterCap(sgbm_params_.pre_filter_cap);
+  sgbm->setUniquenessRatio(sgbm_params_.uniqueness_ratio);
+  sgbm->setSpeckleWindowSize(sgbm_params_.speckle_window_size);
+  sgbm->setSpeckleRange(sgbm_params_.speckle_range);
+  sgbm->setDisp12MaxDiff(sgbm_params_.disp_12_max_diff);
+  sgbm->setP1(sgbm_params_.p1);
+  sgbm->setP2(sgbm_params_.p2);
+  sgbm->setBlockSize(sgbm_params_.block_size);
+  return sgbm;
 }
 
 }  // namespace stereo
@@ -8,17 +8,26 @@
 // HEADER
 #include "aerial-mapper-dense-pcl/densifier.h"
 
+// SYSTEM
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// NON-SYSTEM
 #include <ros/ros.h>
 
 namespace stereo {
 
 Densifier::Densifier(const BlockMatchingParameters& block_matching_params,
-                     const cv::Size& image_resolution)
-    : image_resolution_(image_resolution) {
+                     const cv::Size& image_resolution,
+                     utils::ThreadPool* thread_pool)
+    : image_resolution_(image_resolution), thread_pool_(thread_pool) {
   if (block_matching_params.use_BM) {
-    block_matcher_.reset(new BlockMatchingBM(block_matching_params.bm));
+    block_matcher_.reset(
+        new BlockMatchingBM(block_matching_params, thread_pool_));
   } else {
-    block_matcher_.reset(new BlockMatchingSGBM(block_matching_params.sgbm));
+    block_matcher_.reset(
+        new BlockMatchingSGBM(block_matching_params, thread_pool_));
   }
 }
 
@@ -28,11 +37,16 @@ void Densifier::computePointCloud(
     DensifiedStereoPair* densified_stereo_pair,
     sensor_msgs::PointCloud2& point_cloud_ros) const {
   CHECK(densified_stereo_pair);
-  CHECK_EQ(image_resolution_, densified_stereo_pair->disparity_map.size());
-  densified_stereo_pair->point_cloud.create(
-      densified_stereo_pair->disparity_map.size());
-  densified_stereo_pair->point_cloud.setTo(
-      cv::Vec3f(kInvalidPoint, kInvalidPoint, kInvalidPoint));
+  const cv::Mat& disparity_map = densified_stereo_pair->disparity_map;
+  CHECK_EQ(image_resolution_, disparity_map.size());
+  CHECK_EQ(disparity_map.type(), CV_32FC1);
+  CHECK_EQ(image_resolution_, rectified_stereo_pair.image_left.size());
+  CHECK_EQ(point_cloud_ros.point_step, kPointStep);
+  const int width = image_resolution_.width;
+  const int height = image_resolution_.height;
+  CHECK_GE(point_cloud_ros.row_step, width * kPointStep);
+  CHECK_GE(point_cloud_ros.data.size(),
+           static_cast<size_t>(point_cloud_ros.row_step) * height);
 
   // Compute the stereo projection matrix Q.
   const double baseline = rectified_stereo_pair.baseline;
@@ -46,65 +60,103 @@ void Densifier::computePointCloud(
       (Eigen::Matrix4d() << 1, 0, 0, -cx, 0, fx / fy, 0, -cy * (fx / fy), 0, 0,
        0, fx, 0, 0, 1.0 / baseline, 0.0).finished();
 
-  // Declare some pointers for faster loop execution.
-  float* disparity_map_ptr;
-  const unsigned char* pixel_intensity_ptr;
-  int point_offset = 0;
-  for (int v = 0; v < image_resolution_.height; ++v) {
-    disparity_map_ptr = densified_stereo_pair->disparity_map.ptr<float>(v);
-    pixel_intensity_ptr =
-        rectified_stereo_pair.image_left.ptr<unsigned char>(v);
-    for (int u = 0; u < image_resolution_.width; ++u) {
-      point_offset += point_cloud_ros.point_step;
-      bool point_valid = false;
-      if (disparity_map_ptr[u] > kMaxInvalidDisparity) {
-        // w = (1 / baseline) * disparity
-        const double w = Q(3, 2) * disparity_map_ptr[u];
-        CHECK_NE(w, 0.0);
-        // x = (u - cx) * baseline / disparity
-        // y = (fx / fy * v - cy) * baseline / disparity
-        // z = (fx * baseline) / disparity
+  // 1. Count the valid disparities of every row. The prefix sum is the index
+  // of the first point of every row in the output.
+  std::vector<size_t> row_offsets(height + 1, 0u);
+  auto count_valid_disparities = [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      const float* disparity_map_ptr = disparity_map.ptr<float>(v);
+      size_t num_valid = 0u;
+      for (int u = 0; u < width; ++u) {
+        num_valid += isValidDisparity(disparity_map_ptr[u]) ? 1u : 0u;
+      }
+      row_offsets[v + 1u] = num_valid;
+    }
+  };
+  if (thread_pool_) {
+    thread_pool_->parallelFor(height, count_valid_disparities);
+  } else {
+    count_valid_disparities(0u, height);
+  }
+  for (int v = 0; v < height; ++v) {
+    row_offsets[v + 1] += row_offsets[v];
+  }
+  densified_stereo_pair->point_cloud_eigen.resize(row_offsets.back());
+  densified_stereo_pair->point_cloud_intensities.resize(row_offsets.back());
+
+  // 2. Triangulate every row. The point relative to camera 1 is computed in
+  // single precision; the camera position is added in double precision, as
+  // it is usually given in UTM coordinates.
+  // w = (1 / baseline) * disparity
+  // x = (u - cx) * baseline / disparity
+  // y = (fx / fy * v - cy) * baseline / disparity
+  // z = (fx * baseline) / disparity
+  const float inverse_w_scale = 1.0f / static_cast<float>(Q(3, 2));
+  const float u_offset = static_cast<float>(Q(0, 3));
+  const float v_scale = static_cast<float>(Q(1, 1));
+  const float v_offset = static_cast<float>(Q(1, 3));
+  const float z_numerator = static_cast<float>(Q(2, 3));
+  const Eigen::Matrix3f R_G_C = rectified_stereo_pair.R_G_C.cast<float>();
+  const Eigen::Vector3d& t_G_C1 = stereo_pair.t_G_C1;
+  uint8_t* const point_cloud_ros_data = point_cloud_ros.data.data();
+  const size_t row_step = point_cloud_ros.row_step;
+  auto triangulate_rows = [&](size_t begin, size_t end) {
+    std::vector<float> x_G(width), y_G(width), z_G(width);
+    for (size_t v = begin; v < end; ++v) {
+      const float* disparity_map_ptr = disparity_map.ptr<float>(v);
+      const unsigned char* pixel_intensity_ptr =
+          rectified_stereo_pair.image_left.ptr<unsigned char>(v);
+      const float y_numerator = v_scale * v + v_offset;
+
+      // Branch-free, so the compiler can vectorize the loop. Invalid
+      // disparities yield garbage, which is skipped below.
+      for (int u = 0; u < width; ++u) {
+        const float inverse_w = inverse_w_scale / disparity_map_ptr[u];
         // Point defined in rectified frame 1.
-        const Eigen::Vector3d point_r1(
-            (u + Q(0, 3)) / w, (Q(1, 1) * v + Q(1, 3)) / w, (Q(2, 3)) / w);
+        const float x_r1 = (u + u_offset) * inverse_w;
+        const float y_r1 = y_numerator * inverse_w;
+        const float z_r1 = z_numerator * inverse_w;
+        // Rotated into the world/global frame.
+        x_G[u] = R_G_C(0, 0) * x_r1 + R_G_C(0, 1) * y_r1 + R_G_C(0, 2) * z_r1;
+        y_G[u] = R_G_C(1, 0) * x_r1 + R_G_C(1, 1) * y_r1 + R_G_C(1, 2) * z_r1;
+        z_G[u] = R_G_C(2, 0) * x_r1 + R_G_C(2, 1) * y_r1 + R_G_C(2, 2) * z_r1;
+      }
 
-        // Point defined in world/global frame.
-        const Eigen::Vector3d point_G(rectified_stereo_pair.R_G_C * point_r1 +
-                                      stereo_pair.t_G_C1);
-        const float x = point_G(0);
-        const float y = point_G(1);
-        const float z = point_G(2);
-        if (!std::isinf(z)) {
-          // Copy 3D point to ros message.
-          memcpy(&(point_cloud_ros.data[kPositionX + point_offset]), &x,
-                 kSizeOfFloat);
-          memcpy(&(point_cloud_ros.data[kPositionY + point_offset]), &y,
-                 kSizeOfFloat);
-          memcpy(&(point_cloud_ros.data[kPositionZ + point_offset]), &z,
-                 kSizeOfFloat);
+      uint8_t* point_cloud_ros_ptr = point_cloud_ros_data + v * row_step;
+      size_t point_index = row_offsets[v];
+      for (int u = 0; u < width; ++u) {
+        float point[4] = {kInvalidPoint, kInvalidPoint, kInvalidPoint,
+                          kInvalidPoint};
+        if (isValidDisparity(disparity_map_ptr[u])) {
+          // Point defined in world/global frame.
+          const Eigen::Vector3d point_G(t_G_C1(0) + x_G[u],
+                                        t_G_C1(1) + y_G[u],
+                                        t_G_C1(2) + z_G[u]);
           const uint8_t gray = pixel_intensity_ptr[u];
           const uint32_t rgb = (gray << 16) | (gray << 8) | gray;
-          memcpy(&(point_cloud_ros.data[kPositionIntensity + point_offset]),
-                 &rgb, kSizeOfUint32T);
-
-          // Todo(hitimo): Consider pre-allocation...
-          densified_stereo_pair->point_cloud_eigen.push_back(point_G);
-          densified_stereo_pair->point_cloud_intensities.push_back(gray);
-          point_valid = true;
+          point[0] = static_cast<float>(point_G(0));
+          point[1] = static_cast<float>(point_G(1));
+          point[2] = static_cast<float>(point_G(2));
+          memcpy(&point[3], &rgb, sizeof(rgb));
+          densified_stereo_pair->point_cloud_eigen[point_index] = point_G;
+          densified_stereo_pair->point_cloud_intensities[point_index] = gray;
+          ++point_index;
         }
+        // Copy x, y, z, rgb to the ros message in one go.
+        memcpy(point_cloud_ros_ptr + u * kPointStep, point, kPointStep);
       }
-      if (!point_valid) {
-        memcpy(&point_cloud_ros.data[kPositionX + point_offset], &kInvalidPoint,
-               kSizeOfFloat);
-        memcpy(&point_cloud_ros.data[kPositionY + point_offset], &kInvalidPoint,
-               kSizeOfFloat);
-        memcpy(&point_cloud_ros.data[kPositionZ + point_offset], &kInvalidPoint,
-               kSizeOfFloat);
-        memcpy(&point_cloud_ros.data[kPositionIntensity + point_offset],
-               &kInvalidPoint, kSizeOfFloat);
-      }
+      DCHECK_EQ(point_index, row_offsets[v + 1u]);
     }
+  };
+  if (thread_pool_) {
+    thread_pool_->parallelFor(height, triangulate_rows);
+  } else {
+    triangulate_rows(0u, height);
   }
+
+  // View of the organized point cloud without copying.
+  densified_stereo_pair->point_cloud =
+      cv::Mat(height, width, CV_32FC4, point_cloud_ros_data, row_step);
 }
 
 }  // namespace stereo
@@ -0,0 +1,139 @@
+/*
+ *    Filename: disparity-range-predictor.cpp
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-dense-pcl/disparity-range-predictor.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stereo {
+
+DisparityRangePredictor::DisparityRangePredictor(
+    const BlockMatchingParameters& block_matching_params)
+    : search_range_(getSearchRange(block_matching_params)),
+      band_height_(block_matching_params.guidance_band_height),
+      disparity_margin_(block_matching_params.guidance_disparity_margin),
+      height_margin_m_(block_matching_params.guidance_height_margin_m) {
+  CHECK_GT(band_height_, 0);
+  CHECK_GE(disparity_margin_, 0);
+  CHECK_GE(height_margin_m_, 0.0);
+}
+
+void DisparityRangePredictor::predict(
+    const StereoRigParameters& stereo_rig_params,
+    const TerrainHeightPrior& terrain_height_prior,
+    RectifiedStereoPair* rectified_stereo_pair) const {
+  CHECK_NOTNULL(rectified_stereo_pair);
+  const int height = rectified_stereo_pair->image_left.rows;
+  const int num_bands = (height + band_height_ - 1) / band_height_;
+  rectified_stereo_pair->disparity_band_height = band_height_;
+  rectified_stereo_pair->disparity_bands.resize(num_bands);
+  for (int band = 0; band < num_bands; ++band) {
+    const int begin = band * band_height_;
+    const int end = std::min(height, begin + band_height_);
+    rectified_stereo_pair->disparity_bands[band] =
+        predictBand(stereo_rig_params, *rectified_stereo_pair,
+                    terrain_height_prior, begin, end);
+  }
+}
+
+DisparityRange DisparityRangePredictor::predictBand(
+    const StereoRigParameters& stereo_rig_params,
+    const RectifiedStereoPair& rectified_stereo_pair,
+    const TerrainHeightPrior& terrain_height_prior, int begin,
+    int end) const {
+  const Eigen::Matrix3d& K = stereo_rig_params.K;
+  const double fx = K(0, 0);
+  const double fy = K(1, 1);
+  const double cx = K(0, 2);
+  const double cy = K(1, 2);
+  const Eigen::Vector3d& t_G_C1 = stereo_rig_params.t_G_C1;
+  const int width = rectified_stereo_pair.image_left.cols;
+
+  // Viewing rays of the corner pixels of the band in the global frame.
+  Eigen::Matrix<double, 3, 4> rays_G;
+  const int us[] = {0, width - 1};
+  const int vs[] = {begin, end - 1};
+  for (int i = 0; i < 4; ++i) {
+    const Eigen::Vector3d ray_C(us[i % 2] - cx, fx / fy * (vs[i / 2] - cy),
+                                fx);
+    rays_G.col(i) = rectified_stereo_pair.R_G_C * ray_C;
+  }
+
+  // Intersects the rays with the plane at the height. Returns false if a ray
+  // does not hit the plane in front of the camera.
+  auto intersect = [&](double height, Eigen::Matrix<double, 3, 4>* points_G) {
+    for (int i = 0; i < 4; ++i) {
+      const double scale = (height - t_G_C1(2)) / rays_G(2, i);
+      if (!(scale > 0.0)) {
+        return false;
+      }
+      points_G->col(i) = t_G_C1 + scale * rays_G.col(i);
+    }
+    return true;
+  };
+
+  // 1. Footprint of the band for the terrain heights of the whole map.
+  const double kInfinity = std::numeric_limits<double>::infinity();
+  double min_height, max_height;
+  if (!terrain_height_prior.getHeightRange(
+          Eigen::Vector2d::Constant(-kInfinity),
+          Eigen::Vector2d::Constant(kInfinity), &min_height, &max_height)) {
+    return DisparityRange();
+  }
+  Eigen::Matrix<double, 3, 4> points_low_G, points_high_G;
+  if (!intersect(min_height - height_margin_m_, &points_low_G) ||
+      !intersect(max_height + height_margin_m_, &points_high_G)) {
+    return DisparityRange();
+  }
+  const Eigen::Vector2d min_xy =
+      points_low_G.topRows<2>().rowwise().minCoeff().cwiseMin(
+          points_high_G.topRows<2>().rowwise().minCoeff());
+  const Eigen::Vector2d max_xy =
+      points_low_G.topRows<2>().rowwise().maxCoeff().cwiseMax(
+          points_high_G.topRows<2>().rowwise().maxCoeff());
+
+  // 2. Terrain heights within the footprint.
+  if (!terrain_height_prior.getHeightRange(min_xy, max_xy, &min_height,
+                                           &max_height)) {
+    return DisparityRange();
+  }
+  min_height -= height_margin_m_;
+  max_height += height_margin_m_;
+  if (!(max_height < t_G_C1(2))) {
+    return DisparityRange();
+  }
+
+  // 3. Disparities of the corners at the minimum and maximum height.
+  const double baseline = rectified_stereo_pair.baseline;
+  double min_disparity = kInfinity;
+  double max_disparity = -kInfinity;
+  for (const double height : {min_height, max_height}) {
+    for (int i = 0; i < 4; ++i) {
+      const double disparity = baseline * rays_G(2, i) / (height - t_G_C1(2));
+      min_disparity = std::min(min_disparity, disparity);
+      max_disparity = std::max(max_disparity, disparity);
+    }
+  }
+  if (!std::isfinite(min_disparity) || !std::isfinite(max_disparity)) {
+    return DisparityRange();
+  }
+  // Only the part within the search range matters, clamp before rounding.
+  min_disparity = std::max(min_disparity, search_range_.min_disparity - 1.0);
+  max_disparity = std::min(max_disparity, search_range_.getEnd() + 1.0);
+  const int begin_disparity =
+      static_cast<int>(std::floor(min_disparity)) - disparity_margin_;
+  const int end_disparity =
+      static_cast<int>(std::ceil(max_disparity)) + disparity_margin_ + 1;
+  return DisparityRange(begin_disparity, end_disparity - begin_disparity)
+      .intersect(search_range_);
+}
+
+}  // namespace stereo
@@ -0,0 +1,173 @@
+/*
+ *    Filename: height-grid-fusion.cpp
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-dense-pcl/height-grid-fusion.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace stereo {
+
+void HeightGridFusion::Surface::merge(const Surface& other) {
+  if (other.num_points == 0u) {
+    return;
+  }
+  if (num_points == 0u) {
+    *this = other;
+    return;
+  }
+  const double n_a = num_points;
+  const double n_b = other.num_points;
+  const double n = n_a + n_b;
+  const double delta_height = other.mean(2) - mean(2);
+  m2_height += other.m2_height + delta_height * delta_height * n_a * n_b / n;
+  mean += (other.mean - mean) * (n_b / n);
+  mean_intensity += (other.mean_intensity - mean_intensity) * (n_b / n);
+  num_points += other.num_points;
+  num_views += other.num_views;
+}
+
+HeightGridFusion::HeightGridFusion(const FusionSettings& settings)
+    : settings_(settings), shards_(kNumShards) {
+  CHECK_GT(settings_.cell_size_m, 0.0);
+  CHECK_GT(settings_.max_deviation_sigma, 0.0);
+  CHECK_GT(settings_.min_sigma_m, 0.0);
+}
+
+uint64_t HeightGridFusion::getCellKey(const Eigen::Vector3d& point) const {
+  const int32_t x = static_cast<int32_t>(std::floor(point(0) /
+                                                    settings_.cell_size_m));
+  const int32_t y = static_cast<int32_t>(std::floor(point(1) /
+                                                    settings_.cell_size_m));
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+         static_cast<uint64_t>(static_cast<uint32_t>(y));
+}
+
+void HeightGridFusion::insert(
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    const std::vector<int>& point_cloud_intensities) {
+  const bool has_intensities = !point_cloud_intensities.empty();
+  CHECK(!has_intensities ||
+        point_cloud_intensities.size() == point_cloud.size());
+
+  // 1. Reduce the pair to one surface per cell (Welford), without locking.
+  CellMap view_cells;
+  for (size_t i = 0u; i < point_cloud.size(); ++i) {
+    const Eigen::Vector3d& point = point_cloud[i];
+    Surface& surface = view_cells[getCellKey(point)].fused;
+    const double n = ++surface.num_points;
+    const double delta_height = point(2) - surface.mean(2);
+    surface.mean += (point - surface.mean) / n;
+    surface.m2_height += delta_height * (point(2) - surface.mean(2));
+    if (has_intensities) {
+      surface.mean_intensity +=
+          (point_cloud_intensities[i] - surface.mean_intensity) / n;
+    }
+  }
+
+  // 2. Merge the cells shard by shard, each under one lock.
+  std::vector<std::vector<const CellMap::value_type*> > cells_per_shard(
+      kNumShards);
+  for (const CellMap::value_type& view_cell : view_cells) {
+    cells_per_shard[getShardIndex(view_cell.first)].push_back(&view_cell);
+  }
+  for (size_t shard_index = 0u; shard_index < kNumShards; ++shard_index) {
+    if (cells_per_shard[shard_index].empty()) {
+      continue;
+    }
+    Shard& shard = shards_[shard_index];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const CellMap::value_type* view_cell : cells_per_shard[shard_index]) {
+      Surface view = view_cell->second.fused;
+      view.num_views = 1u;
+      fuse(view, &shard.cells[view_cell->first]);
+    }
+  }
+}
+
+void HeightGridFusion::fuse(const Surface& view, Cell* cell) const {
+  CHECK_NOTNULL(cell);
+  // Gate on the spread of both the cell and the view.
+  auto is_consistent = [this, &view](const Surface& surface) {
+    const double sigma = std::max(
+        settings_.min_sigma_m,
+        std::sqrt(surface.getHeightVariance() + view.getHeightVariance()));
+    return std::abs(view.mean(2) - surface.mean(2)) <=
+           settings_.max_deviation_sigma * sigma;
+  };
+
+  if (cell->fused.num_views == 0u || is_consistent(cell->fused)) {
+    cell->fused.merge(view);
+    return;
+  }
+  // An outlier of the fused surface: it either supports the alternative or
+  // starts a new one.
+  if (cell->alternative.num_views > 0u && is_consistent(cell->alternative)) {
+    cell->alternative.merge(view);
+  } else {
+    cell->alternative = view;
+  }
+  if (cell->alternative.num_views > cell->fused.num_views) {
+    std::swap(cell->fused, cell->alternative);
+  }
+}
+
+void HeightGridFusion::getPointCloud(
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+    std::vector<int>* point_cloud_intensities) const {
+  CHECK_NOTNULL(point_cloud);
+  std::vector<std::pair<uint64_t, const Surface*> > surfaces;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const CellMap::value_type& cell : shard.cells) {
+      if (cell.second.fused.num_views >= settings_.min_num_views) {
+        surfaces.emplace_back(cell.first, &cell.second.fused);
+      }
+    }
+  }
+  std::sort(surfaces.begin(), surfaces.end(),
+            [](const std::pair<uint64_t, const Surface*>& lhs,
+               const std::pair<uint64_t, const Surface*>& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  point_cloud->resize(surfaces.size());
+  if (point_cloud_intensities) {
+    point_cloud_intensities->resize(surfaces.size());
+  }
+  for (size_t i = 0u; i < surfaces.size(); ++i) {
+    (*point_cloud)[i] = surfaces[i].second->mean;
+    if (point_cloud_intensities) {
+      (*point_cloud_intensities)[i] =
+          static_cast<int>(std::lround(surfaces[i].second->mean_intensity));
+    }
+  }
+}
+
+void HeightGridFusion::clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cells.clear();
+  }
+}
+
+size_t HeightGridFusion::getNumCells() const {
+  size_t num_cells = 0u;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    num_cells += shard.cells.size();
+  }
+  return num_cells;
+}
+
+}  // namespace stereo
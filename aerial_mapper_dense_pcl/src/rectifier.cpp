@@ -8,6 +8,10 @@
 // HEADER
 #include "aerial-mapper-dense-pcl/rectifier.h"
 
+// SYSTEM
+#include <algorithm>
+#include <vector>
+
 /// The rectification algorithm closely follows:
 /// @article{Fusiello:2000:CAR:360401.360413,
 ///  author = {Fusiello, Andrea and Trucco, Emanuele and Verri, Alessandro},
@@ -74,43 +78,113 @@ void Rectifier::rectifyStereoPair(const StereoRigParameters& stereo_pair,
   const Eigen::Matrix3d Q2 = stereo_pair.K * (stereo_pair.R_G_C2.transpose());
   const Eigen::Matrix3d T1_rect = P1_rect.block<3, 3>(0, 0) * Q1.inverse();
   const Eigen::Matrix3d T2_rect = P2_rect.block<3, 3>(0, 0) * Q2.inverse();
-  const Eigen::Matrix3f T1_inv = T1_rect.inverse().cast<float>();
-  const Eigen::Matrix3f T2_inv = T2_rect.inverse().cast<float>();
-  for (int v_rect = 0; v_rect < image_resolution_.height; ++v_rect) {
-    map_rectify_1_x_ptr_ = map_rectify_1_x_.ptr<float>(v_rect);
-    map_rectify_1_y_ptr_ = map_rectify_1_y_.ptr<float>(v_rect);
-    map_rectify_2_x_ptr_ = map_rectify_2_x_.ptr<float>(v_rect);
-    map_rectify_2_y_ptr_ = map_rectify_2_y_.ptr<float>(v_rect);
-    for (int u_rect = 0; u_rect < image_resolution_.width; ++u_rect) {
-      // Apply rectifying image transformation:
-      // [u_rect, v_rect, 1.0]^\top = T * [x, y, w]^\top
-      // <=> [x, y, w]^\top = T_inv * [u_rect, v_rect, 1.0]^\top
-      // u = x / w; v = y / w;
-
-      // Rectify image 1.
-      const Eigen::Vector3f xyw_1 =
-          T1_inv * (Eigen::Vector3f() << u_rect, v_rect, 1.0).finished();
-      CHECK_NE(xyw_1(2), 0.0);
-      map_rectify_1_x_ptr_[u_rect] = xyw_1(0) / xyw_1(2);
-      map_rectify_1_y_ptr_[u_rect] = xyw_1(1) / xyw_1(2);
-
-      // Rectify image 2.
-      const Eigen::Vector3f xyw_2 =
-          T2_inv * (Eigen::Vector3f() << u_rect, v_rect, 1.0).finished();
-      CHECK_NE(xyw_2(2), 0.0);
-      map_rectify_2_x_ptr_[u_rect] = xyw_2(0) / xyw_2(2);
-      map_rectify_2_y_ptr_[u_rect] = xyw_2(1) / xyw_2(2);
-    }  // for u_rect
-  }    // for v_rect
+  updateMaps(T1_rect, T2_rect);
 
   // Compute the rectified images based on the maps.
   cv::remap(image_left_undistorted, rectified_stereo_pair->image_left,
-            map_rectify_1_x_, map_rectify_1_y_, CV_INTER_LINEAR,
+            map_rectify_1_xy_, map_rectify_1_interpolation_, CV_INTER_LINEAR,
             cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
   cv::remap(image_right_undistorted, rectified_stereo_pair->image_right,
-            map_rectify_2_x_, map_rectify_2_y_, CV_INTER_LINEAR,
+            map_rectify_2_xy_, map_rectify_2_interpolation_, CV_INTER_LINEAR,
             cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
-  rectified_stereo_pair->mask = computeMask(T1_rect);
+  rectified_stereo_pair->mask = mask_;
+}
+
+void Rectifier::updateMaps(const Eigen::Matrix3d& T1_rect,
+                           const Eigen::Matrix3d& T2_rect) {
+  // Consecutive pairs of a straight flight line have nearly the same
+  // rectifying transforms, so their maps can be shared.
+  if (has_maps_ &&
+      computeMaxDisplacement(T1_rect_maps_, T1_rect) <=
+          map_reuse_tolerance_px_ &&
+      computeMaxDisplacement(T2_rect_maps_, T2_rect) <=
+          map_reuse_tolerance_px_) {
+    return;
+  }
+  buildMap(T1_rect, &map_rectify_1_xy_, &map_rectify_1_interpolation_);
+  buildMap(T2_rect, &map_rectify_2_xy_, &map_rectify_2_interpolation_);
+  mask_ = computeMask(T1_rect);
+  T1_rect_maps_ = T1_rect;
+  T2_rect_maps_ = T2_rect;
+  has_maps_ = true;
+}
+
+void Rectifier::buildMap(const Eigen::Matrix3d& T_rect, cv::Mat* map_xy,
+                         cv::Mat* map_interpolation) const {
+  CHECK_NOTNULL(map_xy);
+  CHECK_NOTNULL(map_interpolation);
+  const int width = image_resolution_.width;
+  const int height = image_resolution_.height;
+  map_xy->create(height, width, CV_16SC2);
+  map_interpolation->create(height, width, CV_16UC1);
+
+  // Apply rectifying image transformation:
+  // [u_rect, v_rect, 1.0]^\top = T * [x, y, w]^\top
+  // <=> [x, y, w]^\top = T_inv * [u_rect, v_rect, 1.0]^\top
+  // u = x / w; v = y / w;
+  // [x, y, w] is linear in the pixel. Thus, w keeps its sign over the image
+  // if it has the same sign at the four corners, and w never vanishes.
+  const Eigen::Matrix3d T_inv = T_rect.inverse();
+  const Eigen::Vector4d w_corners =
+      (T_inv.row(2) * corner_pixel_h_).transpose();
+  CHECK((w_corners.array() > 0.0).all() || (w_corners.array() < 0.0).all())
+      << "The rectified image contains the horizon of the unrectified one.";
+
+  // Along a row, [x, y, w] grows by the first column of T_inv per pixel.
+  const Eigen::Vector3f xyw_step = T_inv.col(0).cast<float>();
+  const float scale = static_cast<float>(cv::INTER_TAB_SIZE);
+  auto build_rows = [&](size_t begin, size_t end) {
+    std::vector<float> x_scaled(width), y_scaled(width);
+    for (int v_rect = static_cast<int>(begin); v_rect < static_cast<int>(end);
+         ++v_rect) {
+      const Eigen::Vector3f xyw_start =
+          (T_inv.col(1) * v_rect + T_inv.col(2)).cast<float>();
+      // Branch-free, so the compiler can vectorize the loop.
+      for (int u_rect = 0; u_rect < width; ++u_rect) {
+        const float u = static_cast<float>(u_rect);
+        const float w_inv = scale / (xyw_start(2) + u * xyw_step(2));
+        x_scaled[u_rect] = (xyw_start(0) + u * xyw_step(0)) * w_inv;
+        y_scaled[u_rect] = (xyw_start(1) + u * xyw_step(1)) * w_inv;
+      }
+      // Split into integer position and interpolation table index, exactly
+      // like cv::convertMaps() does for CV_16SC2 maps.
+      cv::Vec2s* map_xy_ptr = map_xy->ptr<cv::Vec2s>(v_rect);
+      ushort* map_interpolation_ptr = map_interpolation->ptr<ushort>(v_rect);
+      for (int u_rect = 0; u_rect < width; ++u_rect) {
+        const int x = cv::saturate_cast<int>(x_scaled[u_rect]);
+        const int y = cv::saturate_cast<int>(y_scaled[u_rect]);
+        map_xy_ptr[u_rect][0] = cv::saturate_cast<short>(x >> cv::INTER_BITS);
+        map_xy_ptr[u_rect][1] = cv::saturate_cast<short>(y >> cv::INTER_BITS);
+        map_interpolation_ptr[u_rect] = static_cast<ushort>(
+            (y & (cv::INTER_TAB_SIZE - 1)) * cv::INTER_TAB_SIZE +
+            (x & (cv::INTER_TAB_SIZE - 1)));
+      }
+    }
+  };
+  if (thread_pool_) {
+    thread_pool_->parallelFor(height, build_rows);
+  } else {
+    build_rows(0u, height);
+  }
+}
+
+double Rectifier::computeMaxDisplacement(
+    const Eigen::Matrix3d& T_rect_a, const Eigen::Matrix3d& T_rect_b) const {
+  const Eigen::Matrix3d T_inv_a = T_rect_a.inverse();
+  const Eigen::Matrix3d T_inv_b = T_rect_b.inverse();
+  double max_displacement = 0.0;
+  for (int i = 0; i <= 2; ++i) {
+    for (int j = 0; j <= 2; ++j) {
+      const Eigen::Vector3d pixel_rect_h(
+          0.5 * i * (image_resolution_.width - 1),
+          0.5 * j * (image_resolution_.height - 1), 1.0);
+      const Eigen::Vector2d pixel_a = (T_inv_a * pixel_rect_h).hnormalized();
+      const Eigen::Vector2d pixel_b = (T_inv_b * pixel_rect_h).hnormalized();
+      max_displacement =
+          std::max(max_displacement, (pixel_a - pixel_b).norm());
+    }
+  }
+  return max_displacement;
 }
 
 cv::Mat Rectifier::computeMask(const Eigen::Matrix3d& T1_rect) const {
@@ -7,6 +7,9 @@
 
 #include "aerial-mapper-dense-pcl/stereo.h"
 
+// SYSTEM
+#include <algorithm>
+
 namespace stereo {
 
 Stereo::Stereo(const std::shared_ptr<aslam::NCamera> ncameras,
@@ -19,9 +22,9 @@ Stereo::Stereo(const std::shared_ptr<aslam::NCamera> ncameras,
       image_transport_(image_transport::ImageTransport(node_handle_)) {
   CHECK(ncameras_);
 
-  cv::Size image_resolution;
-  image_resolution.width = (ncameras_->getCamera(kFrameIdx).imageWidth());
-  image_resolution.height = (ncameras_->getCamera(kFrameIdx).imageHeight());
+  image_resolution_.width = (ncameras_->getCamera(kFrameIdx).imageWidth());
+  image_resolution_.height = (ncameras_->getCamera(kFrameIdx).imageHeight());
+  block_matching_params_ = block_matching_params;
 
   // Undistorter.
   static constexpr float undistortion_alpha = 1.0;
@@ -30,8 +33,20 @@ Stereo::Stereo(const std::shared_ptr<aslam::NCamera> ncameras,
       ncameras_->getCamera(kFrameIdx), undistortion_alpha, undistortion_scale,
       aslam::InterpolationMethod::Linear);
 
-  rectifier_.reset(new Rectifier(image_resolution));
-  densifier_.reset(new Densifier(block_matching_params, image_resolution));
+  utils::ThreadPoolSettings thread_pool_settings;
+  thread_pool_settings.num_threads = std::max(settings_.num_threads, 0);
+  thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
+
+  rectifier_.reset(new Rectifier(image_resolution_,
+                                 settings_.rectification_map_tolerance_px,
+                                 thread_pool_.get()));
+  densifier_.reset(new Densifier(block_matching_params, image_resolution_,
+                                 thread_pool_.get()));
+  disparity_range_predictor_.reset(
+      new DisparityRangePredictor(block_matching_params));
+  if (settings_.fusion.cell_size_m > 0.0) {
+    fusion_.reset(new HeightGridFusion(settings_.fusion));
+  }
 
   // Set the calibration matrix K (assumed to be constant for all frames).
   aslam::PinholeCamera::ConstPtr pinhole_camera_ptr =
@@ -43,77 +58,128 @@ Stereo::Stereo(const std::shared_ptr<aslam::NCamera> ncameras,
   T_B_C_ = ncameras_->get_T_C_B(kFrameIdx).inverse();
 
   // Define the point cloud message.
-  point_cloud_ros_msg_.header.frame_id = "world";
-  point_cloud_ros_msg_.height = image_resolution.height;
-  point_cloud_ros_msg_.width = image_resolution.width;
-  point_cloud_ros_msg_.fields.resize(4);
-
-  point_cloud_ros_msg_.fields[0].name = "x";
-  point_cloud_ros_msg_.fields[0].offset = 0;
-  point_cloud_ros_msg_.fields[0].count = 1;
-  point_cloud_ros_msg_.fields[0].datatype = sensor_msgs::PointField::FLOAT32;
-
-  point_cloud_ros_msg_.fields[1].name = "y";
-  point_cloud_ros_msg_.fields[1].offset = 4;
-  point_cloud_ros_msg_.fields[1].count = 1;
-  point_cloud_ros_msg_.fields[1].datatype = sensor_msgs::PointField::FLOAT32;
-
-  point_cloud_ros_msg_.fields[2].name = "z";
-  point_cloud_ros_msg_.fields[2].offset = 8;
-  point_cloud_ros_msg_.fields[2].count = 1;
-  point_cloud_ros_msg_.fields[2].datatype = sensor_msgs::PointField::FLOAT32;
-
-  point_cloud_ros_msg_.fields[3].name = "rgb";
-  point_cloud_ros_msg_.fields[3].offset = 12;
-  point_cloud_ros_msg_.fields[3].count = 1;
-  point_cloud_ros_msg_.fields[3].datatype = sensor_msgs::PointField::UINT32;
-
-  point_cloud_ros_msg_.point_step = 16;
-  point_cloud_ros_msg_.row_step =
-      point_cloud_ros_msg_.point_step * point_cloud_ros_msg_.width;
-  point_cloud_ros_msg_.data.resize(point_cloud_ros_msg_.row_step *
-                                   point_cloud_ros_msg_.height);
-  point_cloud_ros_msg_.is_dense = false;
+  initializePointCloudMessage(&point_cloud_ros_msg_);
 
   pub_point_cloud_ = node_handle_.advertise<sensor_msgs::PointCloud2>(
       "/planar_rectification/point_cloud", 100);
 }
 
+void Stereo::initializePointCloudMessage(
+    sensor_msgs::PointCloud2* point_cloud_ros_msg) const {
+  CHECK_NOTNULL(point_cloud_ros_msg);
+  point_cloud_ros_msg->header.frame_id = "world";
+  point_cloud_ros_msg->height = image_resolution_.height;
+  point_cloud_ros_msg->width = image_resolution_.width;
+  point_cloud_ros_msg->fields.resize(4);
+
+  point_cloud_ros_msg->fields[0].name = "x";
+  point_cloud_ros_msg->fields[0].offset = 0;
+  point_cloud_ros_msg->fields[0].count = 1;
+  point_cloud_ros_msg->fields[0].datatype = sensor_msgs::PointField::FLOAT32;
+
+  point_cloud_ros_msg->fields[1].name = "y";
+  point_cloud_ros_msg->fields[1].offset = 4;
+  point_cloud_ros_msg->fields[1].count = 1;
+  point_cloud_ros_msg->fields[1].datatype = sensor_msgs::PointField::FLOAT32;
+
+  point_cloud_ros_msg->fields[2].name = "z";
+  point_cloud_ros_msg->fields[2].offset = 8;
+  point_cloud_ros_msg->fields[2].count = 1;
+  point_cloud_ros_msg->fields[2].datatype = sensor_msgs::PointField::FLOAT32;
+
+  point_cloud_ros_msg->fields[3].name = "rgb";
+  point_cloud_ros_msg->fields[3].offset = 12;
+  point_cloud_ros_msg->fields[3].count = 1;
+  point_cloud_ros_msg->fields[3].datatype = sensor_msgs::PointField::UINT32;
+
+  point_cloud_ros_msg->point_step = 16;
+  point_cloud_ros_msg->row_step =
+      point_cloud_ros_msg->point_step * point_cloud_ros_msg->width;
+  point_cloud_ros_msg->data.resize(point_cloud_ros_msg->row_step *
+                                   point_cloud_ros_msg->height);
+  point_cloud_ros_msg->is_dense = false;
+}
+
 void Stereo::addFrames(const Poses& T_G_Bs, const Images& images,
                        AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
                        std::vector<int>* point_cloud_intensities) {
   CHECK(point_cloud);
+  CHECK(T_G_Bs.size() == images.size());
   point_cloud->clear();
   if (point_cloud_intensities) {
     point_cloud_intensities->clear();
   }
 
+  // Form the pairs up front, then densify them in parallel.
+  AlignedType<std::vector, StereoFrame>::type stereo_frames;
   size_t skip = 0u;
   for (size_t i = 0u; i < images.size(); ++i) {
     if (++skip % settings_.use_every_nth_image == 0) {
-      LOG(INFO) << "Processing image " << i << "/" << images.size();
-      AlignedType<std::vector, Eigen::Vector3d>::type point_cloud_tmp;
-      std::vector<int> point_cloud_intensities_tmp;
-      addFrame(T_G_Bs[i], images[i], &point_cloud_tmp,
-               &point_cloud_intensities_tmp);
-
-      // Append 3D points and (optional) corresponding pixel intensities.
-      CHECK(point_cloud_tmp.size() == point_cloud_intensities_tmp.size());
-      point_cloud->insert(point_cloud->end(), point_cloud_tmp.begin(),
-                          point_cloud_tmp.end());
-      if (point_cloud_intensities) {
-        point_cloud_intensities->insert(point_cloud_intensities->end(),
-                                        point_cloud_intensities_tmp.begin(),
-                                        point_cloud_intensities_tmp.end());
+      StereoFrame stereo_frame;
+      if (makeStereoFrame(T_G_Bs[i], images[i], &stereo_frame)) {
+        stereo_frames.push_back(stereo_frame);
       }
     }
   }
+  LOG(INFO) << "Densifying " << stereo_frames.size() << " stereo pairs";
+  if (fusion_) {
+    fusion_->clear();
+  }
+  densifyStereoFrames(stereo_frames, point_cloud, point_cloud_intensities);
+  if (fusion_) {
+    fusion_->getPointCloud(point_cloud, point_cloud_intensities);
+    LOG(INFO) << "Fused " << point_cloud->size() << " points";
+  }
+}
+
+void Stereo::addFrames(const Poses& T_G_Bs, io::ImageStream* images,
+                       AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+                       std::vector<int>* point_cloud_intensities) {
+  CHECK(images);
+  CHECK(point_cloud);
+  CHECK(T_G_Bs.size() == images->size());
+  point_cloud->clear();
+  if (point_cloud_intensities) {
+    point_cloud_intensities->clear();
+  }
+
+  const size_t num_pairs_per_batch =
+      kPairsPerThread * thread_pool_->getNumThreads();
+  AlignedType<std::vector, StereoFrame>::type stereo_frames;
+  if (fusion_) {
+    fusion_->clear();
+  }
+  cv::Mat image;
+  for (size_t i = 0u; images->next(&image); ++i) {
+    StereoFrame stereo_frame;
+    if (makeStereoFrame(T_G_Bs[i], image, &stereo_frame)) {
+      stereo_frames.push_back(stereo_frame);
+    }
+    if (stereo_frames.size() == num_pairs_per_batch || !images->hasNext()) {
+      LOG(INFO) << "Densifying images up to " << i << "/" << images->size();
+      densifyStereoFrames(stereo_frames, point_cloud, point_cloud_intensities);
+      stereo_frames.clear();
+    }
+  }
+  if (fusion_) {
+    fusion_->getPointCloud(point_cloud, point_cloud_intensities);
+    LOG(INFO) << "Fused " << point_cloud->size() << " points";
+  }
 }
 
 void Stereo::addFrame(const Pose& T_G_B, const Image& image_raw,
                       AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
                       std::vector<int>* point_cloud_intensities) {
   CHECK(point_cloud);
+  StereoFrame stereo_frame;
+  if (makeStereoFrame(T_G_B, image_raw, &stereo_frame)) {
+    processStereoFrame(stereo_frame, point_cloud, point_cloud_intensities);
+  }
+}
+
+bool Stereo::makeStereoFrame(const Pose& T_G_B, const Image& image_raw,
+                             StereoFrame* stereo_frame) {
+  CHECK_NOTNULL(stereo_frame);
   // SGBM/BM blockmatching requires images of type CV_8UC1.
   cv::Mat image;
   if (image_raw.type() == CV_8UC1) {
@@ -131,68 +197,225 @@ void Stereo::addFrame(const Pose& T_G_B, const Image& image_raw,
     stereo_rig_params_.R_G_C1 = (T_G_B * T_B_C_).getRotationMatrix();
     image_distorted_1_ = image;
     first_frame_ = false;
-    return;
+    return false;
   }
   // Prepare the second/right frame of the stereo pair.
   stereo_rig_params_.t_G_C2 = (T_G_B * T_B_C_).getPosition();
   stereo_rig_params_.R_G_C2 = (T_G_B * T_B_C_).getRotationMatrix();
-  image_distorted_2_ = image;
-
-  processStereoFrame(point_cloud, point_cloud_intensities);
+  stereo_frame->stereo_rig_params = stereo_rig_params_;
+  stereo_frame->image_distorted_1 = image_distorted_1_;
+  stereo_frame->image_distorted_2 = image;
 
   // Prepare next iteration: The previously second/right frame is
   // now the first/left frame.
   stereo_rig_params_.t_G_C1 = stereo_rig_params_.t_G_C2;
   stereo_rig_params_.R_G_C1 = stereo_rig_params_.R_G_C2;
-  image_distorted_1_ = image_distorted_2_;
+  image_distorted_1_ = image;
+  return true;
 }
 
 void Stereo::processStereoFrame(
+    const StereoFrame& stereo_frame,
     AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
     std::vector<int>* point_cloud_intensities) {
-  // 1. Undistort raw images.
-  cv::Mat image_undistorted_1 = image_distorted_1_;
-  cv::Mat image_undistorted_2 = image_distorted_2_;
-  if (settings_.images_need_undistortion) {
-    undistortRawImages(image_distorted_1_, image_distorted_2_,
-                       &image_undistorted_1, &image_undistorted_2);
-  }
-
-  // 2. Rectify undistorted images.
   RectifiedStereoPair rectified_stereo_pair;
-  rectifier_->rectifyStereoPair(stereo_rig_params_, image_undistorted_1,
-                                image_undistorted_2, &rectified_stereo_pair);
+  rectifyStereoFrame(stereo_frame, &rectified_stereo_pair);
+  densifyStereoFrame(stereo_frame, rectified_stereo_pair, point_cloud,
+                     point_cloud_intensities);
+}
 
-  // 3. Compute disparity map based on rectified images.
+void Stereo::rectifyStereoFrame(const StereoFrame& stereo_frame,
+                                RectifiedStereoPair* rectified_stereo_pair) {
+  CHECK_NOTNULL(rectified_stereo_pair);
+  cv::Mat image_undistorted_1, image_undistorted_2;
+  undistortAndRectify(stereo_frame, rectifier_.get(), &image_undistorted_1,
+                      &image_undistorted_2, rectified_stereo_pair);
+
+  // [Optional] Visualize rectification.
+  if (settings_.show_rectification) {
+    visualizeRectification(image_undistorted_1, image_undistorted_2,
+                           rectified_stereo_pair->image_left,
+                           rectified_stereo_pair->image_right);
+  }
+}
+
+void Stereo::densifyStereoFrame(
+    const StereoFrame& stereo_frame,
+    const RectifiedStereoPair& rectified_stereo_pair,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+    std::vector<int>* point_cloud_intensities) {
+  CHECK_NOTNULL(point_cloud);
   DensifiedStereoPair densified_stereo_pair;
-  CHECK(rectified_stereo_pair.image_left.type() == CV_8UC1);
-  CHECK(rectified_stereo_pair.image_right.type() == CV_8UC1);
-  densifier_->computeDisparityMap(rectified_stereo_pair,
-                                  &densified_stereo_pair);
-
-  // 4. Compute point cloud.
-  point_cloud_ros_msg_.data.clear();
-  point_cloud_ros_msg_.data.resize(point_cloud_ros_msg_.row_step *
-                                   point_cloud_ros_msg_.height);
-  ros::Time timestamp = ros::Time::now();
-  point_cloud_ros_msg_.header.stamp = timestamp;
-  densifier_->computePointCloud(stereo_rig_params_, rectified_stereo_pair,
-                                &densified_stereo_pair, point_cloud_ros_msg_);
-  *point_cloud = densified_stereo_pair.point_cloud_eigen;
+  triangulate(stereo_frame, rectified_stereo_pair, *densifier_,
+              &point_cloud_ros_msg_, &densified_stereo_pair);
+  point_cloud->swap(densified_stereo_pair.point_cloud_eigen);
   if (point_cloud_intensities) {
-    *point_cloud_intensities = densified_stereo_pair.point_cloud_intensities;
+    point_cloud_intensities->swap(
+        densified_stereo_pair.point_cloud_intensities);
   }
-  
+
   // 5. Publish the point cloud.
   pub_point_cloud_.publish(point_cloud_ros_msg_);
   ros::spinOnce();
+}
 
-  // [Optional] Visualize rectification.
-  if (settings_.show_rectification) {
-    visualizeRectification(image_undistorted_1, image_undistorted_2,
-                           rectified_stereo_pair.image_left,
-                           rectified_stereo_pair.image_right);
+void Stereo::densifyStereoFrames(
+    const AlignedType<std::vector, StereoFrame>::type& stereo_frames,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+    std::vector<int>* point_cloud_intensities) {
+  CHECK_NOTNULL(point_cloud);
+  const size_t num_pairs = stereo_frames.size();
+  std::vector<DensifiedStereoPair,
+              Eigen::aligned_allocator<DensifiedStereoPair> >
+      densified_stereo_pairs(num_pairs);
+  // The fusion depends on the order of the pairs, so they are fused in the
+  // order of the pairs: a finished pair waits until all pairs before it are
+  // fused, and the thread that finishes the next pair fuses the waiting ones.
+  std::mutex fusion_mutex;
+  std::vector<bool> is_densified(num_pairs, false);
+  size_t num_fused_pairs = 0u;
+  thread_pool_->parallelFor(num_pairs, [&](size_t begin, size_t end) {
+    std::unique_ptr<PairWorkspace> workspace = acquireWorkspace();
+    for (size_t i = begin; i < end; ++i) {
+      cv::Mat image_undistorted_1, image_undistorted_2;
+      RectifiedStereoPair rectified_stereo_pair;
+      undistortAndRectify(stereo_frames[i], workspace->rectifier.get(),
+                          &image_undistorted_1, &image_undistorted_2,
+                          &rectified_stereo_pair);
+      triangulate(stereo_frames[i], rectified_stereo_pair,
+                  *workspace->densifier, &workspace->point_cloud_ros_msg,
+                  &densified_stereo_pairs[i]);
+      // Only the points are needed from here on.
+      densified_stereo_pairs[i].disparity_map.release();
+      densified_stereo_pairs[i].point_cloud.release();
+      // Publishing is thread-safe; the message is serialized immediately.
+      pub_point_cloud_.publish(workspace->point_cloud_ros_msg);
+      if (fusion_) {
+        // The points of the pairs are dropped once they are fused, so the
+        // memory does not grow with the overlap of the pairs.
+        std::lock_guard<std::mutex> lock(fusion_mutex);
+        is_densified[i] = true;
+        for (; num_fused_pairs < num_pairs && is_densified[num_fused_pairs];
+             ++num_fused_pairs) {
+          DensifiedStereoPair& pair = densified_stereo_pairs[num_fused_pairs];
+          fusion_->insert(pair.point_cloud_eigen,
+                          pair.point_cloud_intensities);
+          pair = DensifiedStereoPair();
+        }
+      }
+    }
+    releaseWorkspace(std::move(workspace));
+  }, 1u);
+  if (fusion_) {
+    CHECK_EQ(num_fused_pairs, num_pairs);
+    ros::spinOnce();
+    return;
+  }
+
+  // Merge the points of all pairs into the preallocated output.
+  std::vector<size_t> offsets(num_pairs + 1u, point_cloud->size());
+  for (size_t i = 0u; i < num_pairs; ++i) {
+    offsets[i + 1u] =
+        offsets[i] + densified_stereo_pairs[i].point_cloud_eigen.size();
+  }
+  point_cloud->resize(offsets.back());
+  if (point_cloud_intensities) {
+    CHECK_EQ(point_cloud_intensities->size(), offsets.front());
+    point_cloud_intensities->resize(offsets.back());
   }
+  thread_pool_->parallelFor(num_pairs, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const DensifiedStereoPair& pair = densified_stereo_pairs[i];
+      CHECK_EQ(pair.point_cloud_eigen.size(),
+               pair.point_cloud_intensities.size());
+      std::copy(pair.point_cloud_eigen.begin(), pair.point_cloud_eigen.end(),
+                point_cloud->begin() + offsets[i]);
+      if (point_cloud_intensities) {
+        std::copy(pair.point_cloud_intensities.begin(),
+                  pair.point_cloud_intensities.end(),
+                  point_cloud_intensities->begin() + offsets[i]);
+      }
+    }
+  }, 1u);
+  ros::spinOnce();
+}
+
+std::unique_ptr<Stereo::PairWorkspace> Stereo::acquireWorkspace() {
+  {
+    std::lock_guard<std::mutex> lock(workspaces_mutex_);
+    if (!workspaces_.empty()) {
+      std::unique_ptr<PairWorkspace> workspace = std::move(workspaces_.back());
+      workspaces_.pop_back();
+      return workspace;
+    }
+  }
+  std::unique_ptr<PairWorkspace> workspace(new PairWorkspace);
+  workspace->rectifier.reset(
+      new Rectifier(image_resolution_,
+                    settings_.rectification_map_tolerance_px,
+                    thread_pool_.get()));
+  workspace->densifier.reset(new Densifier(
+      block_matching_params_, image_resolution_, thread_pool_.get()));
+  initializePointCloudMessage(&workspace->point_cloud_ros_msg);
+  return workspace;
+}
+
+void Stereo::releaseWorkspace(std::unique_ptr<PairWorkspace> workspace) {
+  CHECK(workspace);
+  std::lock_guard<std::mutex> lock(workspaces_mutex_);
+  workspaces_.push_back(std::move(workspace));
+}
+
+void Stereo::undistortAndRectify(
+    const StereoFrame& stereo_frame, Rectifier* rectifier,
+    cv::Mat* image_undistorted_1, cv::Mat* image_undistorted_2,
+    RectifiedStereoPair* rectified_stereo_pair) const {
+  CHECK_NOTNULL(rectifier);
+  CHECK_NOTNULL(image_undistorted_1);
+  CHECK_NOTNULL(image_undistorted_2);
+  CHECK_NOTNULL(rectified_stereo_pair);
+  // 1. Undistort raw images.
+  *image_undistorted_1 = stereo_frame.image_distorted_1;
+  *image_undistorted_2 = stereo_frame.image_distorted_2;
+  if (settings_.images_need_undistortion) {
+    undistortRawImages(stereo_frame.image_distorted_1,
+                       stereo_frame.image_distorted_2, image_undistorted_1,
+                       image_undistorted_2);
+  }
+
+  // 2. Rectify undistorted images.
+  rectifier->rectifyStereoPair(stereo_frame.stereo_rig_params,
+                               *image_undistorted_1, *image_undistorted_2,
+                               rectified_stereo_pair);
+
+  // Expected disparities from the terrain that is mapped already.
+  if (block_matching_params_.use_search_range_guidance &&
+      terrain_height_prior_) {
+    disparity_range_predictor_->predict(stereo_frame.stereo_rig_params,
+                                        *terrain_height_prior_,
+                                        rectified_stereo_pair);
+  }
+}
+
+void Stereo::triangulate(const StereoFrame& stereo_frame,
+                         const RectifiedStereoPair& rectified_stereo_pair,
+                         const Densifier& densifier,
+                         sensor_msgs::PointCloud2* point_cloud_ros_msg,
+                         DensifiedStereoPair* densified_stereo_pair) const {
+  CHECK_NOTNULL(point_cloud_ros_msg);
+  CHECK_NOTNULL(densified_stereo_pair);
+  // 3. Compute disparity map based on rectified images.
+  CHECK(rectified_stereo_pair.image_left.type() == CV_8UC1);
+  CHECK(rectified_stereo_pair.image_right.type() == CV_8UC1);
+  densifier.computeDisparityMap(rectified_stereo_pair, densified_stereo_pair);
+
+  // 4. Compute point cloud. Every point of the message is overwritten.
+  point_cloud_ros_msg->data.resize(point_cloud_ros_msg->row_step *
+                                   point_cloud_ros_msg->height);
+  point_cloud_ros_msg->header.stamp = ros::Time::now();
+  densifier.computePointCloud(stereo_frame.stereo_rig_params,
+                              rectified_stereo_pair, densified_stereo_pair,
+                              *point_cloud_ros_msg);
 }
 
 void Stereo::undistortRawImages(const cv::Mat& image_distorted_1,
@@ -201,9 +424,14 @@ void Stereo::undistortRawImages(const cv::Mat& image_distorted_1,
                                 cv::Mat* image_undistorted_2) const {
   CHECK_NOTNULL(image_undistorted_1);
   CHECK_NOTNULL(image_undistorted_2);
-  // Undistort the raw images.
-  undistorter_->processImage(image_distorted_1, image_undistorted_1);
-  undistorter_->processImage(image_distorted_2, image_undistorted_2);
+  // Undistort the raw images in parallel.
+  const cv::Mat* images_distorted[] = {&image_distorted_1, &image_distorted_2};
+  cv::Mat* images_undistorted[] = {image_undistorted_1, image_undistorted_2};
+  thread_pool_->parallelFor(2u, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      undistorter_->processImage(*images_distorted[i], images_undistorted[i]);
+    }
+  }, 1u);
 }
 
 void Stereo::visualizeRectification(
@@ -9,10 +9,17 @@
 #define DSM_H_
 
 // SYSTEM
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 // NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h>
+#include <aerial-mapper-utils/utils-bucket-grid.h>
+#include <aerial-mapper-utils/utils-downsampling.h>
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
+#include <aerial-mapper-utils/utils-thread-pool.h>
+#include <aerial-mapper-utils/utils-tiling.h>
 #include <Eigen/Dense>
 #include <grid_map_core/GridMap.hpp>
 #include <grid_map_core/iterators/GridMapIterator.hpp>
@@ -22,6 +29,9 @@
 
 namespace dsm {
 
+// Elevation of a cell computed from the points that fall into the cell.
+enum CellStatistic { Idw, Min, Max, Mean, Median };
+
 struct Settings {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   int interpolation_radius = 1.0;
@@ -29,25 +39,115 @@ struct Settings {
   double center_easting = 0.0;
   double center_northing = 0.0;
   bool use_multi_threads = true;
+  // Number of worker threads, 0 uses all hardware threads.
+  int num_threads = 0;
+  bool pin_threads_to_cores = false;
+  // Accumulate the points of all calls to process() and only update the cells
+  // that are affected by the new points. Otherwise, every call rebuilds the
+  // DSM from the passed point cloud alone.
+  bool incremental = false;
+  // Scatter the points into per-cell accumulators in a single pass instead of
+  // interpolating every cell with a radius search in the kd-tree.
+  bool use_grid_accumulation = false;
+  CellStatistic cell_statistic = CellStatistic::Idw;
+  // Cells without points take the elevation of the closest cell with points
+  // up to this distance [m]. A non-positive value disables hole filling.
+  double max_hole_filling_distance = 3.0;
+  // Batch kd-tree mode: the points are reduced to one per bin of this
+  // fraction of the map resolution before the kd-tree is built, see
+  // utils::downsamplePointCloud(). A non-positive value keeps all points.
+  double downsampling_bin_size_ratio = 0.0;
+  utils::BinStatistic downsampling_statistic = utils::BinStatistic::Mean;
 };
 
 class Dsm {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  Dsm(const Settings& settings, grid_map::GridMap* map);
+  Dsm(const Settings& settings, grid_map::GridMap* map = nullptr);
 
   void process(
       const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
       grid_map::GridMap* map);
 
+  /// Batch processing of single precision points relative to origin, e.g. of
+  /// a memory-mapped io::BinaryPointCloud. The kd-tree references the passed
+  /// arrays without copying them. Incremental mode, grid accumulation and
+  /// downsampling copy the points into a double precision point cloud.
+  void process(const PointCloudSoAView<float>& points,
+               const Eigen::Vector3d& origin, grid_map::GridMap* map);
+
+  /// Batch processing of a map that does not fit into memory. The elevation
+  /// layer is computed tile by tile; the search index is built only once.
+  /// With grid accumulation, holes are only filled from the same tile.
+  void process(
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      grid_map::TiledGridMap* tiled_map);
+
+  /// Cells of the elevation layer that were recomputed by the last call to
+  /// process(). Covers the whole map in batch mode.
+  inline const utils::CellRange& getLastUpdatedCells() const {
+    return last_updated_cells_;
+  }
+
  private:
+  /// Downsamples the points to bins of a fraction of the map resolution if
+  /// enabled in the settings.
   void initializeAndFillKdTree(
-      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud);
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      double resolution);
+
+  /// Builds the kd-tree on the points, whose x-y coordinates are relative to
+  /// cloud_origin. The points must stay valid while the kd-tree is used.
+  void buildKdTree(const PointCloudSoAView<float>& points,
+                   const Eigen::Vector2d& cloud_origin,
+                   double elevation_offset);
+
+  /// Adds the points to the accumulated point set and returns the cells whose
+  /// interpolated elevation can be affected by them.
+  utils::CellRange insertPoints(
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      const grid_map::GridMap& map);
 
-  void updateElevationLayer(grid_map::GridMap* map);
+  /// Radius search in the kd-tree (batch) or the accumulated points
+  /// (incremental). Like nanoflann, the radius is compared against squared
+  /// distances.
+  void findNeighbors(const grid_map::Position& position, double radius,
+                     std::vector<std::pair<int, double> >* indices_dists) const;
 
-  void updateElevationLayerMultiThreaded(grid_map::GridMap* map);
+  double getPointElevation(int point_index) const;
+
+  /// Inverse distance weighted elevation of the points around the position.
+  /// Returns false if no point is found within the (adaptive) search radius.
+  bool interpolateElevation(const grid_map::Position& position,
+                            double* elevation) const;
+
+  void updateElevationLayer(const utils::CellRange& cells,
+                            grid_map::GridMap* map);
+
+  void updateElevationLayerMultiThreaded(const utils::CellRange& cells,
+                                         grid_map::GridMap* map);
+
+  /// Sorts the points into the cells (counting sort) and reduces the points
+  /// of every cell to one elevation. Linear in the number of points and cells.
+  void updateElevationLayerGridAccumulation(
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      grid_map::GridMap* map);
+
+  /// Assigns the elevation of the closest cell with points to every cell
+  /// without points, based on a labeled distance transform.
+  void fillHoles(const std::vector<uint8_t>& cell_has_points,
+                 double resolution, grid_map::Matrix* layer_elevation) const;
+
+  /// Runs functor(begin, end) on the thread pool if available.
+  template <typename Functor>
+  void parallelFor(size_t num_items, const Functor& functor) const {
+    if (thread_pool_) {
+      thread_pool_->parallelFor(num_items, functor);
+    } else {
+      functor(size_t(0u), num_items);
+    }
+  }
 
   void printParams();
 
@@ -56,17 +156,29 @@ class Dsm {
   // kd Tree
   static constexpr size_t kMaxLeaf = 10u;
   static constexpr size_t kDimensionKdTree = 2u;
-  typedef PointCloudAdaptor<PointCloud<double> > PC2KD;
+  typedef PointCloudSoAAdaptor2D<float> PC2KD;
   typedef nanoflann::KDTreeSingleIndexAdaptor<
-      nanoflann::L2_Adaptor<double, PC2KD>, PC2KD, kDimensionKdTree>
+      nanoflann::L2_Adaptor<float, PC2KD, double>, PC2KD, kDimensionKdTree>
       my_kd_tree_t;
-  PointCloud<double> cloud_kdtree_;
+  // Single precision coordinates relative to cloud_origin_, which keeps the
+  // precision for georeferenced clouds. The kd-tree either references
+  // cloud_kdtree_ or the points passed to process().
+  PointCloudSoA<float> cloud_kdtree_;
+  Eigen::Vector2d cloud_origin_;
+  double cloud_elevation_offset_;
   std::unique_ptr<my_kd_tree_t> kd_tree_;
   std::unique_ptr<PC2KD> pc2kd_;
 
-  // Multi-threading.
-  std::unordered_map<size_t, grid_map::Index> map_sample_to_cell_index_;
-  std::vector<size_t> samples_idx_range_;
+  // Upper bound of the adaptive search radius.
+  static constexpr double kMaxInterpolationRadius = 7.0;
+
+  // Incremental mode: all points received so far.
+  std::unique_ptr<utils::PointBucketGrid> accumulated_points_;
+  utils::CellRange last_updated_cells_;
+
+  // Multi-threading: cells are handed out to the workers in square tiles.
+  static constexpr int kTileSizeCells = 64;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
 };
 
 }  // namespace dsm
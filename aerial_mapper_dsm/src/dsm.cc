@@ -9,100 +9,224 @@
 #include "aerial-mapper-dsm/dsm.h"
 
 // SYSTEM
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <limits>
+#include <numeric>
 
 // NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
 #include <aerial-mapper-utils/utils-common.h>
 #include <glog/logging.h>
+#include <grid_map_core/iterators/SubmapIterator.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 
 namespace dsm {
 
+constexpr double Dsm::kMaxInterpolationRadius;
+
 Dsm::Dsm(const Settings& settings, grid_map::GridMap* map)
-    : settings_(settings) {
-  CHECK(map);
+    : settings_(settings),
+      cloud_origin_(Eigen::Vector2d::Zero()),
+      cloud_elevation_offset_(0.0) {
   printParams();
   if (settings_.use_multi_threads) {
-    // Create one sample for every cell.
-    samples_idx_range_.clear();
-    size_t sample_counter = 0u;
-    for (grid_map::GridMapIterator it(*map); !it.isPastEnd(); ++it) {
-      samples_idx_range_.push_back(sample_counter);
-      map_sample_to_cell_index_.insert(std::make_pair(sample_counter, *it));
-      ++sample_counter;
-    }
+    utils::ThreadPoolSettings thread_pool_settings;
+    thread_pool_settings.num_threads = std::max(settings_.num_threads, 0);
+    thread_pool_settings.pin_threads_to_cores = settings_.pin_threads_to_cores;
+    thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
+  }
+  CHECK(!(settings_.incremental && settings_.use_grid_accumulation))
+      << "Grid accumulation is only supported in batch mode.";
+  if (settings_.incremental) {
+    // Buckets as large as the largest search radius, such that every search
+    // visits at most 3x3 buckets.
+    accumulated_points_.reset(new utils::PointBucketGrid(std::sqrt(
+        std::max<double>(settings_.interpolation_radius,
+                         kMaxInterpolationRadius))));
   }
 }
 
 void Dsm::initializeAndFillKdTree(
-    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud) {
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud_raw,
+    double resolution) {
+  AlignedType<std::vector, Eigen::Vector3d>::type point_cloud_downsampled;
+  if (settings_.downsampling_bin_size_ratio > 0.0) {
+    utils::DownsamplingSettings downsampling_settings;
+    downsampling_settings.bin_size_m =
+        settings_.downsampling_bin_size_ratio * resolution;
+    downsampling_settings.statistic = settings_.downsampling_statistic;
+    utils::downsamplePointCloud(downsampling_settings, point_cloud_raw,
+                                nullptr, &point_cloud_downsampled, nullptr,
+                                thread_pool_.get());
+    LOG(INFO) << "Downsampled " << point_cloud_raw.size() << " to "
+              << point_cloud_downsampled.size() << " points";
+  }
+  const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud =
+      settings_.downsampling_bin_size_ratio > 0.0 ? point_cloud_downsampled
+                                                  : point_cloud_raw;
+
   // Insert pointcloud in kdtree.
-  cloud_kdtree_.pts.resize(point_cloud.size());
+  cloud_kdtree_.resize(point_cloud.size());
   LOG(INFO) << "Num points: " << point_cloud.size();
+  CHECK(!point_cloud.empty());
+  const Eigen::Vector2d cloud_origin =
+      point_cloud[0].head<2>() -
+      Eigen::Vector2d(settings_.center_northing, settings_.center_easting);
   for (size_t i = 0u; i < point_cloud.size(); ++i) {
-    cloud_kdtree_.pts[i].x = point_cloud[i](0) - settings_.center_northing;
-    cloud_kdtree_.pts[i].y = point_cloud[i](1) - settings_.center_easting;
-    cloud_kdtree_.pts[i].z = point_cloud[i](2);
+    cloud_kdtree_.x[i] = static_cast<float>(
+        point_cloud[i](0) - settings_.center_northing - cloud_origin.x());
+    cloud_kdtree_.y[i] = static_cast<float>(
+        point_cloud[i](1) - settings_.center_easting - cloud_origin.y());
+    cloud_kdtree_.z[i] = static_cast<float>(point_cloud[i](2));
   }
+  buildKdTree(PointCloudSoAView<float>(cloud_kdtree_), cloud_origin, 0.0);
+}
 
-  pc2kd_.reset(new PC2KD(cloud_kdtree_));
+void Dsm::buildKdTree(const PointCloudSoAView<float>& points,
+                      const Eigen::Vector2d& cloud_origin,
+                      double elevation_offset) {
+  cloud_origin_ = cloud_origin;
+  cloud_elevation_offset_ = elevation_offset;
+  pc2kd_.reset(new PC2KD(points));
   kd_tree_.reset(
       new my_kd_tree_t(kDimensionKdTree, *pc2kd_,
                        nanoflann::KDTreeSingleIndexAdaptorParams(kMaxLeaf)));
   kd_tree_->buildIndex();
 }
 
-void Dsm::updateElevationLayer(grid_map::GridMap* map) {
-  CHECK(map);
-  const ros::Time time1 = ros::Time::now();
-  for (grid_map::GridMapIterator it(*map); !it.isPastEnd(); ++it) {
-    grid_map::Position position;
-    map->getPosition(*it, position);
-    std::vector<std::pair<int, double> > indices_dists;
-    nanoflann::RadiusResultSet<double, int> result_set(
-        settings_.interpolation_radius, indices_dists);
-    const double query_pt[3] = {position.x(), position.y(), 0.0};
+utils::CellRange Dsm::insertPoints(
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    const grid_map::GridMap& map) {
+  CHECK(accumulated_points_);
+  Eigen::Vector2d min_xy =
+      Eigen::Vector2d::Constant(std::numeric_limits<double>::max());
+  Eigen::Vector2d max_xy = -min_xy;
+  for (const Eigen::Vector3d& point : point_cloud) {
+    const Eigen::Vector2d xy(point(0) - settings_.center_northing,
+                             point(1) - settings_.center_easting);
+    accumulated_points_->insert(xy.x(), xy.y(), point(2));
+    min_xy = min_xy.cwiseMin(xy);
+    max_xy = max_xy.cwiseMax(xy);
+  }
+  LOG(INFO) << "Num points: " << point_cloud.size() << " (accumulated: "
+            << accumulated_points_->size() << ")";
+
+  // Cells further away than the largest search radius cannot see the new
+  // points. The radius is compared against squared distances.
+  const double max_search_distance = std::sqrt(std::max<double>(
+      settings_.interpolation_radius, kMaxInterpolationRadius));
+  const Eigen::Vector2d padding =
+      Eigen::Vector2d::Constant(max_search_distance + map.getResolution());
+  min_xy -= padding;
+  max_xy += padding;
+
+  const Eigen::Vector2d half_length = 0.5 * map.getLength().matrix();
+  const Eigen::Vector2d map_min = map.getPosition() - half_length;
+  const Eigen::Vector2d map_max = map.getPosition() + half_length;
+  if ((max_xy.array() < map_min.array()).any() ||
+      (min_xy.array() > map_max.array()).any()) {
+    return utils::CellRange();
+  }
+
+  // Clamp to cell centers inside the map before converting to indices.
+  const Eigen::Vector2d margin =
+      Eigen::Vector2d::Constant(0.5 * map.getResolution());
+  min_xy = min_xy.cwiseMax(map_min + margin).cwiseMin(map_max - margin);
+  max_xy = max_xy.cwiseMax(map_min + margin).cwiseMin(map_max - margin);
+  grid_map::Index index_min_xy, index_max_xy;
+  CHECK(map.getIndex(grid_map::Position(min_xy), index_min_xy));
+  CHECK(map.getIndex(grid_map::Position(max_xy), index_max_xy));
+  const grid_map::Index start = index_min_xy.min(index_max_xy);
+  return utils::CellRange(start, index_min_xy.max(index_max_xy) - start + 1)
+      .intersect(utils::CellRange(grid_map::Index::Zero(), map.getSize()));
+}
+
+void Dsm::findNeighbors(
+    const grid_map::Position& position, double radius,
+    std::vector<std::pair<int, double> >* indices_dists) const {
+  CHECK_NOTNULL(indices_dists);
+  indices_dists->clear();
+  if (settings_.incremental) {
+    accumulated_points_->radiusSearch(position.x(), position.y(), radius,
+                                      indices_dists);
+  } else {
+    nanoflann::RadiusResultSet<double, int> result_set(radius,
+                                                       *indices_dists);
+    const float query_pt[2] = {
+        static_cast<float>(position.x() - cloud_origin_.x()),
+        static_cast<float>(position.y() - cloud_origin_.y())};
     kd_tree_->findNeighbors(result_set, query_pt, nanoflann::SearchParams());
+  }
+}
 
-    if (true) {
-      double lambda = 1.0;
-      while (result_set.size() == 0u) {
-        nanoflann::RadiusResultSet<double, int> tmp(
-            lambda * settings_.interpolation_radius, indices_dists);
-        kd_tree_->findNeighbors(tmp, query_pt, nanoflann::SearchParams());
-        lambda *= 1.1;
-        if (lambda * settings_.interpolation_radius > 7.0) {
-          break;
-        }
+double Dsm::getPointElevation(int point_index) const {
+  if (settings_.incremental) {
+    return accumulated_points_->getPoint(point_index).z;
+  }
+  return pc2kd_->view.z[point_index] + cloud_elevation_offset_;
+}
+
+bool Dsm::interpolateElevation(const grid_map::Position& position,
+                               double* elevation) const {
+  CHECK_NOTNULL(elevation);
+  std::vector<std::pair<int, double> > indices_dists;
+  findNeighbors(position, settings_.interpolation_radius, &indices_dists);
+
+  if (true) {
+    double lambda = 1.0;
+    while (indices_dists.empty()) {
+      findNeighbors(position, lambda * settings_.interpolation_radius,
+                    &indices_dists);
+      lambda *= 1.1;
+      if (lambda * settings_.interpolation_radius > kMaxInterpolationRadius) {
+        break;
       }
     }
+  }
 
-    bool samples_in_interpolation_radius = result_set.size() > 0u;
-    if (samples_in_interpolation_radius) {
-      std::vector<double> distances;
-      std::vector<double> heights;
-      CHECK(result_set.size() > 0);
-      distances.clear();
-      heights.clear();
-      for (const std::pair<int, double>& s : result_set.m_indices_dists) {
-        distances.push_back(s.second);
-        heights.push_back(cloud_kdtree_.pts[s.first].z);
-      }
-      CHECK(distances.size() > 0u);
-      CHECK(heights.size() > 0u);
-      CHECK(distances.size() == heights.size());
-      double idw_numerator = 0.0;
-      double idw_denominator = 0.0;
-      bool idw_perfect_match = false;
-      for (size_t i = 0u; i < heights.size(); ++i) {
-        if (!idw_perfect_match) {
-          CHECK(distances[i] > 0.0);
-          idw_numerator += heights[i] / (distances[i]);
-          idw_denominator += 1.0 / (distances[i]);
-        }
-      }
-      CHECK(idw_denominator > 0.0);
-      double idw_height = idw_numerator / idw_denominator;
-      map->at("elevation", *it) = idw_height;
+  bool samples_in_interpolation_radius = !indices_dists.empty();
+  if (!samples_in_interpolation_radius) {
+    return false;
+  }
+  std::vector<double> distances;
+  std::vector<double> heights;
+  for (const std::pair<int, double>& s : indices_dists) {
+    distances.push_back(s.second);
+    heights.push_back(getPointElevation(s.first));
+  }
+  CHECK(distances.size() > 0u);
+  CHECK(heights.size() > 0u);
+  CHECK(distances.size() == heights.size());
+  double idw_numerator = 0.0;
+  double idw_denominator = 0.0;
+  bool idw_perfect_match = false;
+  for (size_t i = 0u; i < heights.size(); ++i) {
+    if (!idw_perfect_match) {
+      CHECK(distances[i] > 0.0);
+      idw_numerator += heights[i] / (distances[i]);
+      idw_denominator += 1.0 / (distances[i]);
+    }
+  }
+  CHECK(idw_denominator > 0.0);
+  *elevation = idw_numerator / idw_denominator;
+  return true;
+}
+
+void Dsm::updateElevationLayer(const utils::CellRange& cells,
+                               grid_map::GridMap* map) {
+  CHECK(map);
+  const ros::Time time1 = ros::Time::now();
+  grid_map::Matrix& layer_elevation =
+      grid_map::getOrCreateLayer("elevation", map);
+  for (grid_map::SubmapIterator it(*map, cells.start, cells.size);
+       !it.isPastEnd(); ++it) {
+    grid_map::Position position;
+    map->getPosition(*it, position);
+    double idw_height;
+    if (interpolateElevation(position, &idw_height)) {
+      layer_elevation((*it)(0), (*it)(1)) = idw_height;
     }
   }
   const ros::Time time2 = ros::Time::now();
@@ -110,96 +234,325 @@ void Dsm::updateElevationLayer(grid_map::GridMap* map) {
   VLOG(1) << "dt(update-dsm, single-thread): " << delta_time;
 }
 
-void Dsm::updateElevationLayerMultiThreaded(grid_map::GridMap* map) {
+void Dsm::updateElevationLayerMultiThreaded(const utils::CellRange& cells,
+                                            grid_map::GridMap* map) {
   CHECK(map);
   const ros::Time time1 = ros::Time::now();
-  grid_map::Matrix& layer_elevation = (*map)["elevation"];
-
-  auto generateCellWiseDsm = [&](const std::vector<size_t>& sample_idx_range_) {
-    for (size_t sample_idx : sample_idx_range_) {
-      grid_map::Index index = map_sample_to_cell_index_.at(sample_idx);
-      double x = index(0);
-      double y = index(1);
-
-      grid_map::Position position;
-      map->getPosition(index, position);
-
-      std::vector<std::pair<int, double> > indices_dists;
-      nanoflann::RadiusResultSet<double, int> result_set(
-          settings_.interpolation_radius, indices_dists);
-      const double query_pt[3] = {position.x(), position.y(), 0.0};
-      kd_tree_->findNeighbors(result_set, query_pt, nanoflann::SearchParams());
-
-      if (true) {
-        double lambda = 1.0;
-        while (result_set.size() == 0u) {
-          nanoflann::RadiusResultSet<double, int> tmp(
-              lambda * settings_.interpolation_radius, indices_dists);
-          kd_tree_->findNeighbors(tmp, query_pt, nanoflann::SearchParams());
-          lambda *= 1.1;
-          if (lambda * settings_.interpolation_radius > 7.0) {
-            break;
-          }
+  grid_map::Matrix& layer_elevation =
+      grid_map::getOrCreateLayer("elevation", map);
+
+  auto generateTileWiseDsm = [&](size_t /*tile_index*/,
+                                 const utils::CellRange& tile) {
+    const grid_map::Index tile_end = tile.getEnd();
+    for (int y = tile.start(1); y < tile_end(1); ++y) {
+      for (int x = tile.start(0); x < tile_end(0); ++x) {
+        grid_map::Position position;
+        map->getPosition(grid_map::Index(x, y), position);
+        double idw_height;
+        if (interpolateElevation(position, &idw_height)) {
+          layer_elevation(x, y) = idw_height;
         }
       }
+    }
+  };
 
-      bool samples_in_interpolation_radius = result_set.size() > 0u;
-      if (samples_in_interpolation_radius) {
-        std::vector<double> distances;
-        std::vector<double> heights;
-        CHECK(result_set.size() > 0);
-        distances.clear();
-        heights.clear();
-        for (const std::pair<int, double>& s : result_set.m_indices_dists) {
-          distances.push_back(s.second);
-          heights.push_back(cloud_kdtree_.pts[s.first].z);
-        }
-        CHECK(distances.size() > 0u);
-        CHECK(heights.size() > 0u);
-        CHECK(distances.size() == heights.size());
-        double idw_numerator = 0.0;
-        double idw_denominator = 0.0;
-        bool idw_perfect_match = false;
-        for (size_t i = 0u; i < heights.size(); ++i) {
-          if (!idw_perfect_match) {
-            CHECK(distances[i] > 0.0);
-            idw_numerator += heights[i] / (distances[i]);
-            idw_denominator += 1.0 / (distances[i]);
+  const utils::CellTiling tiling(map->getSize(), kTileSizeCells);
+  utils::parForTiles(tiling, cells, generateTileWiseDsm, thread_pool_.get());
+
+  const ros::Time time2 = ros::Time::now();
+  const ros::Duration& delta_time = time2 - time1;
+  VLOG(1) << "dt(update-dsm, multi-thread): " << delta_time;
+}
+
+void Dsm::updateElevationLayerGridAccumulation(
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    grid_map::GridMap* map) {
+  CHECK(map);
+  const ros::Time time1 = ros::Time::now();
+  const grid_map::Size map_size = map->getSize();
+  const size_t num_cells = static_cast<size_t>(map_size.prod());
+  const size_t num_points = point_cloud.size();
+  const bool use_idw = settings_.cell_statistic == CellStatistic::Idw;
+
+  // 1. Cell of every point (linear, column-major like the layers) and its
+  // IDW weight w.r.t. the cell center.
+  static constexpr size_t kOutsideMap = std::numeric_limits<size_t>::max();
+  std::vector<size_t> point_cells(num_points);
+  std::vector<float> point_weights(use_idw ? num_points : 0u);
+  parallelFor(num_points, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const grid_map::Position position(
+          point_cloud[i](0) - settings_.center_northing,
+          point_cloud[i](1) - settings_.center_easting);
+      grid_map::Index index;
+      if (!map->getIndex(position, index)) {
+        point_cells[i] = kOutsideMap;
+        continue;
+      }
+      point_cells[i] = static_cast<size_t>(index(0)) +
+                       static_cast<size_t>(index(1)) * map_size(0);
+      if (use_idw) {
+        grid_map::Position cell_center;
+        map->getPosition(index, cell_center);
+        // Squared distance, like in the kd-tree based interpolation.
+        static constexpr double kMinSquaredDistance = 1e-6;
+        point_weights[i] = static_cast<float>(
+            1.0 / std::max((position - cell_center).squaredNorm(),
+                           kMinSquaredDistance));
+      }
+    }
+  });
+
+  // 2. Counting sort of the points by cell: the heights (and weights) of
+  // cell k are stored in [cell_begin[k], cell_begin[k + 1]).
+  std::vector<size_t> cell_begin(num_cells + 1u, 0u);
+  for (const size_t cell : point_cells) {
+    if (cell != kOutsideMap) {
+      ++cell_begin[cell + 1u];
+    }
+  }
+  std::partial_sum(cell_begin.begin(), cell_begin.end(), cell_begin.begin());
+  std::vector<size_t> cell_end(cell_begin.begin(), cell_begin.end() - 1);
+  std::vector<float> heights(cell_begin.back());
+  std::vector<float> weights(use_idw ? cell_begin.back() : 0u);
+  for (size_t i = 0u; i < num_points; ++i) {
+    if (point_cells[i] == kOutsideMap) {
+      continue;
+    }
+    const size_t k = cell_end[point_cells[i]]++;
+    heights[k] = static_cast<float>(point_cloud[i](2));
+    if (use_idw) {
+      weights[k] = point_weights[i];
+    }
+  }
+  LOG(INFO) << "Num points: " << num_points
+            << " (inside map: " << heights.size() << ")";
+
+  // 3. Reduce the points of every cell.
+  grid_map::Matrix& layer_elevation =
+      grid_map::getOrCreateLayer("elevation", map);
+  float* elevation = layer_elevation.data();
+  std::vector<uint8_t> cell_has_points(num_cells, 0u);
+  parallelFor(num_cells, [&](size_t begin, size_t end) {
+    for (size_t cell = begin; cell < end; ++cell) {
+      const size_t first = cell_begin[cell];
+      const size_t last = cell_begin[cell + 1u];
+      if (first == last) {
+        continue;
+      }
+      cell_has_points[cell] = 1u;
+      switch (settings_.cell_statistic) {
+        case CellStatistic::Idw: {
+          double idw_numerator = 0.0;
+          double idw_denominator = 0.0;
+          for (size_t k = first; k < last; ++k) {
+            idw_numerator += weights[k] * heights[k];
+            idw_denominator += weights[k];
           }
+          elevation[cell] = static_cast<float>(idw_numerator / idw_denominator);
+          break;
+        }
+        case CellStatistic::Min:
+          elevation[cell] = *std::min_element(heights.begin() + first,
+                                              heights.begin() + last);
+          break;
+        case CellStatistic::Max:
+          elevation[cell] = *std::max_element(heights.begin() + first,
+                                              heights.begin() + last);
+          break;
+        case CellStatistic::Mean:
+          elevation[cell] = static_cast<float>(
+              std::accumulate(heights.begin() + first, heights.begin() + last,
+                              0.0) /
+              static_cast<double>(last - first));
+          break;
+        case CellStatistic::Median: {
+          // The heights of a cell are only used here, so they can be
+          // partially sorted in place.
+          std::vector<float>::iterator median =
+              heights.begin() + first + (last - first) / 2u;
+          std::nth_element(heights.begin() + first, median,
+                           heights.begin() + last);
+          elevation[cell] = *median;
+          break;
         }
-        CHECK(idw_denominator > 0.0);
-        double idw_height = idw_numerator / idw_denominator;
-        layer_elevation(x, y) = idw_height;
       }
-    }  // loop samples
-  };   // lambda function
+    }
+  });
 
-  const size_t num_samples = samples_idx_range_.size();
-  const size_t num_threads = std::thread::hardware_concurrency();
-  utils::parFor(num_samples, generateCellWiseDsm, num_threads);
+  // 4. Fill the cells without points.
+  if (settings_.max_hole_filling_distance > 0.0) {
+    fillHoles(cell_has_points, map->getResolution(), &layer_elevation);
+  }
 
   const ros::Time time2 = ros::Time::now();
   const ros::Duration& delta_time = time2 - time1;
-  VLOG(1) << "dt(update-dsm, multi-thread): " << delta_time;
+  VLOG(1) << "dt(update-dsm, grid accumulation): " << delta_time;
+}
+
+void Dsm::fillHoles(const std::vector<uint8_t>& cell_has_points,
+                    double resolution,
+                    grid_map::Matrix* layer_elevation) const {
+  CHECK_NOTNULL(layer_elevation);
+  // The column-major layer with rows = size(0) is a row-major image with
+  // rows = size(1), i.e. cell k is pixel k in both.
+  const int rows = static_cast<int>(layer_elevation->cols());
+  const int cols = static_cast<int>(layer_elevation->rows());
+  CHECK_EQ(cell_has_points.size(), static_cast<size_t>(rows) * cols);
+
+  // Source cells are the zero pixels of the distance transform. Their labels
+  // are assigned in scan order, starting at 1.
+  cv::Mat holes(rows, cols, CV_8UC1);
+  std::vector<float> elevation_of_label(1u, NAN);
+  float* elevation = layer_elevation->data();
+  for (size_t cell = 0u; cell < cell_has_points.size(); ++cell) {
+    holes.data[cell] = cell_has_points[cell] ? 0u : 1u;
+    if (cell_has_points[cell]) {
+      elevation_of_label.push_back(elevation[cell]);
+    }
+  }
+  if (elevation_of_label.size() == 1u) {
+    LOG(WARNING) << "No cell contains points, skip hole filling.";
+    return;
+  }
+
+  cv::Mat distances, labels;
+  cv::distanceTransform(holes, distances, labels, cv::DIST_L2,
+                        cv::DIST_MASK_5, cv::DIST_LABEL_PIXEL);
+  const float max_distance_pixels =
+      static_cast<float>(settings_.max_hole_filling_distance / resolution);
+  const float* distance = distances.ptr<float>();
+  const int* label = labels.ptr<int>();
+  size_t num_filled = 0u;
+  for (size_t cell = 0u; cell < cell_has_points.size(); ++cell) {
+    if (!cell_has_points[cell] && distance[cell] <= max_distance_pixels) {
+      elevation[cell] = elevation_of_label[label[cell]];
+      ++num_filled;
+    }
+  }
+  VLOG(1) << "Filled " << num_filled << " cells without points.";
 }
 
 void Dsm::process(
     const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
     grid_map::GridMap* map) {
+  last_updated_cells_ = utils::CellRange();
   if (point_cloud.empty()) {
     LOG(WARNING) << "Passed empty point cloud to DSM module";
     return;
   }
 
   CHECK(map);
-  initializeAndFillKdTree(point_cloud);
+  if (settings_.use_grid_accumulation) {
+    last_updated_cells_ =
+        utils::CellRange(grid_map::Index::Zero(), map->getSize());
+    updateElevationLayerGridAccumulation(point_cloud, map);
+    return;
+  }
+  if (settings_.incremental) {
+    last_updated_cells_ = insertPoints(point_cloud, *map);
+    if (last_updated_cells_.isEmpty()) {
+      LOG(WARNING) << "New points are outside of the map";
+      return;
+    }
+  } else {
+    initializeAndFillKdTree(point_cloud, map->getResolution());
+    last_updated_cells_ =
+        utils::CellRange(grid_map::Index::Zero(), map->getSize());
+  }
   if (settings_.use_multi_threads) {
-    updateElevationLayerMultiThreaded(map);
+    updateElevationLayerMultiThreaded(last_updated_cells_, map);
   } else {
-    updateElevationLayer(map);
+    updateElevationLayer(last_updated_cells_, map);
   }
 }
 
+void Dsm::process(const PointCloudSoAView<float>& points,
+                  const Eigen::Vector3d& origin, grid_map::GridMap* map) {
+  if (settings_.incremental || settings_.use_grid_accumulation ||
+      settings_.downsampling_bin_size_ratio > 0.0) {
+    AlignedType<std::vector, Eigen::Vector3d>::type point_cloud(
+        points.num_points);
+    for (size_t i = 0u; i < points.num_points; ++i) {
+      point_cloud[i] =
+          origin + Eigen::Vector3d(points.x[i], points.y[i], points.z[i]);
+    }
+    process(point_cloud, map);
+    return;
+  }
+
+  last_updated_cells_ = utils::CellRange();
+  if (points.num_points == 0u) {
+    LOG(WARNING) << "Passed empty point cloud to DSM module";
+    return;
+  }
+  CHECK(map);
+  LOG(INFO) << "Num points: " << points.num_points;
+  buildKdTree(points,
+              origin.head<2>() - Eigen::Vector2d(settings_.center_northing,
+                                                 settings_.center_easting),
+              origin.z());
+  last_updated_cells_ =
+      utils::CellRange(grid_map::Index::Zero(), map->getSize());
+  if (settings_.use_multi_threads) {
+    updateElevationLayerMultiThreaded(last_updated_cells_, map);
+  } else {
+    updateElevationLayer(last_updated_cells_, map);
+  }
+}
+
+void Dsm::process(
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    grid_map::TiledGridMap* tiled_map) {
+  CHECK(tiled_map);
+  CHECK(!settings_.incremental)
+      << "Tiled maps are only supported in batch mode.";
+  if (point_cloud.empty()) {
+    LOG(WARNING) << "Passed empty point cloud to DSM module";
+    return;
+  }
+
+  if (settings_.use_grid_accumulation) {
+    // Pass every tile only the points that fall into it.
+    std::vector<std::vector<size_t> > points_per_tile(
+        tiled_map->getNumTiles());
+    for (size_t i = 0u; i < point_cloud.size(); ++i) {
+      const grid_map::Position position(
+          point_cloud[i](0) - settings_.center_northing,
+          point_cloud[i](1) - settings_.center_easting);
+      size_t tile_index;
+      if (tiled_map->getTileIndex(position, &tile_index)) {
+        points_per_tile[tile_index].push_back(i);
+      }
+    }
+    AlignedType<std::vector, Eigen::Vector3d>::type tile_points;
+    for (size_t tile_index = 0u; tile_index < points_per_tile.size();
+         ++tile_index) {
+      if (points_per_tile[tile_index].empty()) {
+        continue;
+      }
+      tile_points.clear();
+      for (const size_t i : points_per_tile[tile_index]) {
+        tile_points.push_back(point_cloud[i]);
+      }
+      updateElevationLayerGridAccumulation(tile_points,
+                                           tiled_map->getTile(tile_index));
+    }
+    return;
+  }
+
+  initializeAndFillKdTree(point_cloud, tiled_map->getResolution());
+  tiled_map->forEachTile([this](size_t /*tile_index*/,
+                                grid_map::GridMap* tile) {
+    const utils::CellRange all_cells(grid_map::Index::Zero(), tile->getSize());
+    if (settings_.use_multi_threads) {
+      updateElevationLayerMultiThreaded(all_cells, tile);
+    } else {
+      updateElevationLayer(all_cells, tile);
+    }
+  });
+}
+
 void Dsm::printParams() {
   std::stringstream out;
   out << std::endl << std::string(50, '*') << std::endl
@@ -209,6 +562,16 @@ void Dsm::printParams() {
                               settings_.adaptive_interpolation)
       << utils::paramToString("Center easting", settings_.center_easting)
       << utils::paramToString("Center northing", settings_.center_northing)
+      << utils::paramToString("Use multi threads", settings_.use_multi_threads)
+      << utils::paramToString("Num. threads", settings_.num_threads)
+      << utils::paramToString("Incremental", settings_.incremental)
+      << utils::paramToString("Grid accumulation",
+                              settings_.use_grid_accumulation)
+      << utils::paramToString("Cell statistic", settings_.cell_statistic)
+      << utils::paramToString("Max. hole filling dist.",
+                              settings_.max_hole_filling_distance)
+      << utils::paramToString("Downsampling bin ratio",
+                              settings_.downsampling_bin_size_ratio)
       << std::string(50, '*') << std::endl;
   LOG(INFO) << out.str();
 }
@@ -0,0 +1,86 @@
+/*
+ *    Filename: aerial-mapper-elevation-bounds.h
+ *  Created on: Oct 16, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_ELEVATION_BOUNDS_H_
+#define AERIAL_MAPPER_ELEVATION_BOUNDS_H_
+
+// SYSTEM
+#include <mutex>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-tiling.h>
+#include <Eigen/Dense>
+#include <grid_map_core/GridMap.hpp>
+
+namespace grid_map {
+
+/// Minimum and maximum of the elevation layer of blocks of cells. Updated
+/// with the cells that changed (e.g. dsm::Dsm::getLastUpdatedCells()), so a
+/// query neither locks the map nor visits every cell. Thread-safe.
+class ElevationBounds {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// Takes the geometry of the map, which must not be moved afterwards. All
+  /// blocks are unknown until they are updated.
+  explicit ElevationBounds(const GridMap& map);
+
+  /// True if the map has the geometry the bounds were created for.
+  bool hasGeometryOf(const GridMap& map) const;
+
+  /// Updates the blocks that contain the cells. The caller must hold the
+  /// lock of the map.
+  void update(const GridMap& map, const utils::CellRange& cells);
+
+  /// Range of all elevations passed to update() so far, which contains the
+  /// range of the map. Returns false if there was no finite elevation.
+  bool getElevationRange(double* min_elevation, double* max_elevation) const;
+
+  /// Elevation range of the cells. The blocks are coarser than the cells,
+  /// which only widens the range. Returns false if no cell has an elevation.
+  bool getElevationRange(const utils::CellRange& cells, double* min_elevation,
+                         double* max_elevation) const;
+
+  /// Elevation range of the cells within the box of positions.
+  bool getElevationRange(const Eigen::Vector2d& min_xy,
+                         const Eigen::Vector2d& max_xy, double* min_elevation,
+                         double* max_elevation) const;
+
+ private:
+  /// Cells within the box, clamped to the map.
+  utils::CellRange getCells(const Eigen::Vector2d& min_xy,
+                            const Eigen::Vector2d& max_xy) const;
+
+  /// Blocks that contain any of the cells.
+  utils::CellRange getBlocks(const utils::CellRange& cells) const;
+
+  inline size_t getBlockIndex(int x, int y) const {
+    return static_cast<size_t>(x) + static_cast<size_t>(y) * num_blocks_(0);
+  }
+
+  static constexpr int kBlockSizeCells = 16;
+
+  // Geometry of the map.
+  Eigen::Vector2d map_min_;
+  Eigen::Vector2d map_max_;
+  double resolution_;
+  Eigen::Array2i map_size_;
+  Eigen::Array2i num_blocks_;
+
+  // Elevation range of every block, NaN if no cell has an elevation.
+  mutable std::mutex mutex_;
+  std::vector<float> min_elevations_;
+  std::vector<float> max_elevations_;
+  // Range of all elevations passed to update(), only widened.
+  float min_elevation_;
+  float max_elevation_;
+};
+
+}  // namespace grid_map
+
+#endif  // AERIAL_MAPPER_ELEVATION_BOUNDS_H_
@@ -8,6 +8,13 @@
 #ifndef AERIAL_MAPPER_GRID_MAP_H_
 #define AERIAL_MAPPER_GRID_MAP_H_
 
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -26,18 +33,55 @@ struct Settings {
   double delta_easting;
   double delta_northing;
   double resolution;
+  // Layers that are allocated when the map is created. All other layers are
+  // created on first access through getOrCreateLayer(), so layers that are
+  // not used by a pipeline cost neither memory nor fill time.
+  std::vector<std::string> layers;
+  // Layers that are published, all existing layers if empty.
+  std::vector<std::string> published_layers;
+  // Maximum rate of the background publisher and of publishUntilShutdown().
+  double max_publish_rate_hz = 1.0;
 };
 
+/// Value of the cells of a layer that have not been written yet.
+float getLayerDefaultValue(const std::string& layer);
+
+/// Returns the layer, after adding it filled with its default value if it
+/// does not exist yet. Not thread-safe: create all layers before accessing
+/// the map from multiple threads.
+grid_map::Matrix& getOrCreateLayer(const std::string& layer,
+                                   grid_map::GridMap* map);
+
 class AerialGridMap{
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   AerialGridMap(const Settings& settings);
 
+  /// Stops the background publisher.
+  ~AerialGridMap();
+
+  /// Publishes the whole map at max_publish_rate_hz until ROS shuts down.
   void publishUntilShutdown();
 
   void publishOnce();
 
+  /// Publishes the cells [start, start + size) as a submap on the
+  /// "grid_map_update" topic, e.g. the cells that changed since the last
+  /// publication.
+  void publishOnce(const grid_map::Index& start, const grid_map::Size& size);
+
+  /// Copies the cells [start, start + size) of the published layers and hands
+  /// them to a background thread, which serializes and publishes them on the
+  /// "grid_map_update" topic at most at max_publish_rate_hz. Changes that
+  /// arrive before the previous ones are published are merged into one
+  /// submap. Only the copy runs on the calling thread, so the mapping thread
+  /// is never blocked by serialization.
+  void publishAsync(const grid_map::Index& start, const grid_map::Size& size);
+
+  /// Publishes the pending changes and stops the background publisher.
+  void stopPublishing();
+
   grid_map::GridMap* getMutable() {
     return &map_;
   }
@@ -46,11 +90,31 @@ private:
 
   void initialize();
 
+  std::vector<std::string> getPublishedLayers() const;
+
+  /// Copies the published layers of the cells [start, start + size). Returns
+  /// false if the cells exceed the map.
+  bool extractSubmap(const grid_map::Index& start, const grid_map::Size& size,
+                     grid_map::GridMap* submap) const;
+
+  void publishInBackground();
+
   grid_map::GridMap map_;
 
   Settings settings_;
   ros::NodeHandle node_handle_;
   ros::Publisher pub_grid_map_;
+  ros::Publisher pub_grid_map_update_;
+
+  // Background publisher.
+  std::thread publisher_thread_;
+  std::mutex publisher_mutex_;
+  std::condition_variable publisher_condition_;
+  bool stop_publisher_;
+  bool has_pending_submap_;
+  grid_map::Index pending_start_;
+  grid_map::Size pending_size_;
+  std::unique_ptr<grid_map::GridMap> pending_submap_;
 };
 
 
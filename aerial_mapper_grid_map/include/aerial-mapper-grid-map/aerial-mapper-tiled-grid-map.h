@@ -0,0 +1,136 @@
+/*
+ *    Filename: aerial-mapper-tiled-grid-map.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_TILED_GRID_MAP_H_
+#define AERIAL_MAPPER_TILED_GRID_MAP_H_
+
+// SYSTEM
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// NON-SYSTEM
+#include <Eigen/Dense>
+#include <grid_map_core/GridMap.hpp>
+
+namespace grid_map {
+
+struct TiledGridMapSettings {
+  double center_easting = 0.0;
+  double center_northing = 0.0;
+  double delta_easting = 0.0;
+  double delta_northing = 0.0;
+  double resolution = 1.0;
+  // Edge length of the square tiles [cells].
+  int tile_size_cells = 1024;
+  // Number of tiles that are kept in memory. The least recently used tile is
+  // written to the backing file when another tile is needed.
+  size_t max_tiles_in_memory = 16u;
+  // Backing file, one fixed-size chunk per tile. Created or truncated.
+  std::string filename = "";
+  std::vector<std::string> layers = {"ortho", "elevation", "elevation_angle",
+                                     "num_observations", "observation_index",
+                                     "colored_ortho"};
+};
+
+/// Map of arbitrary extent that is split into square tiles. Every tile is a
+/// regular grid_map::GridMap, so the DSM and ortho modules can process the map
+/// tile by tile. Only max_tiles_in_memory tiles are held in memory, the others
+/// are stored in a chunked file (pread/pwrite at tile_index * chunk size).
+/// Tiles that have never been accessed are neither allocated nor stored.
+///
+/// The tiles cover the map starting from the corner with the maximum position
+/// (grid_map index (0, 0)); tiles at the opposite border may extend beyond
+/// the requested extent. Not thread-safe.
+class TiledGridMap {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  typedef std::function<void(size_t tile_index, grid_map::GridMap* tile)>
+      TileFunctor;
+
+  explicit TiledGridMap(const TiledGridMapSettings& settings);
+
+  /// Writes all cached tiles to the backing file.
+  ~TiledGridMap();
+
+  TiledGridMap(const TiledGridMap&) = delete;
+  TiledGridMap& operator=(const TiledGridMap&) = delete;
+
+  inline size_t getNumTiles() const {
+    return static_cast<size_t>(num_tiles_(0)) *
+           static_cast<size_t>(num_tiles_(1));
+  }
+
+  inline const Eigen::Array2i& getNumTilesPerDimension() const {
+    return num_tiles_;
+  }
+
+  inline double getResolution() const { return settings_.resolution; }
+
+  inline int getTileSizeCells() const { return settings_.tile_size_cells; }
+
+  /// Position of the map corner with index (0, 0), i.e. the corner with the
+  /// maximum position.
+  inline const grid_map::Position& getMapCorner() const { return map_corner_; }
+
+  /// Index of the tile that contains the position. Returns false if the
+  /// position is outside of the tiled map.
+  bool getTileIndex(const grid_map::Position& position,
+                    size_t* tile_index) const;
+
+  /// Indices of all tiles that overlap with the box [min, max].
+  std::vector<size_t> getTilesInBox(const grid_map::Position& min,
+                                    const grid_map::Position& max) const;
+
+  /// Returns the tile, loading it from the backing file or creating it if it
+  /// is not in memory. The pointer is invalidated by the next call that
+  /// causes an eviction, i.e. getTile() or forEachTile().
+  grid_map::GridMap* getTile(size_t tile_index);
+
+  /// Calls functor(tile_index, tile) for all tiles, one tile after the other.
+  void forEachTile(const TileFunctor& functor);
+
+  /// Calls functor(tile_index, tile) for the given tiles.
+  void forEachTile(const std::vector<size_t>& tile_indices,
+                   const TileFunctor& functor);
+
+  /// Writes all cached tiles to the backing file, but keeps them cached.
+  void flush();
+
+ private:
+  void initializeTile(size_t tile_index, grid_map::GridMap* tile) const;
+
+  void readTile(size_t tile_index, grid_map::GridMap* tile) const;
+
+  void writeTile(size_t tile_index, const grid_map::GridMap& tile);
+
+  void evictLeastRecentlyUsedTile();
+
+  TiledGridMapSettings settings_;
+  Eigen::Array2i num_tiles_;
+  // Position of the map corner with index (0, 0).
+  grid_map::Position map_corner_;
+
+  int file_descriptor_;
+  size_t chunk_size_bytes_;
+  std::vector<bool> tile_on_disk_;
+
+  // Most recently used tile first.
+  std::list<size_t> lru_tiles_;
+  struct CachedTile {
+    std::unique_ptr<grid_map::GridMap> map;
+    std::list<size_t>::iterator lru_position;
+  };
+  std::unordered_map<size_t, CachedTile> cached_tiles_;
+};
+
+}  // namespace grid_map
+
+#endif  // AERIAL_MAPPER_TILED_GRID_MAP_H_
@@ -0,0 +1,189 @@
+/*
+ *    Filename: aerial-mapper-elevation-bounds.cc
+ *  Created on: Oct 16, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-grid-map/aerial-mapper-elevation-bounds.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace grid_map {
+
+constexpr int ElevationBounds::kBlockSizeCells;
+
+ElevationBounds::ElevationBounds(const GridMap& map)
+    : resolution_(map.getResolution()),
+      map_size_(map.getSize()),
+      min_elevation_(std::numeric_limits<float>::infinity()),
+      max_elevation_(-std::numeric_limits<float>::infinity()) {
+  CHECK(map.isDefaultStartIndex());
+  CHECK_GT(resolution_, 0.0);
+  const Eigen::Vector2d half_length = 0.5 * map.getLength().matrix();
+  map_min_ = map.getPosition() - half_length;
+  map_max_ = map.getPosition() + half_length;
+  num_blocks_ = (map_size_ + kBlockSizeCells - 1) / kBlockSizeCells;
+  const size_t num_blocks = static_cast<size_t>(num_blocks_.prod());
+  min_elevations_.assign(num_blocks, std::numeric_limits<float>::quiet_NaN());
+  max_elevations_.assign(num_blocks, std::numeric_limits<float>::quiet_NaN());
+}
+
+bool ElevationBounds::hasGeometryOf(const GridMap& map) const {
+  const Eigen::Vector2d half_length = 0.5 * map.getLength().matrix();
+  return (map.getSize() == map_size_).all() &&
+         map.getResolution() == resolution_ &&
+         map.getPosition() - half_length == map_min_;
+}
+
+void ElevationBounds::update(const GridMap& map,
+                             const utils::CellRange& cells) {
+  if (cells.isEmpty() || !map.exists("elevation")) {
+    return;
+  }
+  CHECK(hasGeometryOf(map));
+  const Matrix& layer_elevation = map["elevation"];
+  const utils::CellRange blocks = getBlocks(cells);
+  const utils::CellRange all_cells(Eigen::Array2i::Zero(), map_size_);
+
+  // Recompute the updated blocks as a whole, only then take the lock.
+  std::vector<float> min_elevations(blocks.getNumCells());
+  std::vector<float> max_elevations(blocks.getNumCells());
+  size_t i = 0u;
+  for (int block_y = 0; block_y < blocks.size(1); ++block_y) {
+    for (int block_x = 0; block_x < blocks.size(0); ++block_x, ++i) {
+      const Eigen::Array2i block(blocks.start(0) + block_x,
+                                 blocks.start(1) + block_y);
+      const utils::CellRange block_cells =
+          utils::CellRange(block * kBlockSizeCells,
+                           Eigen::Array2i::Constant(kBlockSizeCells))
+              .intersect(all_cells);
+      float min_elevation = std::numeric_limits<float>::infinity();
+      float max_elevation = -std::numeric_limits<float>::infinity();
+      for (int y = 0; y < block_cells.size(1); ++y) {
+        for (int x = 0; x < block_cells.size(0); ++x) {
+          const float elevation = layer_elevation(block_cells.start(0) + x,
+                                                  block_cells.start(1) + y);
+          if (std::isfinite(elevation)) {
+            min_elevation = std::min(min_elevation, elevation);
+            max_elevation = std::max(max_elevation, elevation);
+          }
+        }
+      }
+      if (min_elevation > max_elevation) {
+        min_elevation = max_elevation =
+            std::numeric_limits<float>::quiet_NaN();
+      }
+      min_elevations[i] = min_elevation;
+      max_elevations[i] = max_elevation;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  i = 0u;
+  for (int block_y = 0; block_y < blocks.size(1); ++block_y) {
+    for (int block_x = 0; block_x < blocks.size(0); ++block_x, ++i) {
+      const size_t block_index = getBlockIndex(blocks.start(0) + block_x,
+                                               blocks.start(1) + block_y);
+      min_elevations_[block_index] = min_elevations[i];
+      max_elevations_[block_index] = max_elevations[i];
+      // NaN blocks fail both comparisons.
+      if (min_elevations[i] < min_elevation_) {
+        min_elevation_ = min_elevations[i];
+      }
+      if (max_elevations[i] > max_elevation_) {
+        max_elevation_ = max_elevations[i];
+      }
+    }
+  }
+}
+
+bool ElevationBounds::getElevationRange(double* min_elevation,
+                                        double* max_elevation) const {
+  CHECK_NOTNULL(min_elevation);
+  CHECK_NOTNULL(max_elevation);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (min_elevation_ > max_elevation_) {
+    return false;
+  }
+  *min_elevation = min_elevation_;
+  *max_elevation = max_elevation_;
+  return true;
+}
+
+bool ElevationBounds::getElevationRange(const utils::CellRange& cells,
+                                        double* min_elevation,
+                                        double* max_elevation) const {
+  CHECK_NOTNULL(min_elevation);
+  CHECK_NOTNULL(max_elevation);
+  const utils::CellRange clamped_cells =
+      cells.intersect(utils::CellRange(Eigen::Array2i::Zero(), map_size_));
+  if (clamped_cells.isEmpty()) {
+    return false;
+  }
+  const utils::CellRange blocks = getBlocks(clamped_cells);
+  float min_block_elevation = std::numeric_limits<float>::infinity();
+  float max_block_elevation = -std::numeric_limits<float>::infinity();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int y = blocks.start(1); y < blocks.getEnd()(1); ++y) {
+    for (int x = blocks.start(0); x < blocks.getEnd()(0); ++x) {
+      const size_t block_index = getBlockIndex(x, y);
+      // NaN blocks fail both comparisons.
+      if (min_elevations_[block_index] < min_block_elevation) {
+        min_block_elevation = min_elevations_[block_index];
+      }
+      if (max_elevations_[block_index] > max_block_elevation) {
+        max_block_elevation = max_elevations_[block_index];
+      }
+    }
+  }
+  if (min_block_elevation > max_block_elevation) {
+    return false;
+  }
+  *min_elevation = min_block_elevation;
+  *max_elevation = max_block_elevation;
+  return true;
+}
+
+bool ElevationBounds::getElevationRange(const Eigen::Vector2d& min_xy,
+                                        const Eigen::Vector2d& max_xy,
+                                        double* min_elevation,
+                                        double* max_elevation) const {
+  return getElevationRange(getCells(min_xy, max_xy), min_elevation,
+                           max_elevation);
+}
+
+utils::CellRange ElevationBounds::getCells(
+    const Eigen::Vector2d& min_xy, const Eigen::Vector2d& max_xy) const {
+  if ((max_xy.array() < map_min_.array()).any() ||
+      (min_xy.array() > map_max_.array()).any()) {
+    return utils::CellRange();
+  }
+  // The index runs from the maximum towards the minimum position.
+  const Eigen::Vector2d clamped_min_xy = min_xy.cwiseMax(map_min_);
+  const Eigen::Vector2d clamped_max_xy = max_xy.cwiseMin(map_max_);
+  const Eigen::Array2i start =
+      ((map_max_ - clamped_max_xy) / resolution_).array().floor().cast<int>();
+  const Eigen::Array2i end =
+      ((map_max_ - clamped_min_xy) / resolution_).array().floor().cast<int>() +
+      1;
+  return utils::CellRange(start, end - start)
+      .intersect(utils::CellRange(Eigen::Array2i::Zero(), map_size_));
+}
+
+utils::CellRange ElevationBounds::getBlocks(
+    const utils::CellRange& cells) const {
+  const Eigen::Array2i start = cells.start / kBlockSizeCells;
+  const Eigen::Array2i end =
+      (cells.getEnd() + kBlockSizeCells - 1) / kBlockSizeCells;
+  return utils::CellRange(start, end - start);
+}
+
+}  // namespace grid_map
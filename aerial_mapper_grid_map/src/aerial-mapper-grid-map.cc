@@ -7,25 +7,48 @@
 
 #include "aerial-mapper-grid-map/aerial-mapper-grid-map.h"
 
+#include <glog/logging.h>
 #include <grid_map_cv/GridMapCvConverter.hpp>
 #include <grid_map_ros/grid_map_ros.hpp>
 
 namespace grid_map {
 
+float getLayerDefaultValue(const std::string& layer) {
+  if (layer == "ortho") {
+    return 255.0f;
+  }
+  if (layer == "elevation_angle" || layer == "num_observations") {
+    return 0.0f;
+  }
+  return NAN;
+}
+
+grid_map::Matrix& getOrCreateLayer(const std::string& layer,
+                                   grid_map::GridMap* map) {
+  if (!map->exists(layer)) {
+    map->add(layer, getLayerDefaultValue(layer));
+  }
+  return (*map)[layer];
+}
+
 AerialGridMap::AerialGridMap(const Settings& settings)
     : settings_(settings),
       node_handle_{},
       pub_grid_map_(
-          node_handle_.advertise<grid_map_msgs::GridMap>("grid_map", 1, true)) {
+          node_handle_.advertise<grid_map_msgs::GridMap>("grid_map", 1, true)),
+      pub_grid_map_update_(node_handle_.advertise<grid_map_msgs::GridMap>(
+          "grid_map_update", 1, false)),
+      stop_publisher_(false),
+      has_pending_submap_(false) {
+  CHECK_GT(settings_.max_publish_rate_hz, 0.0);
   initialize();
 }
 
+AerialGridMap::~AerialGridMap() { stopPublishing(); }
+
 void AerialGridMap::initialize() {
   // Create grid map.
-  map_ = grid_map::GridMap({"ortho", "elevation", "elevation_angle",
-                            "num_observations", "elevation_angle_first_view",
-                            "delta", "observation_index",
-                            "observation_index_first","colored_ortho"});
+  map_ = grid_map::GridMap(settings_.layers);
   map_.setFrameId("world");
   map_.setGeometry(
       grid_map::Length(settings_.delta_easting, settings_.delta_northing),
@@ -37,38 +60,166 @@ void AerialGridMap::initialize() {
       map_.getLength().x(), map_.getLength().y(), map_.getSize()(0),
       map_.getSize()(1), map_.getPosition().x(), map_.getPosition().y(),
       map_.getFrameId().c_str());
-  map_["ortho"].setConstant(255);
-  map_["elevation"].setConstant(NAN);
-  map_["elevation_angle"].setConstant(0.0);
-  map_["elevation_angle_first_view"].setConstant(NAN);
-  map_["num_observations"].setConstant(0);
-  map_["observation_index"].setConstant(NAN);
-  map_["observation_index_first"].setConstant(NAN);
-  map_["delta"].setConstant(NAN);
-  map_["colored_ortho"].setConstant(NAN);
+  for (const std::string& layer : map_.getLayers()) {
+    map_[layer].setConstant(getLayerDefaultValue(layer));
+  }
 }
 
 void AerialGridMap::publishUntilShutdown() {
-  ros::Rate r(0.1);  // 10 hz
-  ros::NodeHandle node_handle;
-  ros::Publisher pub_grid_map =
-      node_handle.advertise<grid_map_msgs::GridMap>("grid_map", 1, true);
-  while (true) {
-    map_.setTimestamp(ros::Time::now().toNSec());
-    grid_map_msgs::GridMap message;
-    grid_map::GridMapRosConverter::toMessage(map_, message);
-    pub_grid_map.publish(message);
+  // The full map is latched, so it only has to be serialized once.
+  publishOnce();
+  ros::Rate rate(settings_.max_publish_rate_hz);
+  while (ros::ok()) {
     ros::spinOnce();
-    r.sleep();
+    rate.sleep();
   }
+  stopPublishing();
 }
 
 void AerialGridMap::publishOnce() {
   map_.setTimestamp(ros::Time::now().toNSec());
   grid_map_msgs::GridMap message;
-  grid_map::GridMapRosConverter::toMessage(map_, message);
+  grid_map::GridMapRosConverter::toMessage(map_, getPublishedLayers(),
+                                           message);
   pub_grid_map_.publish(message);
   ros::spinOnce();
 }
 
+void AerialGridMap::publishOnce(const grid_map::Index& start,
+                                const grid_map::Size& size) {
+  if ((size <= 0).any()) {
+    return;
+  }
+  grid_map::GridMap submap;
+  if (!extractSubmap(start, size, &submap)) {
+    ROS_WARN("Submap to publish exceeds the map.");
+    return;
+  }
+  submap.setTimestamp(ros::Time::now().toNSec());
+  grid_map_msgs::GridMap message;
+  grid_map::GridMapRosConverter::toMessage(submap, message);
+  pub_grid_map_update_.publish(message);
+  ros::spinOnce();
+}
+
+void AerialGridMap::publishAsync(const grid_map::Index& start,
+                                 const grid_map::Size& size) {
+  if ((size <= 0).any()) {
+    return;
+  }
+  // Merge with the changes that have not been published yet.
+  grid_map::Index merged_start = start;
+  grid_map::Size merged_size = size;
+  {
+    std::lock_guard<std::mutex> lock(publisher_mutex_);
+    if (has_pending_submap_) {
+      const grid_map::Index merged_end =
+          (start + size).max(pending_start_ + pending_size_);
+      merged_start = start.min(pending_start_);
+      merged_size = merged_end - merged_start;
+    }
+  }
+
+  // Copy the cells on the calling thread, which owns the map.
+  std::unique_ptr<grid_map::GridMap> submap(new grid_map::GridMap());
+  if (!extractSubmap(merged_start, merged_size, submap.get())) {
+    ROS_WARN("Submap to publish exceeds the map.");
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(publisher_mutex_);
+    pending_start_ = merged_start;
+    pending_size_ = merged_size;
+    pending_submap_ = std::move(submap);
+    has_pending_submap_ = true;
+    if (!publisher_thread_.joinable()) {
+      publisher_thread_ =
+          std::thread(&AerialGridMap::publishInBackground, this);
+    }
+  }
+  publisher_condition_.notify_all();
+}
+
+void AerialGridMap::stopPublishing() {
+  {
+    std::lock_guard<std::mutex> lock(publisher_mutex_);
+    stop_publisher_ = true;
+  }
+  publisher_condition_.notify_all();
+  if (publisher_thread_.joinable()) {
+    publisher_thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(publisher_mutex_);
+  stop_publisher_ = false;
+}
+
+std::vector<std::string> AerialGridMap::getPublishedLayers() const {
+  if (settings_.published_layers.empty()) {
+    return map_.getLayers();
+  }
+  std::vector<std::string> layers;
+  for (const std::string& layer : settings_.published_layers) {
+    if (map_.exists(layer)) {
+      layers.push_back(layer);
+    }
+  }
+  return layers;
+}
+
+bool AerialGridMap::extractSubmap(const grid_map::Index& start,
+                                  const grid_map::Size& size,
+                                  grid_map::GridMap* submap) const {
+  CHECK_NOTNULL(submap);
+  // The map is never moved, so the cells of the block are contiguous in the
+  // layer matrices.
+  grid_map::Position position_start, position_end;
+  if ((size <= 0).any() || !map_.getPosition(start, position_start) ||
+      !map_.getPosition(start + size - 1, position_end)) {
+    return false;
+  }
+  const std::vector<std::string> layers = getPublishedLayers();
+  *submap = grid_map::GridMap(layers);
+  submap->setFrameId(map_.getFrameId());
+  submap->setGeometry(
+      grid_map::Length(size.cast<double>() * map_.getResolution()),
+      map_.getResolution(), 0.5 * (position_start + position_end));
+  for (const std::string& layer : layers) {
+    (*submap)[layer] =
+        map_[layer].block(start(0), start(1), size(0), size(1));
+  }
+  return true;
+}
+
+void AerialGridMap::publishInBackground() {
+  const std::chrono::steady_clock::duration min_period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / settings_.max_publish_rate_hz));
+  std::chrono::steady_clock::time_point last_publication =
+      std::chrono::steady_clock::now() - min_period;
+  while (ros::ok()) {
+    std::unique_ptr<grid_map::GridMap> submap;
+    {
+      std::unique_lock<std::mutex> lock(publisher_mutex_);
+      publisher_condition_.wait(lock, [this]() {
+        return stop_publisher_ || has_pending_submap_;
+      });
+      if (!has_pending_submap_) {
+        return;
+      }
+      // Rate limit. Changes that arrive in the meantime are merged into the
+      // pending submap; pending changes are flushed when stopping.
+      publisher_condition_.wait_until(lock, last_publication + min_period,
+                                      [this]() { return stop_publisher_; });
+      submap = std::move(pending_submap_);
+      has_pending_submap_ = false;
+    }
+    submap->setTimestamp(ros::Time::now().toNSec());
+    grid_map_msgs::GridMap message;
+    grid_map::GridMapRosConverter::toMessage(*submap, message);
+    pub_grid_map_update_.publish(message);
+    last_publication = std::chrono::steady_clock::now();
+  }
+}
+
 }  // namespace grid_map
@@ -0,0 +1,221 @@
+/*
+ *    Filename: aerial-mapper-tiled-grid-map.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+#include "aerial-mapper-grid-map/aerial-mapper-grid-map.h"
+
+namespace grid_map {
+
+TiledGridMap::TiledGridMap(const TiledGridMapSettings& settings)
+    : settings_(settings), file_descriptor_(-1), chunk_size_bytes_(0u) {
+  CHECK_GT(settings_.resolution, 0.0);
+  CHECK_GT(settings_.tile_size_cells, 0);
+  CHECK_GT(settings_.max_tiles_in_memory, 0u);
+  CHECK(!settings_.layers.empty());
+  CHECK(!settings_.filename.empty());
+
+  // Same rounding as grid_map::GridMap::setGeometry.
+  const Eigen::Array2i map_size(
+      static_cast<int>(std::round(settings_.delta_easting /
+                                  settings_.resolution)),
+      static_cast<int>(std::round(settings_.delta_northing /
+                                  settings_.resolution)));
+  CHECK((map_size > 0).all());
+  num_tiles_ = (map_size + settings_.tile_size_cells - 1) /
+               settings_.tile_size_cells;
+  map_corner_ =
+      grid_map::Position(settings_.center_easting, settings_.center_northing) +
+      0.5 * settings_.resolution * map_size.cast<double>().matrix();
+
+  const size_t tile_num_cells = static_cast<size_t>(settings_.tile_size_cells) *
+                                static_cast<size_t>(settings_.tile_size_cells);
+  chunk_size_bytes_ = settings_.layers.size() * tile_num_cells * sizeof(float);
+  tile_on_disk_.assign(getNumTiles(), false);
+
+  file_descriptor_ =
+      open(settings_.filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CHECK_GE(file_descriptor_, 0) << "Cannot open " << settings_.filename
+                                << ": " << std::strerror(errno);
+
+  LOG(INFO) << "Created tiled map with " << num_tiles_(0) << " x "
+            << num_tiles_(1) << " tiles of " << settings_.tile_size_cells
+            << " x " << settings_.tile_size_cells << " cells, backed by "
+            << settings_.filename << " (max. "
+            << settings_.max_tiles_in_memory * chunk_size_bytes_ / (1u << 20)
+            << " MB in memory).";
+}
+
+TiledGridMap::~TiledGridMap() {
+  flush();
+  close(file_descriptor_);
+}
+
+bool TiledGridMap::getTileIndex(const grid_map::Position& position,
+                                size_t* tile_index) const {
+  CHECK_NOTNULL(tile_index);
+  // The cell index increases with decreasing position.
+  const Eigen::Array2d cell =
+      ((map_corner_ - position) / settings_.resolution).array().floor();
+  const Eigen::Array2d tile = (cell / settings_.tile_size_cells).floor();
+  if ((tile < 0.0).any() || (tile >= num_tiles_.cast<double>()).any()) {
+    return false;
+  }
+  *tile_index =
+      static_cast<size_t>(tile(0)) +
+      static_cast<size_t>(tile(1)) * static_cast<size_t>(num_tiles_(0));
+  return true;
+}
+
+std::vector<size_t> TiledGridMap::getTilesInBox(
+    const grid_map::Position& min, const grid_map::Position& max) const {
+  const double tile_length = settings_.tile_size_cells * settings_.resolution;
+  const Eigen::Array2i first_tile =
+      ((map_corner_ - max) / tile_length).array().floor().cast<int>().max(0);
+  const Eigen::Array2i last_tile = ((map_corner_ - min) / tile_length)
+                                       .array()
+                                       .floor()
+                                       .cast<int>()
+                                       .min(num_tiles_ - 1);
+  std::vector<size_t> tile_indices;
+  for (int tile_y = first_tile(1); tile_y <= last_tile(1); ++tile_y) {
+    for (int tile_x = first_tile(0); tile_x <= last_tile(0); ++tile_x) {
+      tile_indices.push_back(static_cast<size_t>(tile_x) +
+                             static_cast<size_t>(tile_y) *
+                                 static_cast<size_t>(num_tiles_(0)));
+    }
+  }
+  return tile_indices;
+}
+
+grid_map::GridMap* TiledGridMap::getTile(size_t tile_index) {
+  CHECK_LT(tile_index, getNumTiles());
+  const auto cached_tile = cached_tiles_.find(tile_index);
+  if (cached_tile != cached_tiles_.end()) {
+    // Move to the front of the LRU list.
+    lru_tiles_.splice(lru_tiles_.begin(), lru_tiles_,
+                      cached_tile->second.lru_position);
+    return cached_tile->second.map.get();
+  }
+
+  while (cached_tiles_.size() >= settings_.max_tiles_in_memory) {
+    evictLeastRecentlyUsedTile();
+  }
+  std::unique_ptr<grid_map::GridMap> tile(
+      new grid_map::GridMap(settings_.layers));
+  initializeTile(tile_index, tile.get());
+  if (tile_on_disk_[tile_index]) {
+    readTile(tile_index, tile.get());
+  }
+  lru_tiles_.push_front(tile_index);
+  CachedTile& entry = cached_tiles_[tile_index];
+  entry.map = std::move(tile);
+  entry.lru_position = lru_tiles_.begin();
+  return entry.map.get();
+}
+
+void TiledGridMap::forEachTile(const TileFunctor& functor) {
+  for (size_t tile_index = 0u; tile_index < getNumTiles(); ++tile_index) {
+    functor(tile_index, getTile(tile_index));
+  }
+}
+
+void TiledGridMap::forEachTile(const std::vector<size_t>& tile_indices,
+                               const TileFunctor& functor) {
+  for (const size_t tile_index : tile_indices) {
+    functor(tile_index, getTile(tile_index));
+  }
+}
+
+void TiledGridMap::flush() {
+  for (const std::pair<const size_t, CachedTile>& cached_tile :
+       cached_tiles_) {
+    writeTile(cached_tile.first, *cached_tile.second.map);
+  }
+}
+
+void TiledGridMap::initializeTile(size_t tile_index,
+                                  grid_map::GridMap* tile) const {
+  CHECK_NOTNULL(tile);
+  const int tile_x = static_cast<int>(tile_index % num_tiles_(0));
+  const int tile_y = static_cast<int>(tile_index / num_tiles_(0));
+  const double tile_length = settings_.tile_size_cells * settings_.resolution;
+  const grid_map::Position tile_center =
+      map_corner_ - tile_length * Eigen::Vector2d(tile_x + 0.5, tile_y + 0.5);
+  tile->setFrameId("world");
+  tile->setGeometry(grid_map::Length(tile_length, tile_length),
+                    settings_.resolution, tile_center);
+  CHECK_EQ(tile->getSize()(0), settings_.tile_size_cells);
+  CHECK_EQ(tile->getSize()(1), settings_.tile_size_cells);
+  for (const std::string& layer : settings_.layers) {
+    (*tile)[layer].setConstant(getLayerDefaultValue(layer));
+  }
+}
+
+void TiledGridMap::readTile(size_t tile_index, grid_map::GridMap* tile) const {
+  CHECK_NOTNULL(tile);
+  off_t offset = static_cast<off_t>(tile_index * chunk_size_bytes_);
+  for (const std::string& layer : settings_.layers) {
+    grid_map::Matrix& data = (*tile)[layer];
+    char* buffer = reinterpret_cast<char*>(data.data());
+    size_t num_bytes = data.size() * sizeof(float);
+    while (num_bytes > 0u) {
+      const ssize_t num_read =
+          pread(file_descriptor_, buffer, num_bytes, offset);
+      CHECK_GT(num_read, 0) << "Reading tile " << tile_index
+                            << " failed: " << std::strerror(errno);
+      buffer += num_read;
+      offset += num_read;
+      num_bytes -= static_cast<size_t>(num_read);
+    }
+  }
+}
+
+void TiledGridMap::writeTile(size_t tile_index,
+                             const grid_map::GridMap& tile) {
+  off_t offset = static_cast<off_t>(tile_index * chunk_size_bytes_);
+  for (const std::string& layer : settings_.layers) {
+    const grid_map::Matrix& data = tile[layer];
+    const char* buffer = reinterpret_cast<const char*>(data.data());
+    size_t num_bytes = data.size() * sizeof(float);
+    while (num_bytes > 0u) {
+      const ssize_t num_written =
+          pwrite(file_descriptor_, buffer, num_bytes, offset);
+      CHECK_GT(num_written, 0) << "Writing tile " << tile_index
+                               << " failed: " << std::strerror(errno);
+      buffer += num_written;
+      offset += num_written;
+      num_bytes -= static_cast<size_t>(num_written);
+    }
+  }
+  tile_on_disk_[tile_index] = true;
+}
+
+void TiledGridMap::evictLeastRecentlyUsedTile() {
+  CHECK(!lru_tiles_.empty());
+  const size_t tile_index = lru_tiles_.back();
+  const auto cached_tile = cached_tiles_.find(tile_index);
+  CHECK(cached_tile != cached_tiles_.end());
+  writeTile(tile_index, *cached_tile->second.map);
+  cached_tiles_.erase(cached_tile);
+  lru_tiles_.pop_back();
+  VLOG(2) << "Evicted tile " << tile_index;
+}
+
+}  // namespace grid_map
@@ -0,0 +1,47 @@
+/*
+ *    Filename: aerial-mapper-ascii-point-cloud.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_ASCII_POINT_CLOUD_H_
+#define AERIAL_MAPPER_ASCII_POINT_CLOUD_H_
+
+// SYSTEM
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-nearest-neighbor.h>
+#include <Eigen/Core>
+
+namespace io {
+
+struct AsciiPointCloudSettings {
+  // Number of parser threads, 0 uses all hardware threads.
+  size_t num_threads = 0u;
+  // Points with an elevation below this value are dropped.
+  double min_elevation = -100.0;
+};
+
+/// Parses a text point cloud with one "x y z intensity" per line (separated by
+/// spaces, tabs or commas; further columns are ignored). The file is
+/// memory-mapped and split at line boundaries into chunks that are parsed in
+/// parallel with a locale-independent number parser. The points are appended
+/// in file order. Malformed lines are skipped and counted in the log.
+/// The intensities are optional.
+void loadAsciiPointCloud(
+    const std::string& filename, const AsciiPointCloudSettings& settings,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
+    std::vector<int>* point_cloud_intensities);
+
+/// Parses a decimal number (optional sign, digits, fraction and exponent)
+/// starting at begin. Returns the position after the number, or nullptr if
+/// there is no number at begin. Exact for up to 15 significant digits.
+const char* parseDouble(const char* begin, const char* end, double* value);
+
+}  // namespace io
+
+#endif  // AERIAL_MAPPER_ASCII_POINT_CLOUD_H_
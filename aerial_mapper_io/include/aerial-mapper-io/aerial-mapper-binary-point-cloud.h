@@ -0,0 +1,110 @@
+/*
+ *    Filename: aerial-mapper-binary-point-cloud.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_BINARY_POINT_CLOUD_H_
+#define AERIAL_MAPPER_BINARY_POINT_CLOUD_H_
+
+// SYSTEM
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-nearest-neighbor.h>
+#include <Eigen/Core>
+
+namespace io {
+
+/// Header of the binary point cloud format (version 1, little endian):
+///   BinaryPointCloudHeader (128 bytes)
+///   float x[num_points], float y[num_points], float z[num_points]
+///   int32 intensity[num_points]   (only if kHasIntensities is set)
+/// The coordinates are stored relative to origin, which keeps the precision
+/// of georeferenced clouds in single precision.
+struct BinaryPointCloudHeader {
+  static constexpr uint32_t kHasIntensities = 1u;
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t num_points;
+  double origin[3];
+  // Bounding box of the points, relative to origin.
+  float min[3];
+  float max[3];
+  uint8_t reserved[56];
+};
+static_assert(sizeof(BinaryPointCloudHeader) == 128u,
+              "Unexpected size of the binary point cloud header.");
+
+/// Read-only, memory-mapped binary point cloud. The points are not copied:
+/// getPoints() and getIntensities() point into the mapping, so the pages are
+/// only read from disk when they are accessed.
+class BinaryPointCloud {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  static constexpr uint32_t kVersion = 1u;
+
+  BinaryPointCloud();
+
+  /// Unmaps the file.
+  ~BinaryPointCloud();
+
+  BinaryPointCloud(const BinaryPointCloud&) = delete;
+  BinaryPointCloud& operator=(const BinaryPointCloud&) = delete;
+
+  /// Maps the file. Returns false if the file cannot be opened or is not a
+  /// binary point cloud of a supported version.
+  bool open(const std::string& filename);
+
+  void close();
+
+  /// Returns true if the file starts with the magic of the binary format.
+  static bool isBinaryPointCloudFile(const std::string& filename);
+
+  /// Writes the point cloud in the binary format. The origin is set to the
+  /// center of the bounding box, rounded to meters. The intensities are
+  /// optional.
+  static void write(
+      const std::string& filename,
+      const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+      const std::vector<int>* intensities);
+
+  inline bool isOpen() const { return header_ != nullptr; }
+
+  inline size_t size() const {
+    return isOpen() ? static_cast<size_t>(header_->num_points) : 0u;
+  }
+
+  Eigen::Vector3d getOrigin() const;
+
+  /// Bounding box of the points (absolute coordinates).
+  Eigen::Vector3d getMin() const;
+  Eigen::Vector3d getMax() const;
+
+  /// Coordinates relative to getOrigin(), valid until close().
+  PointCloudSoAView<float> getPoints() const;
+
+  /// Intensity of every point, nullptr if the file contains none. Valid until
+  /// close().
+  const int* getIntensities() const;
+
+  /// Copies the points (absolute coordinates) and intensities out of the
+  /// mapping, e.g. for modules that only accept Eigen point clouds.
+  void toPointCloud(
+      AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+      std::vector<int>* intensities) const;
+
+ private:
+  void* mapping_;
+  size_t mapping_size_bytes_;
+  const BinaryPointCloudHeader* header_;
+};
+
+}  // namespace io
+
+#endif  // AERIAL_MAPPER_BINARY_POINT_CLOUD_H_
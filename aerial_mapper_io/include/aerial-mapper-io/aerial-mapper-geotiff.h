@@ -0,0 +1,122 @@
+/*
+ *    Filename: aerial-mapper-geotiff.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_GEOTIFF_H_
+#define AERIAL_MAPPER_GEOTIFF_H_
+
+// SYSTEM
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h>
+#include <Eigen/Core>
+#include <grid_map_core/GridMap.hpp>
+#include <opencv2/core/core.hpp>
+
+class GDALDataset;
+
+namespace io {
+
+enum class GeoTiffCompression { kNone, kDeflate, kLzw };
+
+enum class GeoTiffPixelType {
+  // Values are rounded and clamped to [0, 255], no-data is 0.
+  kByte,
+  // No-data is NaN.
+  kFloat32
+};
+
+struct GeoTiffSettings {
+  int utm_zone = 32;
+  bool northern_hemisphere = true;
+  GeoTiffCompression compression = GeoTiffCompression::kDeflate;
+  // Edge length of the internal tiles [pixels], a multiple of 16.
+  int block_size = 256;
+  // Number of GDAL compression threads, 0 uses all hardware threads.
+  size_t num_threads = 0u;
+  // Internal overviews at factors 2, 4, 8, ... down to this size [pixels].
+  bool build_overviews = true;
+  int min_overview_size = 256;
+  std::string overview_resampling = "AVERAGE";
+};
+
+/// Streaming writer of tiled, compressed, north-up GeoTIFFs in UTM. The raster
+/// is written in windows, e.g. strip by strip or map tile by map tile. GDAL
+/// compresses the finished tiles in parallel and only keeps the tiles that
+/// are still being written in its block cache, so the memory does not grow
+/// with the raster. The overviews are built when the file is closed.
+class GeoTiffWriter {
+ public:
+  /// top_left is the (easting, northing) of the upper left raster corner,
+  /// resolution the pixel size [m].
+  GeoTiffWriter(const std::string& filename, int width, int height,
+                int num_bands, GeoTiffPixelType pixel_type,
+                const Eigen::Vector2d& top_left, double resolution,
+                const GeoTiffSettings& settings);
+
+  /// Closes the file.
+  ~GeoTiffWriter();
+
+  GeoTiffWriter(const GeoTiffWriter&) = delete;
+  GeoTiffWriter& operator=(const GeoTiffWriter&) = delete;
+
+  inline int getWidth() const { return width_; }
+  inline int getHeight() const { return height_; }
+
+  /// Writes the window [x, x + width) x [y, y + height) of all bands. The
+  /// pixels are stored row by row, line_stride_bytes apart, with the bands
+  /// interleaved.
+  void write(int x, int y, int width, int height, const void* data,
+             size_t line_stride_bytes);
+
+  /// Writes the image at (x, y) without copying it. CV_8UC1 and CV_8UC3 (BGR)
+  /// images require kByte, CV_32FC1 images kFloat32 pixels.
+  void writeImage(const cv::Mat& image, int x, int y);
+
+  /// Writes the layers (one per band) of the map at its position in the
+  /// raster, which has to contain the map completely.
+  void writeGridMap(const grid_map::GridMap& map,
+                    const std::vector<std::string>& layers);
+
+  /// Builds the overviews and closes the file.
+  void close();
+
+ private:
+  void write(int x, int y, int width, int height, const void* data,
+             size_t line_stride_bytes, const std::vector<int>& band_order);
+
+  const GeoTiffSettings settings_;
+  const int width_;
+  const int height_;
+  const int num_bands_;
+  const GeoTiffPixelType pixel_type_;
+  const Eigen::Vector2d top_left_;
+  const double resolution_;
+  GDALDataset* dataset_;
+};
+
+/// Exports the layers of the map (one per band) as GeoTIFF. The map positions
+/// are interpreted as (easting, northing).
+void writeGridMapToGeoTiff(const grid_map::GridMap& map,
+                           const std::vector<std::string>& layers,
+                           GeoTiffPixelType pixel_type,
+                           const std::string& filename,
+                           const GeoTiffSettings& settings);
+
+/// Exports the layers of the tiled map tile by tile, so only the tiles that
+/// fit into the tile cache are held in memory.
+void writeTiledGridMapToGeoTiff(grid_map::TiledGridMap* map,
+                                const std::vector<std::string>& layers,
+                                GeoTiffPixelType pixel_type,
+                                const std::string& filename,
+                                const GeoTiffSettings& settings);
+
+}  // namespace io
+
+#endif  // AERIAL_MAPPER_GEOTIFF_H_
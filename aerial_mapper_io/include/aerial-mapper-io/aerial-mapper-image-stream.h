@@ -0,0 +1,99 @@
+/*
+ *    Filename: aerial-mapper-image-stream.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_IMAGE_STREAM_H_
+#define AERIAL_MAPPER_IMAGE_STREAM_H_
+
+// SYSTEM
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
+#include <opencv2/core/core.hpp>
+
+namespace io {
+
+struct ImageStreamSettings {
+  // Number of decoder threads, 0 uses all hardware threads.
+  size_t num_threads = 0u;
+  // Number of images that are decoded ahead of the consumer.
+  size_t num_prefetched_images = 8u;
+  // Upper bound of the decoded images held by the stream [bytes]. The next
+  // image is always decoded, even if it exceeds the budget on its own.
+  size_t max_buffered_bytes = size_t(1u) << 30;
+  bool load_colored_images = false;
+  // Decode the images at 1/1, 1/2, 1/4 or 1/8 of their resolution. JPEG
+  // images are scaled in the DCT domain, which is considerably faster than a
+  // full decode and averages the pixels instead of aliasing.
+  size_t reduction_factor = 1u;
+};
+
+/// Decodes a sequence of image files on a thread pool, ahead of the consumer.
+/// The images are returned in order by next(); the stream only holds the
+/// prefetched images, so the memory does not grow with the number of files.
+class ImageStream {
+ public:
+  ImageStream(const std::vector<std::string>& filenames,
+              const ImageStreamSettings& settings);
+
+  /// Waits for the pending decodes.
+  ~ImageStream();
+
+  ImageStream(const ImageStream&) = delete;
+  ImageStream& operator=(const ImageStream&) = delete;
+
+  /// Filenames filename_base + i + extension (the naming used by
+  /// AerialMapperIO::loadImagesFromFile) of every step-th image in
+  /// [0, num_images), i.e. i = step - 1, 2 * step - 1, ...
+  static std::vector<std::string> getFilenames(
+      const std::string& filename_base, size_t num_images, size_t step = 1u,
+      const std::string& extension = ".jpg");
+
+  inline size_t size() const { return filenames_.size(); }
+
+  /// Index of the image that is returned by the next call to next().
+  size_t getNextIndex() const;
+
+  inline bool hasNext() const { return getNextIndex() < size(); }
+
+  /// Blocks until the next image is decoded and hands it over. Returns false
+  /// after the last image. Images that cannot be read are returned empty.
+  bool next(cv::Mat* image);
+
+ private:
+  /// Submits decodes while the prefetch window and the budget allow it.
+  /// Requires mutex_ to be held.
+  void scheduleDecodes();
+
+  void decode(size_t index);
+
+  const std::vector<std::string> filenames_;
+  const ImageStreamSettings settings_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable image_decoded_;
+  std::map<size_t, cv::Mat> decoded_images_;
+  size_t next_index_to_decode_;
+  size_t next_index_to_return_;
+  size_t num_decoding_;
+  size_t buffered_bytes_;
+  // Size of the last decoded image, used to estimate the pending decodes.
+  size_t expected_image_bytes_;
+
+  // Destroyed first, which joins the workers.
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+};
+
+}  // namespace io
+
+#endif  // AERIAL_MAPPER_IMAGE_STREAM_H_
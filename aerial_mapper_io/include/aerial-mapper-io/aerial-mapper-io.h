@@ -14,6 +14,8 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
 
+#include "aerial-mapper-io/aerial-mapper-geotiff.h"
+
 typedef kindr::minimal::QuatTransformation Pose;
 typedef std::vector<Pose> Poses;
 typedef cv::Mat Image;
@@ -31,6 +33,8 @@ class AerialMapperIO {
   void loadPosesFromFile(const PoseFormat& format, const std::string& filename,
                          Poses* T_G_Bs);
   void loadPosesFromFileStandard(const std::string& filename, Poses* T_G_Bs);
+  /// Decodes the images in parallel, see io::ImageStream to process them
+  /// without holding all images in memory.
   void loadImagesFromFile(const std::string& filename_base, size_t num_poses,
                           Images* images, bool load_colored_images = false);
 
@@ -44,6 +48,9 @@ class AerialMapperIO {
   void loadPosesFromFileRos(const std::string& filename, Poses* T_G_Bs,
                             std::vector<int64_t>* timestamps_ns);
 
+  /// Both overloads read the text format (x y z intensity per line, parsed in
+  /// parallel) and the binary format (see aerial-mapper-binary-point-cloud.h).
+  /// Points with z <= -100 are dropped from text files.
   void loadPointCloudFromFile(
       const std::string& filename_point_cloud,
       AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
@@ -53,14 +60,25 @@ class AerialMapperIO {
       const std::string& filename_point_cloud,
       AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz);
 
+  /// One-time conversion of a text point cloud into the binary format, which
+  /// can be memory-mapped by io::BinaryPointCloud.
+  void convertPointCloudToBinary(
+      const std::string& filename_point_cloud,
+      const std::string& filename_binary_point_cloud);
+
   void subtractOriginFromPoses(const Eigen::Vector3d& origin, Poses* T_G_Bs);
 
-  void writeDataToDEMGeoTiffColor(const cv::Mat& ortho_image,
-                                  const Eigen::Vector2d& xy,
-                                  const std::string& geotiff_filename);
+  /// Writes a BGR image as RGB GeoTIFF. xy is the (easting, northing) of the
+  /// upper left corner, resolution the pixel size [m].
+  void writeDataToDEMGeoTiffColor(
+      const cv::Mat& ortho_image, const Eigen::Vector2d& xy,
+      const std::string& geotiff_filename, double resolution = 1.0,
+      const GeoTiffSettings& settings = GeoTiffSettings());
 
+  /// Writes a grayscale image as GeoTIFF, see writeDataToDEMGeoTiffColor.
   void toGeoTiff(const cv::Mat& orthomosaic, const Eigen::Vector2d& xy,
-                 const std::string& geotiff_filename);
+                 const std::string& geotiff_filename, double resolution = 1.0,
+                 const GeoTiffSettings& settings = GeoTiffSettings());
 
   void toStandardFormat(const std::string& directory,
                         const std::string& filename_vi_imu_poses,
@@ -70,6 +88,16 @@ class AerialMapperIO {
   void convertFromSimulation();
 
   void exportPix4dGeofile(const Poses& T_G_Cs, const Images& images);
+
+ private:
+  void loadImages(const std::vector<std::string>& filenames,
+                  bool load_colored_images, Images* images);
+
+  /// Loads a text or binary point cloud, the intensities are optional.
+  void loadPointCloud(
+      const std::string& filename_point_cloud,
+      AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
+      std::vector<int>* point_cloud_intensities);
 };
 }  // namespace io
 #endif  // namespace AERIAL_MAPPER_IO_H_
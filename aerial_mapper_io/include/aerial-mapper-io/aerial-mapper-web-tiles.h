@@ -0,0 +1,144 @@
+/*
+ *    Filename: aerial-mapper-web-tiles.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef AERIAL_MAPPER_WEB_TILES_H_
+#define AERIAL_MAPPER_WEB_TILES_H_
+
+// SYSTEM
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
+#include <aerial-mapper-utils/utils-tiling.h>
+#include <Eigen/Core>
+#include <grid_map_core/GridMap.hpp>
+#include <opencv2/core/core.hpp>
+
+namespace io {
+
+struct WebTilesSettings {
+  // The tiles are written to <directory>/<layer>/<z>/<x>/<y>.png.
+  std::string directory = "/tmp/aerial_mapper_tiles";
+  // "ortho" is written as grayscale, "colored_ortho" as RGB and "elevation"
+  // as Terrain-RGB (elevation = -10000 + (R * 65536 + G * 256 + B) * 0.1).
+  // Layers that do not exist in the map are skipped.
+  std::vector<std::string> layers = {"ortho", "colored_ortho", "elevation"};
+  // UTM zone of the grid_map positions (easting, northing).
+  int utm_zone = 32;
+  bool northern_hemisphere = true;
+  // Zoom levels of the pyramid. -1 derives them from the map: the finest
+  // level has pixels no larger than the cells, the coarsest level shows the
+  // map on about one tile.
+  int min_zoom = -1;
+  int max_zoom = -1;
+  // Number the rows from the south (TMS) instead of from the north (XYZ).
+  bool tms = false;
+  // Number of render threads, 0 uses all hardware threads.
+  size_t num_threads = 0u;
+};
+
+/// Exports map layers as a Web Mercator (EPSG:3857) tile pyramid of PNGs that
+/// can be served statically, e.g. to Leaflet or OpenLayers. The finest level
+/// is sampled from the map, the coarser levels are averaged from their four
+/// children. Only the tiles that cover changed cells are rendered again, so
+/// the pyramid can be updated after every processed flight segment; tiles
+/// that no longer cover any valid cell are removed. The tiles of a level are
+/// rendered in parallel; tiles are written to a temporary file and renamed,
+/// so a server never delivers a partially written tile.
+class WebTileExporter {
+ public:
+  /// Derives the zoom levels from the geometry of the map.
+  WebTileExporter(const grid_map::GridMap& map,
+                  const WebTilesSettings& settings);
+
+  inline int getMinZoom() const { return min_zoom_; }
+  inline int getMaxZoom() const { return max_zoom_; }
+
+  /// Renders the tiles of the whole map.
+  void exportAll(const grid_map::GridMap& map);
+
+  /// Renders the tiles that overlap with the changed cells, e.g.
+  /// Dsm::getLastUpdatedCells() or OrthoBackwardGrid::getLastUpdatedCells().
+  void exportChanged(const grid_map::GridMap& map,
+                     const utils::CellRange& changed_cells);
+
+  /// Copies the exported layers of the cells that exportChanged(map,
+  /// changed_cells) reads into submap. exportChanged(*submap,
+  /// *submap_changed_cells) then renders the same tiles, so the tiles can be
+  /// exported from the copy while the map is modified.
+  void extractChangedSubmap(const grid_map::GridMap& map,
+                            const utils::CellRange& changed_cells,
+                            grid_map::GridMap* submap,
+                            utils::CellRange* submap_changed_cells) const;
+
+ private:
+  enum class Encoding { kGray, kColor, kTerrainRgb };
+
+  /// Pixel values of a tile and whether they are valid (1) or not (0).
+  struct TileImage {
+    cv::Mat values;
+    cv::Mat weights;
+  };
+
+  static Encoding getEncoding(const std::string& layer);
+
+  Eigen::Vector2d utmToMercator(const Eigen::Vector2d& utm) const;
+
+  /// Inverts utmToMercator() by Newton's method.
+  Eigen::Vector2d mercatorToUtm(const Eigen::Vector2d& mercator,
+                                const Eigen::Vector2d& initial_utm) const;
+
+  /// Tile coordinates at the zoom level that overlap with the UTM box.
+  utils::CellRange getTilesInBox(const Eigen::Vector2d& utm_min,
+                                 const Eigen::Vector2d& utm_max,
+                                 int zoom) const;
+
+  /// UTM position of the center of every pixel of the tile.
+  void computePixelPositions(const Eigen::Array2i& tile, int zoom,
+                             const Eigen::Vector2d& initial_utm,
+                             cv::Mat* positions) const;
+
+  void renderTile(const grid_map::GridMap& map,
+                  const std::vector<std::string>& layers,
+                  const Eigen::Array2i& tile, int zoom) const;
+
+  void downsampleTile(const std::vector<std::string>& layers,
+                      const Eigen::Array2i& tile, int zoom) const;
+
+  /// Box in UTM that covers the tiles of the zoom level.
+  void getBoxOfTiles(const utils::CellRange& tiles, int zoom,
+                     const Eigen::Vector2d& initial_utm,
+                     Eigen::Vector2d* utm_min, Eigen::Vector2d* utm_max) const;
+
+  std::string getTileFilename(const std::string& layer,
+                              const Eigen::Array2i& tile, int zoom,
+                              bool create_directories) const;
+
+  /// Returns false if the tile does not exist.
+  bool readTile(const std::string& layer, const Eigen::Array2i& tile,
+                int zoom, TileImage* image) const;
+
+  void writeTile(const std::string& layer, const Eigen::Array2i& tile,
+                 int zoom, const TileImage& image) const;
+
+  /// Removes the tile of a layer that no longer has data, if it exists.
+  void removeTile(const std::string& layer, const Eigen::Array2i& tile,
+                  int zoom) const;
+
+  const WebTilesSettings settings_;
+  const std::string utm_zone_;
+  int min_zoom_;
+  int max_zoom_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+};
+
+}  // namespace io
+
+#endif  // AERIAL_MAPPER_WEB_TILES_H_
@@ -0,0 +1,268 @@
+/*
+ *    Filename: aerial-mapper-ascii-point-cloud.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-io/aerial-mapper-ascii-point-cloud.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// NON-SYSTEM
+#include <aerial-mapper-utils/utils-thread-pool.h>
+#include <glog/logging.h>
+
+namespace io {
+
+namespace {
+// Chunk sizes such that every worker gets a few chunks.
+constexpr size_t kMinChunkSizeBytes = 1u << 20;
+constexpr size_t kMaxChunkSizeBytes = 64u << 20;
+constexpr size_t kChunksPerThread = 4u;
+
+// Significant digits that fit into the 64 bit mantissa.
+constexpr int kMaxMantissaDigits = 19;
+
+// Powers of ten that are exactly representable as double.
+const double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr int kMaxExactPowerOfTen = 22;
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool isSeparator(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+struct ChunkResult {
+  AlignedType<std::vector, Eigen::Vector3d>::type xyz;
+  std::vector<int> intensities;
+  size_t num_skipped_lines = 0u;
+};
+
+void parseChunk(const char* begin, const char* end, double min_elevation,
+                bool parse_intensities, ChunkResult* result) {
+  static constexpr int kNumValues = 4;
+  while (begin < end) {
+    const char* line_end =
+        static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    const char* p = begin;
+    begin = line_end + 1;
+
+    double values[kNumValues];
+    int num_values = 0;
+    while (num_values < kNumValues) {
+      while (p < line_end && isSeparator(*p)) {
+        ++p;
+      }
+      if (p == line_end) {
+        break;
+      }
+      p = parseDouble(p, line_end, &values[num_values]);
+      if (p == nullptr || (p < line_end && !isSeparator(*p))) {
+        break;
+      }
+      ++num_values;
+    }
+    if (num_values < kNumValues) {
+      // Empty lines are not reported.
+      if (num_values > 0 || p != line_end) {
+        ++result->num_skipped_lines;
+      }
+      continue;
+    }
+    if (values[2] > min_elevation) {
+      result->xyz.emplace_back(values[0], values[1], values[2]);
+      if (parse_intensities) {
+        result->intensities.push_back(static_cast<int>(values[3]));
+      }
+    }
+  }
+}
+}  // namespace
+
+const char* parseDouble(const char* begin, const char* end, double* value) {
+  CHECK_NOTNULL(value);
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0u;
+  int num_mantissa_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  for (; p < end && isDigit(*p); ++p) {
+    has_digits = true;
+    if (num_mantissa_digits < kMaxMantissaDigits) {
+      mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+      // Leading zeros are not significant.
+      num_mantissa_digits += mantissa > 0u ? 1 : 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && isDigit(*p); ++p) {
+      has_digits = true;
+      if (num_mantissa_digits < kMaxMantissaDigits) {
+        mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+        num_mantissa_digits += mantissa > 0u ? 1 : 0;
+        --exponent;
+      }
+    }
+  }
+  if (!has_digits) {
+    return nullptr;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negative_exponent = *p == '-';
+      ++p;
+    }
+    if (p == end || !isDigit(*p)) {
+      return nullptr;
+    }
+    int explicit_exponent = 0;
+    for (; p < end && isDigit(*p); ++p) {
+      if (explicit_exponent < 10000) {
+        explicit_exponent = 10 * explicit_exponent + (*p - '0');
+      }
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+
+  // A mantissa below 2^53 and a power of ten up to 1e22 are both exact, so
+  // the multiplication or division is correctly rounded.
+  double result = static_cast<double>(mantissa);
+  if (exponent >= 0 && exponent <= kMaxExactPowerOfTen) {
+    result *= kPowersOfTen[exponent];
+  } else if (exponent < 0 && exponent >= -kMaxExactPowerOfTen) {
+    result /= kPowersOfTen[-exponent];
+  } else if (mantissa != 0u) {
+    result *= std::pow(10.0, exponent);
+  }
+  *value = negative ? -result : result;
+  return p;
+}
+
+void loadAsciiPointCloud(
+    const std::string& filename, const AsciiPointCloudSettings& settings,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
+    std::vector<int>* point_cloud_intensities) {
+  CHECK_NOTNULL(point_cloud_xyz);
+  if (point_cloud_intensities != nullptr) {
+    CHECK_EQ(point_cloud_xyz->size(), point_cloud_intensities->size());
+  }
+  const int file_descriptor = open(filename.c_str(), O_RDONLY);
+  CHECK_GE(file_descriptor, 0) << "Cannot open " << filename << ": "
+                               << std::strerror(errno);
+  struct stat file_status;
+  CHECK_EQ(fstat(file_descriptor, &file_status), 0);
+  const size_t file_size = static_cast<size_t>(file_status.st_size);
+  if (file_size == 0u) {
+    close(file_descriptor);
+    LOG(WARNING) << filename << " is empty.";
+    return;
+  }
+  void* mapping =
+      mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  CHECK(mapping != MAP_FAILED) << "Cannot map " << filename << ": "
+                               << std::strerror(errno);
+  madvise(mapping, file_size, MADV_SEQUENTIAL);
+  const char* data = static_cast<const char*>(mapping);
+
+  utils::ThreadPoolSettings thread_pool_settings;
+  thread_pool_settings.num_threads = settings.num_threads;
+  utils::ThreadPool thread_pool(thread_pool_settings);
+
+  // Split the file into chunks that end after a newline.
+  const size_t chunk_size_bytes = std::min(
+      std::max(file_size / (kChunksPerThread * thread_pool.getNumThreads()),
+               kMinChunkSizeBytes),
+      kMaxChunkSizeBytes);
+  std::vector<const char*> chunk_begin(1u, data);
+  while (true) {
+    const size_t offset = chunk_begin.back() - data + chunk_size_bytes;
+    if (offset >= file_size) {
+      break;
+    }
+    const char* newline = static_cast<const char*>(
+        std::memchr(data + offset, '\n', file_size - offset));
+    if (newline == nullptr || newline + 1 == data + file_size) {
+      break;
+    }
+    chunk_begin.push_back(newline + 1);
+  }
+  chunk_begin.push_back(data + file_size);
+  const size_t num_chunks = chunk_begin.size() - 1u;
+
+  // Parse the chunks in parallel.
+  const bool parse_intensities = point_cloud_intensities != nullptr;
+  std::vector<ChunkResult> chunk_results(num_chunks);
+  thread_pool.parallelFor(num_chunks, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      parseChunk(chunk_begin[chunk], chunk_begin[chunk + 1u],
+                 settings.min_elevation, parse_intensities,
+                 &chunk_results[chunk]);
+    }
+  }, 1u);
+  munmap(mapping, file_size);
+
+  // Concatenate the chunks in file order.
+  std::vector<size_t> chunk_offset(num_chunks + 1u, point_cloud_xyz->size());
+  size_t num_skipped_lines = 0u;
+  for (size_t chunk = 0u; chunk < num_chunks; ++chunk) {
+    chunk_offset[chunk + 1u] =
+        chunk_offset[chunk] + chunk_results[chunk].xyz.size();
+    num_skipped_lines += chunk_results[chunk].num_skipped_lines;
+  }
+  point_cloud_xyz->resize(chunk_offset.back());
+  if (parse_intensities) {
+    point_cloud_intensities->resize(chunk_offset.back());
+  }
+  thread_pool.parallelFor(num_chunks, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      ChunkResult& result = chunk_results[chunk];
+      std::copy(result.xyz.begin(), result.xyz.end(),
+                point_cloud_xyz->begin() + chunk_offset[chunk]);
+      if (parse_intensities) {
+        std::copy(result.intensities.begin(), result.intensities.end(),
+                  point_cloud_intensities->begin() + chunk_offset[chunk]);
+      }
+      // Release the chunk early to limit the peak memory.
+      result = ChunkResult();
+    }
+  }, 1u);
+
+  LOG(INFO) << "Parsed " << chunk_offset.back() - chunk_offset.front()
+            << " points from " << file_size / (1u << 20) << " MB in "
+            << num_chunks << " chunks.";
+  if (num_skipped_lines > 0u) {
+    LOG(WARNING) << "Skipped " << num_skipped_lines
+                 << " malformed lines in " << filename << ".";
+  }
+}
+
+}  // namespace io
@@ -0,0 +1,247 @@
+/*
+ *    Filename: aerial-mapper-binary-point-cloud.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-io/aerial-mapper-binary-point-cloud.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace io {
+
+namespace {
+const char kMagic[8] = {'A', 'M', 'P', 'C', 'L', 'B', 'I', 'N'};
+
+// Number of points converted to single precision per write.
+constexpr size_t kWriteChunkSize = 1u << 20;
+
+template <typename Functor>
+void writeArray(size_t num_points, const Functor& get_value,
+                std::ofstream* stream) {
+  typedef decltype(get_value(size_t(0u))) Value;
+  std::vector<Value> chunk;
+  chunk.reserve(std::min(num_points, kWriteChunkSize));
+  for (size_t begin = 0u; begin < num_points; begin += kWriteChunkSize) {
+    const size_t end = std::min(begin + kWriteChunkSize, num_points);
+    chunk.clear();
+    for (size_t i = begin; i < end; ++i) {
+      chunk.push_back(get_value(i));
+    }
+    stream->write(reinterpret_cast<const char*>(chunk.data()),
+                  chunk.size() * sizeof(Value));
+  }
+}
+}  // namespace
+
+constexpr uint32_t BinaryPointCloudHeader::kHasIntensities;
+constexpr uint32_t BinaryPointCloud::kVersion;
+
+BinaryPointCloud::BinaryPointCloud()
+    : mapping_(nullptr), mapping_size_bytes_(0u), header_(nullptr) {}
+
+BinaryPointCloud::~BinaryPointCloud() { close(); }
+
+bool BinaryPointCloud::open(const std::string& filename) {
+  close();
+  const int file_descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (file_descriptor < 0) {
+    LOG(ERROR) << "Cannot open " << filename << ": " << std::strerror(errno);
+    return false;
+  }
+  struct stat file_status;
+  CHECK_EQ(fstat(file_descriptor, &file_status), 0);
+  const size_t file_size = static_cast<size_t>(file_status.st_size);
+  if (file_size < sizeof(BinaryPointCloudHeader)) {
+    LOG(ERROR) << filename << " is not a binary point cloud.";
+    ::close(file_descriptor);
+    return false;
+  }
+  void* mapping =
+      mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+  // The mapping stays valid after closing the file descriptor.
+  ::close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    LOG(ERROR) << "Cannot map " << filename << ": " << std::strerror(errno);
+    return false;
+  }
+
+  const BinaryPointCloudHeader* header =
+      static_cast<const BinaryPointCloudHeader*>(mapping);
+  bool valid = true;
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    LOG(ERROR) << filename << " is not a binary point cloud.";
+    valid = false;
+  } else if (header->version != kVersion) {
+    LOG(ERROR) << filename << " has unsupported version " << header->version
+               << " (supported: " << kVersion << ").";
+    valid = false;
+  } else {
+    const size_t bytes_per_point =
+        3u * sizeof(float) +
+        ((header->flags & BinaryPointCloudHeader::kHasIntensities)
+             ? sizeof(int32_t)
+             : 0u);
+    // Checked before multiplying, so a corrupt header cannot overflow.
+    const size_t max_num_points =
+        (file_size - sizeof(BinaryPointCloudHeader)) / bytes_per_point;
+    if (header->num_points > max_num_points) {
+      LOG(ERROR) << filename << " is truncated (" << header->num_points
+                 << " points, space for " << max_num_points << ").";
+      valid = false;
+    }
+  }
+  if (!valid) {
+    munmap(mapping, file_size);
+    return false;
+  }
+
+  mapping_ = mapping;
+  mapping_size_bytes_ = file_size;
+  header_ = header;
+  LOG(INFO) << "Mapped " << size() << " points from " << filename << ".";
+  return true;
+}
+
+void BinaryPointCloud::close() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_bytes_);
+  }
+  mapping_ = nullptr;
+  mapping_size_bytes_ = 0u;
+  header_ = nullptr;
+}
+
+bool BinaryPointCloud::isBinaryPointCloudFile(const std::string& filename) {
+  std::ifstream stream(filename, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return stream.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+void BinaryPointCloud::write(
+    const std::string& filename,
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    const std::vector<int>* intensities) {
+  static_assert(sizeof(int) == sizeof(int32_t), "Expected 32 bit integers.");
+  const size_t num_points = point_cloud.size();
+  if (intensities != nullptr) {
+    CHECK_EQ(intensities->size(), num_points);
+  }
+
+  Eigen::Vector3d min = Eigen::Vector3d::Zero();
+  Eigen::Vector3d max = Eigen::Vector3d::Zero();
+  if (num_points > 0u) {
+    min = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+    max = -min;
+    for (const Eigen::Vector3d& point : point_cloud) {
+      min = min.cwiseMin(point);
+      max = max.cwiseMax(point);
+    }
+  }
+  const Eigen::Vector3d origin = (0.5 * (min + max)).array().round().matrix();
+
+  BinaryPointCloudHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.flags =
+      intensities != nullptr ? BinaryPointCloudHeader::kHasIntensities : 0u;
+  header.num_points = num_points;
+  for (int dim = 0; dim < 3; ++dim) {
+    header.origin[dim] = origin(dim);
+    header.min[dim] = static_cast<float>(min(dim) - origin(dim));
+    header.max[dim] = static_cast<float>(max(dim) - origin(dim));
+  }
+
+  std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+  CHECK(stream.is_open()) << "Cannot open " << filename;
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int dim = 0; dim < 3; ++dim) {
+    writeArray(num_points,
+               [&](size_t i) {
+                 return static_cast<float>(point_cloud[i](dim) - origin(dim));
+               },
+               &stream);
+  }
+  if (intensities != nullptr) {
+    stream.write(reinterpret_cast<const char*>(intensities->data()),
+                 num_points * sizeof(int32_t));
+  }
+  CHECK(stream.good()) << "Writing " << filename << " failed.";
+  LOG(INFO) << "Wrote " << num_points << " points to " << filename << ".";
+}
+
+Eigen::Vector3d BinaryPointCloud::getOrigin() const {
+  CHECK(isOpen());
+  return Eigen::Vector3d(header_->origin[0], header_->origin[1],
+                         header_->origin[2]);
+}
+
+Eigen::Vector3d BinaryPointCloud::getMin() const {
+  CHECK(isOpen());
+  return getOrigin() +
+         Eigen::Vector3f(header_->min[0], header_->min[1], header_->min[2])
+             .cast<double>();
+}
+
+Eigen::Vector3d BinaryPointCloud::getMax() const {
+  CHECK(isOpen());
+  return getOrigin() +
+         Eigen::Vector3f(header_->max[0], header_->max[1], header_->max[2])
+             .cast<double>();
+}
+
+PointCloudSoAView<float> BinaryPointCloud::getPoints() const {
+  CHECK(isOpen());
+  const float* x = reinterpret_cast<const float*>(header_ + 1);
+  return PointCloudSoAView<float>(x, x + size(), x + 2u * size(), size());
+}
+
+const int* BinaryPointCloud::getIntensities() const {
+  CHECK(isOpen());
+  if (!(header_->flags & BinaryPointCloudHeader::kHasIntensities)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const int*>(
+      reinterpret_cast<const float*>(header_ + 1) + 3u * size());
+}
+
+void BinaryPointCloud::toPointCloud(
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud,
+    std::vector<int>* intensities) const {
+  CHECK_NOTNULL(point_cloud);
+  CHECK(isOpen());
+  const PointCloudSoAView<float> points = getPoints();
+  const Eigen::Vector3d origin = getOrigin();
+  point_cloud->resize(points.num_points);
+  for (size_t i = 0u; i < points.num_points; ++i) {
+    (*point_cloud)[i] =
+        origin + Eigen::Vector3d(points.x[i], points.y[i], points.z[i]);
+  }
+  if (intensities != nullptr) {
+    const int* point_intensities = getIntensities();
+    if (point_intensities != nullptr) {
+      intensities->assign(point_intensities,
+                          point_intensities + points.num_points);
+    } else {
+      intensities->assign(points.num_points, 0);
+    }
+  }
+}
+
+}  // namespace io
@@ -0,0 +1,311 @@
+/*
+ *    Filename: aerial-mapper-geotiff.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-io/aerial-mapper-geotiff.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// NON-SYSTEM
+#include <gdal/cpl_conv.h>
+#include <gdal/cpl_string.h>
+#include <gdal/gdal.h>
+#include <gdal/gdal_priv.h>
+#include <gdal/ogr_spatialref.h>
+#include <glog/logging.h>
+
+namespace io {
+
+namespace {
+inline GDALDataType getGdalDataType(GeoTiffPixelType pixel_type) {
+  return pixel_type == GeoTiffPixelType::kByte ? GDT_Byte : GDT_Float32;
+}
+
+inline size_t getPixelBytes(GeoTiffPixelType pixel_type) {
+  return pixel_type == GeoTiffPixelType::kByte ? sizeof(uint8_t)
+                                               : sizeof(float);
+}
+
+const char* getCompressionName(GeoTiffCompression compression) {
+  switch (compression) {
+    case GeoTiffCompression::kDeflate:
+      return "DEFLATE";
+    case GeoTiffCompression::kLzw:
+      return "LZW";
+    default:
+      return "NONE";
+  }
+}
+
+inline void convertPixel(float value, uint8_t* pixel) {
+  if (!std::isfinite(value)) {
+    *pixel = 0u;
+    return;
+  }
+  *pixel = static_cast<uint8_t>(
+      std::min(std::max(std::round(value), 0.0f), 255.0f));
+}
+
+inline void convertPixel(float value, float* pixel) { *pixel = value; }
+
+/// Copies the rows [row_begin, row_end) of the raster that covers the map into
+/// the buffer, with the layers interleaved. Raster row r is the map column
+/// with index(1) = r; the raster columns run towards increasing easting, i.e.
+/// decreasing index(0).
+template <typename Pixel>
+void convertGridMapRows(const grid_map::GridMap& map,
+                        const std::vector<std::string>& layers, int row_begin,
+                        int row_end, Pixel* buffer) {
+  const int width = map.getSize()(0);
+  const size_t num_bands = layers.size();
+  for (size_t band = 0u; band < num_bands; ++band) {
+    const grid_map::Matrix& data = map[layers[band]];
+    for (int row = row_begin; row < row_end; ++row) {
+      const float* column = data.data() + static_cast<size_t>(row) * width;
+      Pixel* pixel =
+          buffer + static_cast<size_t>(row - row_begin) * width * num_bands +
+          band;
+      for (int x = width - 1; x >= 0; --x, pixel += num_bands) {
+        convertPixel(column[x], pixel);
+      }
+    }
+  }
+}
+}  // namespace
+
+GeoTiffWriter::GeoTiffWriter(const std::string& filename, int width,
+                             int height, int num_bands,
+                             GeoTiffPixelType pixel_type,
+                             const Eigen::Vector2d& top_left,
+                             double resolution,
+                             const GeoTiffSettings& settings)
+    : settings_(settings),
+      width_(width),
+      height_(height),
+      num_bands_(num_bands),
+      pixel_type_(pixel_type),
+      top_left_(top_left),
+      resolution_(resolution),
+      dataset_(nullptr) {
+  CHECK(!filename.empty());
+  CHECK_GT(width_, 0);
+  CHECK_GT(height_, 0);
+  CHECK_GT(num_bands_, 0);
+  CHECK_GT(resolution_, 0.0);
+  CHECK_GT(settings_.block_size, 0);
+  CHECK_EQ(settings_.block_size % 16, 0)
+      << "GeoTIFF tiles must be a multiple of 16 pixels.";
+
+  GDALAllRegister();
+  GDALDriver* driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  CHECK_NOTNULL(driver);
+
+  const std::string block_size = std::to_string(settings_.block_size);
+  const std::string num_threads =
+      settings_.num_threads == 0u ? "ALL_CPUS"
+                                  : std::to_string(settings_.num_threads);
+  char** options = nullptr;
+  options = CSLSetNameValue(options, "TILED", "YES");
+  options = CSLSetNameValue(options, "BLOCKXSIZE", block_size.c_str());
+  options = CSLSetNameValue(options, "BLOCKYSIZE", block_size.c_str());
+  options = CSLSetNameValue(options, "COMPRESS",
+                            getCompressionName(settings_.compression));
+  if (settings_.compression != GeoTiffCompression::kNone) {
+    // Horizontal differencing of integers or floating point values.
+    options = CSLSetNameValue(
+        options, "PREDICTOR",
+        pixel_type_ == GeoTiffPixelType::kByte ? "2" : "3");
+  }
+  options = CSLSetNameValue(options, "NUM_THREADS", num_threads.c_str());
+  options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+  options = CSLSetNameValue(options, "INTERLEAVE", "PIXEL");
+  if (num_bands_ == 3 && pixel_type_ == GeoTiffPixelType::kByte) {
+    options = CSLSetNameValue(options, "PHOTOMETRIC", "RGB");
+  }
+  dataset_ = driver->Create(filename.c_str(), width_, height_, num_bands_,
+                            getGdalDataType(pixel_type_), options);
+  CSLDestroy(options);
+  CHECK(dataset_ != nullptr) << "Cannot create " << filename;
+
+  double geo_transform[6] = {top_left_(0), resolution_, 0.0,
+                             top_left_(1), 0.0,         -resolution_};
+  CHECK_EQ(dataset_->SetGeoTransform(geo_transform), CE_None);
+  OGRSpatialReference spatial_reference;
+  spatial_reference.SetWellKnownGeogCS("WGS84");
+  spatial_reference.SetUTM(settings_.utm_zone,
+                           settings_.northern_hemisphere ? TRUE : FALSE);
+  char* wkt = nullptr;
+  spatial_reference.exportToWkt(&wkt);
+  CHECK_EQ(dataset_->SetProjection(wkt), CE_None);
+  CPLFree(wkt);
+
+  const double no_data = pixel_type_ == GeoTiffPixelType::kByte
+                             ? 0.0
+                             : std::numeric_limits<double>::quiet_NaN();
+  for (int band = 1; band <= num_bands_; ++band) {
+    dataset_->GetRasterBand(band)->SetNoDataValue(no_data);
+  }
+  VLOG(3) << "Created " << filename << " with " << width_ << " x " << height_
+          << " pixels and " << num_bands_ << " bands.";
+}
+
+GeoTiffWriter::~GeoTiffWriter() { close(); }
+
+void GeoTiffWriter::write(int x, int y, int width, int height,
+                          const void* data, size_t line_stride_bytes) {
+  std::vector<int> band_order(num_bands_);
+  for (int band = 0; band < num_bands_; ++band) {
+    band_order[band] = band + 1;
+  }
+  write(x, y, width, height, data, line_stride_bytes, band_order);
+}
+
+void GeoTiffWriter::write(int x, int y, int width, int height,
+                          const void* data, size_t line_stride_bytes,
+                          const std::vector<int>& band_order) {
+  CHECK(dataset_ != nullptr) << "The GeoTIFF is closed.";
+  CHECK_NOTNULL(data);
+  CHECK_EQ(band_order.size(), static_cast<size_t>(num_bands_));
+  CHECK(x >= 0 && y >= 0 && x + width <= width_ && y + height <= height_)
+      << "Window " << width << " x " << height << " at (" << x << ", " << y
+      << ") exceeds the raster.";
+  const size_t pixel_bytes = getPixelBytes(pixel_type_);
+  // GDAL does not modify the buffer when writing.
+  const CPLErr error = dataset_->RasterIO(
+      GF_Write, x, y, width, height, const_cast<void*>(data), width, height,
+      getGdalDataType(pixel_type_), num_bands_,
+      const_cast<int*>(band_order.data()), num_bands_ * pixel_bytes,
+      line_stride_bytes, pixel_bytes, nullptr);
+  CHECK_EQ(error, CE_None) << CPLGetLastErrorMsg();
+}
+
+void GeoTiffWriter::writeImage(const cv::Mat& image, int x, int y) {
+  CHECK_EQ(image.channels(), num_bands_);
+  if (pixel_type_ == GeoTiffPixelType::kByte) {
+    CHECK_EQ(image.depth(), CV_8U);
+  } else {
+    CHECK_EQ(image.depth(), CV_32F);
+  }
+  std::vector<int> band_order(num_bands_);
+  for (int band = 0; band < num_bands_; ++band) {
+    band_order[band] = band + 1;
+  }
+  if (num_bands_ == 3) {
+    // OpenCV stores BGR, the GeoTIFF bands are RGB.
+    std::reverse(band_order.begin(), band_order.end());
+  }
+  write(x, y, image.cols, image.rows, image.data, image.step[0], band_order);
+}
+
+void GeoTiffWriter::writeGridMap(const grid_map::GridMap& map,
+                                 const std::vector<std::string>& layers) {
+  CHECK_EQ(layers.size(), static_cast<size_t>(num_bands_));
+  CHECK(map.isDefaultStartIndex())
+      << "Moved maps are not supported, call convertToDefaultStartIndex().";
+  CHECK_NEAR(map.getResolution(), resolution_, 1e-6 * resolution_);
+  const grid_map::Size& size = map.getSize();
+  const Eigen::Vector2d map_top_left(
+      map.getPosition().x() - 0.5 * map.getLength().x(),
+      map.getPosition().y() + 0.5 * map.getLength().y());
+  const int x = static_cast<int>(
+      std::round((map_top_left(0) - top_left_(0)) / resolution_));
+  const int y = static_cast<int>(
+      std::round((top_left_(1) - map_top_left(1)) / resolution_));
+
+  // Convert one row of raster tiles at a time.
+  const size_t row_bytes =
+      static_cast<size_t>(size(0)) * num_bands_ * getPixelBytes(pixel_type_);
+  std::vector<uint8_t> buffer(row_bytes * settings_.block_size);
+  for (int row_begin = 0; row_begin < size(1);
+       row_begin += settings_.block_size) {
+    const int row_end = std::min(row_begin + settings_.block_size, size(1));
+    if (pixel_type_ == GeoTiffPixelType::kByte) {
+      convertGridMapRows(map, layers, row_begin, row_end, buffer.data());
+    } else {
+      convertGridMapRows(map, layers, row_begin, row_end,
+                         reinterpret_cast<float*>(buffer.data()));
+    }
+    write(x, y + row_begin, size(0), row_end - row_begin, buffer.data(),
+          row_bytes);
+  }
+}
+
+void GeoTiffWriter::close() {
+  if (dataset_ == nullptr) {
+    return;
+  }
+  if (settings_.build_overviews) {
+    std::vector<int> overview_factors;
+    for (int factor = 2;
+         std::max(width_, height_) / factor >= settings_.min_overview_size;
+         factor *= 2) {
+      overview_factors.push_back(factor);
+    }
+    if (!overview_factors.empty()) {
+      const std::string num_threads =
+          settings_.num_threads == 0u ? "ALL_CPUS"
+                                      : std::to_string(settings_.num_threads);
+      CPLSetThreadLocalConfigOption("COMPRESS_OVERVIEW",
+                                    getCompressionName(settings_.compression));
+      CPLSetThreadLocalConfigOption("GDAL_NUM_THREADS", num_threads.c_str());
+      const CPLErr error = GDALBuildOverviews(
+          static_cast<GDALDatasetH>(dataset_),
+          settings_.overview_resampling.c_str(),
+          static_cast<int>(overview_factors.size()), overview_factors.data(),
+          0, nullptr, nullptr, nullptr);
+      CPLSetThreadLocalConfigOption("COMPRESS_OVERVIEW", nullptr);
+      CPLSetThreadLocalConfigOption("GDAL_NUM_THREADS", nullptr);
+      LOG_IF(WARNING, error != CE_None) << "Cannot build the overviews: "
+                                        << CPLGetLastErrorMsg();
+    }
+  }
+  GDALClose(static_cast<GDALDatasetH>(dataset_));
+  dataset_ = nullptr;
+}
+
+void writeGridMapToGeoTiff(const grid_map::GridMap& map,
+                           const std::vector<std::string>& layers,
+                           GeoTiffPixelType pixel_type,
+                           const std::string& filename,
+                           const GeoTiffSettings& settings) {
+  const Eigen::Vector2d top_left(
+      map.getPosition().x() - 0.5 * map.getLength().x(),
+      map.getPosition().y() + 0.5 * map.getLength().y());
+  GeoTiffWriter writer(filename, map.getSize()(0), map.getSize()(1),
+                       static_cast<int>(layers.size()), pixel_type, top_left,
+                       map.getResolution(), settings);
+  writer.writeGridMap(map, layers);
+  writer.close();
+}
+
+void writeTiledGridMapToGeoTiff(grid_map::TiledGridMap* map,
+                                const std::vector<std::string>& layers,
+                                GeoTiffPixelType pixel_type,
+                                const std::string& filename,
+                                const GeoTiffSettings& settings) {
+  CHECK_NOTNULL(map);
+  // The raster covers all tiles. The map corner with index (0, 0) is the
+  // north-east corner.
+  const Eigen::Array2i size =
+      map->getNumTilesPerDimension() * map->getTileSizeCells();
+  const Eigen::Vector2d top_left(
+      map->getMapCorner().x() - size(0) * map->getResolution(),
+      map->getMapCorner().y());
+  GeoTiffWriter writer(filename, size(0), size(1),
+                       static_cast<int>(layers.size()), pixel_type, top_left,
+                       map->getResolution(), settings);
+  map->forEachTile([&](size_t /*tile_index*/, grid_map::GridMap* tile) {
+    writer.writeGridMap(*tile, layers);
+  });
+  writer.close();
+}
+
+}  // namespace io
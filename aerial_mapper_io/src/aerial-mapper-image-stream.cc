@@ -0,0 +1,137 @@
+/*
+ *    Filename: aerial-mapper-image-stream.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-io/aerial-mapper-image-stream.h"
+
+// SYSTEM
+#include <algorithm>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+#include <opencv2/highgui/highgui.hpp>
+
+namespace io {
+
+namespace {
+inline size_t getImageBytes(const cv::Mat& image) {
+  return image.total() * image.elemSize();
+}
+
+int getImreadFlags(const ImageStreamSettings& settings) {
+  switch (settings.reduction_factor) {
+    case 1u:
+      return settings.load_colored_images ? cv::IMREAD_COLOR
+                                          : cv::IMREAD_GRAYSCALE;
+    case 2u:
+      return settings.load_colored_images ? cv::IMREAD_REDUCED_COLOR_2
+                                          : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    case 4u:
+      return settings.load_colored_images ? cv::IMREAD_REDUCED_COLOR_4
+                                          : cv::IMREAD_REDUCED_GRAYSCALE_4;
+    case 8u:
+      return settings.load_colored_images ? cv::IMREAD_REDUCED_COLOR_8
+                                          : cv::IMREAD_REDUCED_GRAYSCALE_8;
+    default:
+      LOG(FATAL) << "Unsupported reduction factor "
+                 << settings.reduction_factor;
+      return cv::IMREAD_UNCHANGED;
+  }
+}
+}  // namespace
+
+ImageStream::ImageStream(const std::vector<std::string>& filenames,
+                         const ImageStreamSettings& settings)
+    : filenames_(filenames),
+      settings_(settings),
+      next_index_to_decode_(0u),
+      next_index_to_return_(0u),
+      num_decoding_(0u),
+      buffered_bytes_(0u),
+      expected_image_bytes_(0u) {
+  CHECK_GT(settings_.num_prefetched_images, 0u);
+  CHECK(settings_.reduction_factor == 1u || settings_.reduction_factor == 2u ||
+        settings_.reduction_factor == 4u || settings_.reduction_factor == 8u)
+      << "Unsupported reduction factor " << settings_.reduction_factor;
+  utils::ThreadPoolSettings thread_pool_settings;
+  thread_pool_settings.num_threads = settings_.num_threads;
+  thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
+  std::lock_guard<std::mutex> lock(mutex_);
+  scheduleDecodes();
+}
+
+ImageStream::~ImageStream() {
+  // The decode tasks reference this object.
+  std::unique_lock<std::mutex> lock(mutex_);
+  image_decoded_.wait(lock, [this]() { return num_decoding_ == 0u; });
+}
+
+std::vector<std::string> ImageStream::getFilenames(
+    const std::string& filename_base, size_t num_images, size_t step,
+    const std::string& extension) {
+  CHECK_GT(step, 0u);
+  std::vector<std::string> filenames;
+  for (size_t i = step - 1u; i < num_images; i += step) {
+    filenames.push_back(filename_base + std::to_string(i) + extension);
+  }
+  return filenames;
+}
+
+size_t ImageStream::getNextIndex() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return next_index_to_return_;
+}
+
+bool ImageStream::next(cv::Mat* image) {
+  CHECK_NOTNULL(image);
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (next_index_to_return_ >= size()) {
+    return false;
+  }
+  scheduleDecodes();
+  image_decoded_.wait(lock, [this]() {
+    return decoded_images_.count(next_index_to_return_) > 0u;
+  });
+  std::map<size_t, cv::Mat>::iterator it =
+      decoded_images_.find(next_index_to_return_);
+  *image = it->second;
+  buffered_bytes_ -= getImageBytes(it->second);
+  decoded_images_.erase(it);
+  ++next_index_to_return_;
+  scheduleDecodes();
+  return true;
+}
+
+void ImageStream::scheduleDecodes() {
+  while (next_index_to_decode_ < size() &&
+         next_index_to_decode_ - next_index_to_return_ <
+             settings_.num_prefetched_images) {
+    const bool is_next_image = next_index_to_decode_ == next_index_to_return_;
+    const size_t expected_bytes =
+        buffered_bytes_ + (num_decoding_ + 1u) * expected_image_bytes_;
+    if (!is_next_image && expected_bytes > settings_.max_buffered_bytes) {
+      break;
+    }
+    const size_t index = next_index_to_decode_++;
+    ++num_decoding_;
+    thread_pool_->submit([this, index]() { decode(index); });
+  }
+}
+
+void ImageStream::decode(size_t index) {
+  const cv::Mat image =
+      cv::imread(filenames_[index], getImreadFlags(settings_));
+  LOG_IF(WARNING, image.empty()) << "Cannot read " << filenames_[index];
+  std::lock_guard<std::mutex> lock(mutex_);
+  decoded_images_[index] = image;
+  buffered_bytes_ += getImageBytes(image);
+  expected_image_bytes_ = std::max(expected_image_bytes_, getImageBytes(image));
+  --num_decoding_;
+  image_decoded_.notify_all();
+}
+
+}  // namespace io
@@ -15,11 +15,11 @@
 // NON-SYSTEM
 #include <glog/logging.h>
 
+#include "aerial-mapper-io/aerial-mapper-ascii-point-cloud.h"
+#include "aerial-mapper-io/aerial-mapper-binary-point-cloud.h"
+#include "aerial-mapper-io/aerial-mapper-image-stream.h"
+
 #include <cstdlib>
-#include <gdal/cpl_string.h>
-#include <gdal/gdal.h>
-#include <gdal/gdal_priv.h>
-#include <gdal/ogr_spatialref.h>
 
 #include <geometry_msgs/Quaternion.h>
 #include <geometry_msgs/Point.h>
@@ -209,21 +209,8 @@ void AerialMapperIO::loadImagesFromFile(
     bool load_colored_images) {
   CHECK(images);
   LOG(INFO) << "Loading images from directory+prefix: " << filename_base;
-  for (size_t i = 0u; i < num_poses; ++i) {
-    const std::string& filename =
-        filename_base + std::to_string(i) + ".jpg";
-    cv::Mat image;
-    if (!load_colored_images) {
-      image = cv::imread(filename, CV_LOAD_IMAGE_GRAYSCALE);
-    } else {
-      image = cv::imread(filename, CV_LOAD_IMAGE_COLOR);
-    }
-    cv::imshow("Image", image);
-    cv::waitKey(1);
-    images->push_back(image);
-  }
-  CHECK(images->size() > 0) << "No images loaded.";
-  LOG(INFO) << "Number of images loaded: " << images->size();
+  loadImages(ImageStream::getFilenames(filename_base, num_poses),
+             load_colored_images, images);
 }
 
 void AerialMapperIO::loadImagesFromFile(
@@ -231,17 +218,21 @@ void AerialMapperIO::loadImagesFromFile(
     Images* images, bool load_colored_images) {
   CHECK(images);
   LOG(INFO) << "Loading images from directory: " << directory;
-  for (const std::string image_name : image_names) {
-    const std::string& filename =
-        directory + image_name + ".png";
-    cv::Mat image;
-    if (!load_colored_images) {
-      image = cv::imread(filename, CV_LOAD_IMAGE_GRAYSCALE);
-    } else {
-      image = cv::imread(filename, CV_LOAD_IMAGE_COLOR);
-    }
-    cv::imshow("Image", image);
-    cv::waitKey(1);
+  std::vector<std::string> filenames;
+  for (const std::string& image_name : image_names) {
+    filenames.push_back(directory + image_name + ".png");
+  }
+  loadImages(filenames, load_colored_images, images);
+}
+
+void AerialMapperIO::loadImages(const std::vector<std::string>& filenames,
+                                bool load_colored_images, Images* images) {
+  CHECK(images);
+  ImageStreamSettings settings;
+  settings.load_colored_images = load_colored_images;
+  ImageStream image_stream(filenames, settings);
+  cv::Mat image;
+  while (image_stream.next(&image)) {
     images->push_back(image);
   }
   CHECK(images->size() > 0) << "No images loaded.";
@@ -309,203 +300,70 @@ void AerialMapperIO::exportPix4dGeofile(const Poses& T_G_Cs,
 void AerialMapperIO::loadPointCloudFromFile(
     const std::string& filename_point_cloud,
     AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz) {
-  CHECK(filename_point_cloud != "");
-  CHECK(point_cloud_xyz);
-  LOG(INFO) << "Loading pointcloud from: " << filename_point_cloud;
-  std::ifstream infile(filename_point_cloud);
-  double x, y, z;
-  int intensity;
-  while (infile >> x >> y >> z >> intensity) {
-    if (z > -100) {
-      point_cloud_xyz->push_back(Eigen::Vector3d(x, y, z));
-    }
-    if (infile.eof()) break;
-  }
-  CHECK(point_cloud_xyz->size() > 0);
+  loadPointCloud(filename_point_cloud, point_cloud_xyz, nullptr);
 }
 
 void AerialMapperIO::loadPointCloudFromFile(
     const std::string& filename_point_cloud,
     AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
     std::vector<int>* point_cloud_intensities) {
+  CHECK(point_cloud_intensities);
+  loadPointCloud(filename_point_cloud, point_cloud_xyz,
+                 point_cloud_intensities);
+  CHECK(point_cloud_xyz->size() == point_cloud_intensities->size());
+}
+
+void AerialMapperIO::loadPointCloud(
+    const std::string& filename_point_cloud,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_xyz,
+    std::vector<int>* point_cloud_intensities) {
   CHECK(filename_point_cloud != "");
   CHECK(point_cloud_xyz);
-  CHECK(point_cloud_intensities);
   LOG(INFO) << "Loading pointcloud from: " << filename_point_cloud;
-  std::ifstream infile(filename_point_cloud);
-  double x, y, z;
-  int intensity;
-  while (infile >> x >> y >> z >> intensity) {
-    if (z > -100) {
-      point_cloud_xyz->push_back(Eigen::Vector3d(x, y, z));
-      point_cloud_intensities->push_back(intensity);
-    }
-    if (infile.eof()) break;
+  if (BinaryPointCloud::isBinaryPointCloudFile(filename_point_cloud)) {
+    BinaryPointCloud binary_point_cloud;
+    CHECK(binary_point_cloud.open(filename_point_cloud));
+    binary_point_cloud.toPointCloud(point_cloud_xyz, point_cloud_intensities);
+  } else {
+    loadAsciiPointCloud(filename_point_cloud, AsciiPointCloudSettings(),
+                        point_cloud_xyz, point_cloud_intensities);
   }
-  CHECK(point_cloud_xyz->size() == point_cloud_intensities->size());
   CHECK(point_cloud_xyz->size() > 0);
 }
 
-void AerialMapperIO::toGeoTiff(    const cv::Mat& orthomosaic,
-                                   const Eigen::Vector2d& xy,
-                                   const std::string& geotiff_filename) {
-
-
-  // Create a geotiff with GDAL.
-  GDALAllRegister();
-
-  //  const char *pszFormat = "GTiff";
-  std::string name = "GTiff";
-  GDALDriver *poDriver;
-  char **papszMetadata;
-  poDriver = GetGDALDriverManager()->GetDriverByName(name.c_str());
-  //  if( poDriver == NULL )
-  //    exit( 1 );
-  papszMetadata = poDriver->GetMetadata();
-  if( CSLFetchBoolean( papszMetadata, GDAL_DCAP_CREATE, FALSE ) )
-    printf( "Driver %s supports Create() method.\n", name.c_str() );
-  if( CSLFetchBoolean( papszMetadata, GDAL_DCAP_CREATECOPY, FALSE ) )
-    printf( "Driver %s supports CreateCopy() method.\n", name.c_str() );
-
-  GDALDataset* poDstDS;
-  char **papszOptions = NULL;
-
-  int height = orthomosaic.rows;
-  int width = orthomosaic.cols;
-  std::cout << "height = " << height << std::endl;
-  std::cout << "width = " << width << std::endl;
-  poDstDS = poDriver->Create(geotiff_filename.c_str(), width, height,
-                             1, GDT_Byte, papszOptions );
-
-  //double adfGeoTransform[6] = {464736.27, 1.0, 0.0, 5272359.16, 0.0, -1.0};
-  double adfGeoTransform[6] = {464499.00, 1.0, 0.0, 5.2727e+06, 0.0, -1.0};
-  //{ 444720, 30, 0, 3751320, 0, -30 };
-  OGRSpatialReference oSRS;
-  char *pszSRS_WKT = NULL;
-  GDALRasterBand *poBand;
-  GByte abyRaster[512*512];
-  poDstDS->SetGeoTransform(adfGeoTransform );
-  //  oSRS.SetUTM( 11, TRUE );
-  //  oSRS.SetWellKnownGeogCS( "NAD27" );
-
-  oSRS.SetProjCS( "UTM 32 (WGS84) in northern hemisphere." );
-  oSRS.SetWellKnownGeogCS( "WGS84" );
-  oSRS.SetUTM(32, TRUE );
-  oSRS.exportToWkt( &pszSRS_WKT );
-  poDstDS->SetProjection( pszSRS_WKT );
-
-  CPLFree( pszSRS_WKT );
-  // poBand = poDstDS->GetRasterBand(1);
-  //  poBand->RasterIO( GF_Write, 0, 0, 512, 512,
-  //                    abyRaster, 512, 512, GDT_Byte, 0, 0 );
-
-  int nx_offset = 0;
-  int ny_offset = 0;
-  int nx_size = width;
-  int ny_size = height;
-  int nBufxSize = width;
-  int nBufySize = height;
-  unsigned char pdata[width * height];
-
-
-  for (size_t y = 0u; y < height; ++y) {
-    for (size_t x = 0u; x < width; ++x) {
-      CHECK(x < width);
-      CHECK(y < height);
-//      std::cout << "x = " << x << ", y = " << y << ", access. y*width+x = " << y*width+x << std::endl;
-      pdata[x + y * width]= orthomosaic.at<uchar>(y,x);
-    }
-  }
+void AerialMapperIO::convertPointCloudToBinary(
+    const std::string& filename_point_cloud,
+    const std::string& filename_binary_point_cloud) {
+  CHECK(filename_binary_point_cloud != "");
+  AlignedType<std::vector, Eigen::Vector3d>::type point_cloud_xyz;
+  std::vector<int> point_cloud_intensities;
+  loadPointCloudFromFile(filename_point_cloud, &point_cloud_xyz,
+                         &point_cloud_intensities);
+  BinaryPointCloud::write(filename_binary_point_cloud, point_cloud_xyz,
+                          &point_cloud_intensities);
+}
 
-  //  for (int n=0; n<width; n++) {
-  //    for (int m=0; m<height; m++) {
-  //      std::cout << "m = " << m << ", n = " << n << ", access. n*width+m = " << n*width+m << std::endl;
-
-  //    }
-  //  }
-  poDstDS->GetRasterBand(1)->RasterIO(GF_Write, nx_offset, ny_offset, nx_size, ny_size,
-                                      pdata, nBufxSize, nBufySize, GDT_Byte, 0, 0 );
-  /* Once we're done, close properly the dataset */
-  GDALClose( (GDALDatasetH) poDstDS );
-  std::cout << "closing the dataset." << std::endl;
+void AerialMapperIO::toGeoTiff(const cv::Mat& orthomosaic,
+                               const Eigen::Vector2d& xy,
+                               const std::string& geotiff_filename,
+                               double resolution,
+                               const GeoTiffSettings& settings) {
+  CHECK_EQ(orthomosaic.type(), CV_8UC1);
+  GeoTiffWriter writer(geotiff_filename, orthomosaic.cols, orthomosaic.rows,
+                       1, GeoTiffPixelType::kByte, xy, resolution, settings);
+  writer.writeImage(orthomosaic, 0, 0);
+  writer.close();
 }
 
 void AerialMapperIO::writeDataToDEMGeoTiffColor(
     const cv::Mat& ortho_image, const Eigen::Vector2d& xy,
-    const std::string& geotiff_filename) {
-  GDALAllRegister();
-  std::string name = "GTiff";
-  GDALDriver* poDriver;
-  char** papszMetadata;
-  poDriver = GetGDALDriverManager()->GetDriverByName(name.c_str());
-  CHECK(poDriver != NULL);
-
-  papszMetadata = poDriver->GetMetadata();
-  if (CSLFetchBoolean(papszMetadata, GDAL_DCAP_CREATE, FALSE)) {
-    VLOG(3) << "Driver " << name.c_str() << " supports Create() method.";
-  }
-  if (CSLFetchBoolean(papszMetadata, GDAL_DCAP_CREATECOPY, FALSE)) {
-    VLOG(3) << "Driver " << name.c_str() << " supports CreateCopy() method.";
-  }
-
-  GDALDataset* poDstDS;
-  char** papszOptions = NULL;
-
-  int height = ortho_image.rows;
-  int width = ortho_image.cols;
-  poDstDS = poDriver->Create(geotiff_filename.c_str(), width, height, 3,
-                             GDT_Byte, papszOptions);
-
-  double adfGeoTransform[6] = {xy(0), 1.0, 0.0, xy(1), 0.0, -1.0};
-  OGRSpatialReference oSRS;
-  char* pszSRS_WKT = NULL;
-  //  GDALRasterBand *poBand;
-  //  GByte abyRaster[512*512];
-  poDstDS->SetGeoTransform(adfGeoTransform);
-
-  int UTM = 32;
-  std::string projection_cs = "UTM " + std::to_string(UTM) +
-                              " (WGS84) in northern hemisphere.";
-  oSRS.SetProjCS(projection_cs.c_str());
-  oSRS.SetWellKnownGeogCS("WGS84");
-  oSRS.SetUTM(UTM, TRUE);
-  oSRS.exportToWkt(&pszSRS_WKT);
-  poDstDS->SetProjection(pszSRS_WKT);
-  CPLFree(pszSRS_WKT);
-
-  int nx_offset = 0;
-  int ny_offset = 0;
-  int nx_size = width;
-  int ny_size = height;
-  int nBufxSize = width;
-  int nBufySize = height;
-  unsigned char pdata[width * height];
-  unsigned char pdata2[width * height];
-  unsigned char pdata3[width * height];
-
-  for (size_t y = 0u; y < static_cast<size_t>(height); ++y) {
-    for (size_t x = 0u; x < static_cast<size_t>(width); ++x) {
-      CHECK(x < static_cast<size_t>(width));
-      CHECK(y < static_cast<size_t>(height));
-      cv::Vec3b tmp = ortho_image.at<cv::Vec3b>(y, x);
-      // TODO(hitimo): Fix color bands.
-      pdata[x + y * width] = tmp(2);
-      pdata2[x + y * width] = tmp(0);
-      pdata3[x + y * width] = tmp(1);
-    }
-  }
-  poDstDS->GetRasterBand(1)->RasterIO(GF_Write, nx_offset, ny_offset, nx_size,
-                                      ny_size, pdata, nBufxSize, nBufySize,
-                                      GDT_Byte, 0, 0);
-  poDstDS->GetRasterBand(2)->RasterIO(GF_Write, nx_offset, ny_offset, nx_size,
-                                      ny_size, pdata2, nBufxSize, nBufySize,
-                                      GDT_Byte, 0, 0);
-  poDstDS->GetRasterBand(3)->RasterIO(GF_Write, nx_offset, ny_offset, nx_size,
-                                      ny_size, pdata3, nBufxSize, nBufySize,
-                                      GDT_Byte, 0, 0);
-  // Once we're done, close properly the dataset.
-  GDALClose((GDALDatasetH)poDstDS);
-  VLOG(3) << "Closing the dataset.";
+    const std::string& geotiff_filename, double resolution,
+    const GeoTiffSettings& settings) {
+  CHECK_EQ(ortho_image.type(), CV_8UC3);
+  GeoTiffWriter writer(geotiff_filename, ortho_image.cols, ortho_image.rows,
+                       3, GeoTiffPixelType::kByte, xy, resolution, settings);
+  writer.writeImage(ortho_image, 0, 0);
+  writer.close();
 }
 
 }  // namespace io
@@ -0,0 +1,605 @@
+/*
+ *    Filename: aerial-mapper-web-tiles.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-io/aerial-mapper-web-tiles.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+// NON-SYSTEM
+#include <aerial-mapper-thirdparty/gps-conversions.h>
+#include <Eigen/LU>
+#include <glog/logging.h>
+#include <grid_map_core/GridMapMath.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+namespace io {
+
+namespace {
+constexpr int kTileSizePixels = 256;
+constexpr int kMaxZoom = 24;
+// Radius of the Web Mercator sphere [m].
+constexpr double kEarthRadius = 6378137.0;
+// The UTM position is solved every kControlPointSpacing pixels and
+// interpolated bilinearly in between; the projection is locally affine.
+constexpr int kControlPointSpacing = 32;
+constexpr int kMaxNewtonIterations = 10;
+constexpr double kNewtonTolerance = 1e-4;
+// Terrain-RGB: elevation = kTerrainRgbOffset + code * kTerrainRgbScale.
+constexpr double kTerrainRgbOffset = -10000.0;
+constexpr double kTerrainRgbScale = 0.1;
+constexpr uint32_t kTerrainRgbMaxCode = (1u << 24) - 1u;
+// Cells added around the cells that the rendered tiles cover, for the
+// curvature of the tile edges in UTM.
+constexpr int kSubmapMarginCells = 2;
+
+void createDirectories(const std::string& path) {
+  for (size_t i = 1u; i <= path.size(); ++i) {
+    if (i == path.size() || path[i] == '/') {
+      const std::string directory = path.substr(0u, i);
+      CHECK(mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST)
+          << "Cannot create " << directory << ": " << std::strerror(errno);
+    }
+  }
+}
+}  // namespace
+
+WebTileExporter::WebTileExporter(const grid_map::GridMap& map,
+                                 const WebTilesSettings& settings)
+    : settings_(settings),
+      utm_zone_(std::to_string(settings.utm_zone) +
+                (settings.northern_hemisphere ? "N" : "M")) {
+  CHECK(!settings_.directory.empty());
+  CHECK_GT(map.getResolution(), 0.0);
+  double latitude, longitude;
+  UTM::UTMtoLL(map.getPosition().y(), map.getPosition().x(), utm_zone_,
+               latitude, longitude);
+  const double meters_per_pixel_at_zoom_0 =
+      2.0 * M_PI * kEarthRadius *
+      std::cos(latitude * UTM::RADIANS_PER_DEGREE) / kTileSizePixels;
+  max_zoom_ = settings_.max_zoom >= 0
+                  ? settings_.max_zoom
+                  : static_cast<int>(std::ceil(std::log2(
+                        meters_per_pixel_at_zoom_0 / map.getResolution())));
+  max_zoom_ = std::min(std::max(max_zoom_, 0), kMaxZoom);
+  const double map_size_pixels = map.getLength().maxCoeff() /
+                                 std::ldexp(meters_per_pixel_at_zoom_0,
+                                            -max_zoom_);
+  min_zoom_ = settings_.min_zoom >= 0
+                  ? settings_.min_zoom
+                  : max_zoom_ - static_cast<int>(std::ceil(std::log2(
+                                    std::max(map_size_pixels /
+                                                 kTileSizePixels,
+                                             1.0))));
+  min_zoom_ = std::min(std::max(min_zoom_, 0), max_zoom_);
+
+  utils::ThreadPoolSettings thread_pool_settings;
+  thread_pool_settings.num_threads = settings_.num_threads;
+  thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
+  LOG(INFO) << "Exporting web tiles of zoom levels " << min_zoom_ << " to "
+            << max_zoom_ << " to " << settings_.directory;
+}
+
+void WebTileExporter::exportAll(const grid_map::GridMap& map) {
+  exportChanged(map, utils::CellRange(grid_map::Index::Zero(), map.getSize()));
+}
+
+void WebTileExporter::exportChanged(const grid_map::GridMap& map,
+                                    const utils::CellRange& changed_cells) {
+  std::vector<std::string> layers;
+  for (const std::string& layer : settings_.layers) {
+    if (map.exists(layer)) {
+      layers.push_back(layer);
+    }
+  }
+  const utils::CellRange cells = changed_cells.intersect(
+      utils::CellRange(grid_map::Index::Zero(), map.getSize()));
+  if (layers.empty() || cells.isEmpty()) {
+    return;
+  }
+
+  // Box of the changed cells in UTM.
+  grid_map::Position position_first, position_last;
+  CHECK(map.getPosition(cells.start, position_first));
+  CHECK(map.getPosition(cells.getEnd() - 1, position_last));
+  const Eigen::Vector2d half_cell =
+      Eigen::Vector2d::Constant(0.5 * map.getResolution());
+  const Eigen::Vector2d utm_min =
+      position_first.cwiseMin(position_last) - half_cell;
+  const Eigen::Vector2d utm_max =
+      position_first.cwiseMax(position_last) + half_cell;
+
+  // Render the finest level from the map, then average every coarser level
+  // from the level below.
+  utils::CellRange tiles = getTilesInBox(utm_min, utm_max, max_zoom_);
+  size_t num_tiles = 0u;
+  for (int zoom = max_zoom_; zoom >= min_zoom_; --zoom) {
+    if (zoom < max_zoom_) {
+      const Eigen::Array2i first_tile = tiles.start / 2;
+      const Eigen::Array2i last_tile = (tiles.getEnd() - 1) / 2;
+      tiles = utils::CellRange(first_tile, last_tile - first_tile + 1);
+    }
+    thread_pool_->parallelFor(tiles.getNumCells(), [&](size_t begin,
+                                                       size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const Eigen::Array2i tile(
+            tiles.start(0) + static_cast<int>(i % tiles.size(0)),
+            tiles.start(1) + static_cast<int>(i / tiles.size(0)));
+        if (zoom == max_zoom_) {
+          renderTile(map, layers, tile, zoom);
+        } else {
+          downsampleTile(layers, tile, zoom);
+        }
+      }
+    }, 1u);
+    num_tiles += tiles.getNumCells();
+  }
+  VLOG(1) << "Updated " << num_tiles << " tiles of " << layers.size()
+          << " layers.";
+}
+
+void WebTileExporter::extractChangedSubmap(
+    const grid_map::GridMap& map, const utils::CellRange& changed_cells,
+    grid_map::GridMap* submap, utils::CellRange* submap_changed_cells) const {
+  CHECK_NOTNULL(submap);
+  CHECK_NOTNULL(submap_changed_cells);
+  CHECK(map.isDefaultStartIndex());
+  std::vector<std::string> layers;
+  for (const std::string& layer : settings_.layers) {
+    if (map.exists(layer)) {
+      layers.push_back(layer);
+    }
+  }
+  *submap = grid_map::GridMap(layers);
+  *submap_changed_cells = utils::CellRange();
+  const utils::CellRange all_cells(grid_map::Index::Zero(), map.getSize());
+  const utils::CellRange cells = changed_cells.intersect(all_cells);
+  if (layers.empty() || cells.isEmpty()) {
+    return;
+  }
+
+  // Cells covered by the tiles of the finest level that exportChanged()
+  // renders. The cell indices grow towards smaller positions.
+  grid_map::Position position_first, position_last;
+  CHECK(map.getPosition(cells.start, position_first));
+  CHECK(map.getPosition(cells.getEnd() - 1, position_last));
+  const double resolution = map.getResolution();
+  const Eigen::Vector2d half_cell = Eigen::Vector2d::Constant(0.5 * resolution);
+  Eigen::Vector2d utm_min, utm_max;
+  getBoxOfTiles(getTilesInBox(position_first.cwiseMin(position_last) -
+                                  half_cell,
+                              position_first.cwiseMax(position_last) +
+                                  half_cell,
+                              max_zoom_),
+                max_zoom_, map.getPosition(), &utm_min, &utm_max);
+  const Eigen::Vector2d map_max =
+      map.getPosition() + 0.5 * map.getLength().matrix();
+  const Eigen::Array2i first_cell =
+      ((map_max - utm_max) / resolution).array().floor().cast<int>() -
+      kSubmapMarginCells;
+  const Eigen::Array2i last_cell =
+      ((map_max - utm_min) / resolution).array().floor().cast<int>() +
+      kSubmapMarginCells;
+  utils::CellRange submap_cells =
+      utils::CellRange(first_cell, last_cell - first_cell + 1)
+          .intersect(all_cells);
+  submap_cells.extend(cells);
+
+  grid_map::Position position_start, position_end;
+  CHECK(map.getPosition(submap_cells.start, position_start));
+  CHECK(map.getPosition(submap_cells.getEnd() - 1, position_end));
+  submap->setFrameId(map.getFrameId());
+  submap->setGeometry(
+      grid_map::Length(submap_cells.size.cast<double>() * resolution),
+      resolution, 0.5 * (position_start + position_end));
+  for (const std::string& layer : layers) {
+    (*submap)[layer] =
+        map[layer].block(submap_cells.start(0), submap_cells.start(1),
+                         submap_cells.size(0), submap_cells.size(1));
+  }
+  *submap_changed_cells =
+      utils::CellRange(cells.start - submap_cells.start, cells.size);
+}
+
+WebTileExporter::Encoding WebTileExporter::getEncoding(
+    const std::string& layer) {
+  if (layer == "colored_ortho") {
+    return Encoding::kColor;
+  }
+  if (layer == "elevation") {
+    return Encoding::kTerrainRgb;
+  }
+  return Encoding::kGray;
+}
+
+Eigen::Vector2d WebTileExporter::utmToMercator(
+    const Eigen::Vector2d& utm) const {
+  double latitude, longitude;
+  UTM::UTMtoLL(utm(1), utm(0), utm_zone_, latitude, longitude);
+  const double latitude_rad = latitude * UTM::RADIANS_PER_DEGREE;
+  return Eigen::Vector2d(
+      kEarthRadius * longitude * UTM::RADIANS_PER_DEGREE,
+      kEarthRadius * std::log(std::tan(M_PI / 4.0 + 0.5 * latitude_rad)));
+}
+
+Eigen::Vector2d WebTileExporter::mercatorToUtm(
+    const Eigen::Vector2d& mercator,
+    const Eigen::Vector2d& initial_utm) const {
+  Eigen::Vector2d utm = initial_utm;
+  for (int iteration = 0; iteration < kMaxNewtonIterations; ++iteration) {
+    const Eigen::Vector2d projected = utmToMercator(utm);
+    Eigen::Matrix2d jacobian;
+    jacobian.col(0) = utmToMercator(utm + Eigen::Vector2d::UnitX()) - projected;
+    jacobian.col(1) = utmToMercator(utm + Eigen::Vector2d::UnitY()) - projected;
+    const Eigen::Vector2d step = jacobian.lu().solve(projected - mercator);
+    utm -= step;
+    if (step.norm() < kNewtonTolerance) {
+      break;
+    }
+  }
+  return utm;
+}
+
+utils::CellRange WebTileExporter::getTilesInBox(
+    const Eigen::Vector2d& utm_min, const Eigen::Vector2d& utm_max,
+    int zoom) const {
+  // The edges of the box are slightly curved in Web Mercator, so the box is
+  // sampled along its edges.
+  Eigen::Vector2d mercator_min = Eigen::Vector2d::Constant(INFINITY);
+  Eigen::Vector2d mercator_max = Eigen::Vector2d::Constant(-INFINITY);
+  for (int i = 0; i <= 2; ++i) {
+    for (int j = 0; j <= 2; ++j) {
+      const Eigen::Vector2d utm =
+          utm_min + 0.5 * Eigen::Vector2d(i, j).cwiseProduct(utm_max - utm_min);
+      const Eigen::Vector2d mercator = utmToMercator(utm);
+      mercator_min = mercator_min.cwiseMin(mercator);
+      mercator_max = mercator_max.cwiseMax(mercator);
+    }
+  }
+  const double num_tiles = std::ldexp(1.0, zoom);
+  const double tiles_per_meter = num_tiles / (2.0 * M_PI * kEarthRadius);
+  const int max_tile = static_cast<int>(num_tiles) - 1;
+  const auto toTile = [&](double value) {
+    return std::min(std::max(static_cast<int>(std::floor(value)), 0),
+                    max_tile);
+  };
+  // Tile rows run from north to south.
+  const Eigen::Array2i first_tile(
+      toTile((mercator_min(0) + M_PI * kEarthRadius) * tiles_per_meter),
+      toTile((M_PI * kEarthRadius - mercator_max(1)) * tiles_per_meter));
+  const Eigen::Array2i last_tile(
+      toTile((mercator_max(0) + M_PI * kEarthRadius) * tiles_per_meter),
+      toTile((M_PI * kEarthRadius - mercator_min(1)) * tiles_per_meter));
+  return utils::CellRange(first_tile, last_tile - first_tile + 1);
+}
+
+void WebTileExporter::getBoxOfTiles(const utils::CellRange& tiles, int zoom,
+                                    const Eigen::Vector2d& initial_utm,
+                                    Eigen::Vector2d* utm_min,
+                                    Eigen::Vector2d* utm_max) const {
+  CHECK_NOTNULL(utm_min);
+  CHECK_NOTNULL(utm_max);
+  const double meters_per_tile =
+      2.0 * M_PI * kEarthRadius / std::ldexp(1.0, zoom);
+  // Tile rows run from north to south.
+  const Eigen::Vector2d mercator_min(
+      tiles.start(0) * meters_per_tile - M_PI * kEarthRadius,
+      M_PI * kEarthRadius - tiles.getEnd()(1) * meters_per_tile);
+  const Eigen::Vector2d mercator_max(
+      tiles.getEnd()(0) * meters_per_tile - M_PI * kEarthRadius,
+      M_PI * kEarthRadius - tiles.start(1) * meters_per_tile);
+  // As in getTilesInBox(), the box is sampled along its edges.
+  *utm_min = Eigen::Vector2d::Constant(INFINITY);
+  *utm_max = Eigen::Vector2d::Constant(-INFINITY);
+  Eigen::Vector2d utm = initial_utm;
+  for (int i = 0; i <= 2; ++i) {
+    for (int j = 0; j <= 2; ++j) {
+      const Eigen::Vector2d mercator =
+          mercator_min +
+          0.5 * Eigen::Vector2d(i, j).cwiseProduct(mercator_max - mercator_min);
+      utm = mercatorToUtm(mercator, utm);
+      *utm_min = utm_min->cwiseMin(utm);
+      *utm_max = utm_max->cwiseMax(utm);
+    }
+  }
+}
+
+void WebTileExporter::computePixelPositions(const Eigen::Array2i& tile,
+                                            int zoom,
+                                            const Eigen::Vector2d& initial_utm,
+                                            cv::Mat* positions) const {
+  CHECK_NOTNULL(positions);
+  const double meters_per_pixel =
+      2.0 * M_PI * kEarthRadius / std::ldexp(kTileSizePixels, zoom);
+  const Eigen::Vector2d tile_origin(
+      tile(0) * kTileSizePixels * meters_per_pixel - M_PI * kEarthRadius,
+      M_PI * kEarthRadius - tile(1) * kTileSizePixels * meters_per_pixel);
+
+  // Solve the control points at the pixel corners, reusing the previous
+  // solution as initial guess.
+  constexpr int kNumControlPoints = kTileSizePixels / kControlPointSpacing + 1;
+  Eigen::Vector2d control_points[kNumControlPoints][kNumControlPoints];
+  Eigen::Vector2d utm = initial_utm;
+  for (int row = 0; row < kNumControlPoints; ++row) {
+    for (int col = 0; col < kNumControlPoints; ++col) {
+      const Eigen::Vector2d mercator =
+          tile_origin + meters_per_pixel * kControlPointSpacing *
+                            Eigen::Vector2d(col, -row);
+      utm = mercatorToUtm(mercator, utm);
+      control_points[row][col] = utm;
+    }
+  }
+
+  positions->create(kTileSizePixels, kTileSizePixels, CV_64FC2);
+  for (int row = 0; row < kTileSizePixels; ++row) {
+    const double v = (row + 0.5) / kControlPointSpacing;
+    const int control_row = static_cast<int>(v);
+    const double a = v - control_row;
+    cv::Vec2d* position = positions->ptr<cv::Vec2d>(row);
+    for (int col = 0; col < kTileSizePixels; ++col) {
+      const double u = (col + 0.5) / kControlPointSpacing;
+      const int control_col = static_cast<int>(u);
+      const double b = u - control_col;
+      const Eigen::Vector2d utm_pixel =
+          (1.0 - a) * ((1.0 - b) * control_points[control_row][control_col] +
+                       b * control_points[control_row][control_col + 1]) +
+          a * ((1.0 - b) * control_points[control_row + 1][control_col] +
+               b * control_points[control_row + 1][control_col + 1]);
+      position[col] = cv::Vec2d(utm_pixel(0), utm_pixel(1));
+    }
+  }
+}
+
+void WebTileExporter::renderTile(const grid_map::GridMap& map,
+                                 const std::vector<std::string>& layers,
+                                 const Eigen::Array2i& tile, int zoom) const {
+  cv::Mat positions;
+  computePixelPositions(tile, zoom, map.getPosition(), &positions);
+
+  // Cell of every pixel, -1 if it is outside of the map.
+  cv::Mat cells(kTileSizePixels, kTileSizePixels, CV_32SC2);
+  for (int row = 0; row < kTileSizePixels; ++row) {
+    const cv::Vec2d* position = positions.ptr<cv::Vec2d>(row);
+    cv::Vec2i* cell = cells.ptr<cv::Vec2i>(row);
+    for (int col = 0; col < kTileSizePixels; ++col) {
+      grid_map::Index index;
+      if (map.getIndex(grid_map::Position(position[col][0], position[col][1]),
+                       index)) {
+        cell[col] = cv::Vec2i(index(0), index(1));
+      } else {
+        cell[col] = cv::Vec2i(-1, -1);
+      }
+    }
+  }
+
+  for (const std::string& layer : layers) {
+    const Encoding encoding = getEncoding(layer);
+    const grid_map::Matrix& data = map[layer];
+    TileImage image;
+    image.values = cv::Mat::zeros(kTileSizePixels, kTileSizePixels,
+                                  encoding == Encoding::kColor ? CV_32FC3
+                                                               : CV_32FC1);
+    image.weights = cv::Mat::zeros(kTileSizePixels, kTileSizePixels, CV_32FC1);
+    bool has_data = false;
+    for (int row = 0; row < kTileSizePixels; ++row) {
+      const cv::Vec2i* cell = cells.ptr<cv::Vec2i>(row);
+      float* weight = image.weights.ptr<float>(row);
+      for (int col = 0; col < kTileSizePixels; ++col) {
+        if (cell[col][0] < 0) {
+          continue;
+        }
+        const float value = data(cell[col][0], cell[col][1]);
+        if (!std::isfinite(value)) {
+          continue;
+        }
+        if (encoding == Encoding::kColor) {
+          Eigen::Vector3f rgb;
+          grid_map::colorValueToVector(value, rgb);
+          image.values.at<cv::Vec3f>(row, col) =
+              cv::Vec3f(255.0f * rgb(2), 255.0f * rgb(1), 255.0f * rgb(0));
+        } else {
+          image.values.at<float>(row, col) = value;
+        }
+        weight[col] = 1.0f;
+        has_data = true;
+      }
+    }
+    if (has_data) {
+      writeTile(layer, tile, zoom, image);
+    } else {
+      removeTile(layer, tile, zoom);
+    }
+  }
+}
+
+void WebTileExporter::downsampleTile(const std::vector<std::string>& layers,
+                                     const Eigen::Array2i& tile,
+                                     int zoom) const {
+  for (const std::string& layer : layers) {
+    const int channels = getEncoding(layer) == Encoding::kColor ? 3 : 1;
+    TileImage image;
+    image.values = cv::Mat::zeros(kTileSizePixels, kTileSizePixels,
+                                  CV_32FC(channels));
+    image.weights = cv::Mat::zeros(kTileSizePixels, kTileSizePixels, CV_32FC1);
+    bool has_data = false;
+    for (int child_row = 0; child_row < 2; ++child_row) {
+      for (int child_col = 0; child_col < 2; ++child_col) {
+        TileImage child;
+        if (!readTile(layer, 2 * tile + Eigen::Array2i(child_col, child_row),
+                      zoom + 1, &child)) {
+          continue;
+        }
+        has_data = true;
+        // Average the valid pixels of every 2 x 2 block of the child.
+        constexpr int kHalfTileSize = kTileSizePixels / 2;
+        for (int row = 0; row < kHalfTileSize; ++row) {
+          const int image_row = child_row * kHalfTileSize + row;
+          float* value = image.values.ptr<float>(image_row) +
+                         child_col * kHalfTileSize * channels;
+          float* weight =
+              image.weights.ptr<float>(image_row) + child_col * kHalfTileSize;
+          for (int col = 0; col < kHalfTileSize; ++col) {
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+            float num_valid = 0.0f;
+            for (int dy = 0; dy < 2; ++dy) {
+              const float* child_value =
+                  child.values.ptr<float>(2 * row + dy) + 2 * col * channels;
+              const float* child_weight =
+                  child.weights.ptr<float>(2 * row + dy) + 2 * col;
+              for (int dx = 0; dx < 2; ++dx) {
+                if (child_weight[dx] > 0.0f) {
+                  for (int c = 0; c < channels; ++c) {
+                    sum[c] += child_value[dx * channels + c];
+                  }
+                  num_valid += 1.0f;
+                }
+              }
+            }
+            if (num_valid > 0.0f) {
+              for (int c = 0; c < channels; ++c) {
+                value[col * channels + c] = sum[c] / num_valid;
+              }
+              weight[col] = 1.0f;
+            }
+          }
+        }
+      }
+    }
+    if (has_data) {
+      writeTile(layer, tile, zoom, image);
+    } else {
+      removeTile(layer, tile, zoom);
+    }
+  }
+}
+
+std::string WebTileExporter::getTileFilename(const std::string& layer,
+                                             const Eigen::Array2i& tile,
+                                             int zoom,
+                                             bool create_directories) const {
+  const int row = settings_.tms ? (1 << zoom) - 1 - tile(1) : tile(1);
+  const std::string directory = settings_.directory + "/" + layer + "/" +
+                                std::to_string(zoom) + "/" +
+                                std::to_string(tile(0));
+  if (create_directories) {
+    createDirectories(directory);
+  }
+  return directory + "/" + std::to_string(row) + ".png";
+}
+
+bool WebTileExporter::readTile(const std::string& layer,
+                               const Eigen::Array2i& tile, int zoom,
+                               TileImage* image) const {
+  CHECK_NOTNULL(image);
+  const cv::Mat encoded = cv::imread(getTileFilename(layer, tile, zoom, false),
+                                     cv::IMREAD_UNCHANGED);
+  if (encoded.empty()) {
+    return false;
+  }
+  CHECK_EQ(encoded.type(), CV_8UC4);
+  const Encoding encoding = getEncoding(layer);
+  image->values = cv::Mat::zeros(encoded.size(), encoding == Encoding::kColor
+                                                     ? CV_32FC3
+                                                     : CV_32FC1);
+  image->weights = cv::Mat::zeros(encoded.size(), CV_32FC1);
+  for (int row = 0; row < encoded.rows; ++row) {
+    const cv::Vec4b* pixel = encoded.ptr<cv::Vec4b>(row);
+    float* weight = image->weights.ptr<float>(row);
+    for (int col = 0; col < encoded.cols; ++col) {
+      if (pixel[col][3] == 0u) {
+        continue;
+      }
+      weight[col] = 1.0f;
+      switch (encoding) {
+        case Encoding::kGray:
+          image->values.at<float>(row, col) = pixel[col][0];
+          break;
+        case Encoding::kColor:
+          image->values.at<cv::Vec3f>(row, col) =
+              cv::Vec3f(pixel[col][0], pixel[col][1], pixel[col][2]);
+          break;
+        case Encoding::kTerrainRgb: {
+          const uint32_t code = (static_cast<uint32_t>(pixel[col][2]) << 16) |
+                                (static_cast<uint32_t>(pixel[col][1]) << 8) |
+                                static_cast<uint32_t>(pixel[col][0]);
+          image->values.at<float>(row, col) =
+              kTerrainRgbOffset + code * kTerrainRgbScale;
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void WebTileExporter::writeTile(const std::string& layer,
+                                const Eigen::Array2i& tile, int zoom,
+                                const TileImage& image) const {
+  const Encoding encoding = getEncoding(layer);
+  cv::Mat encoded = cv::Mat::zeros(image.values.size(), CV_8UC4);
+  for (int row = 0; row < encoded.rows; ++row) {
+    cv::Vec4b* pixel = encoded.ptr<cv::Vec4b>(row);
+    const float* weight = image.weights.ptr<float>(row);
+    for (int col = 0; col < encoded.cols; ++col) {
+      if (weight[col] <= 0.0f) {
+        continue;
+      }
+      switch (encoding) {
+        case Encoding::kGray: {
+          const uchar gray =
+              cv::saturate_cast<uchar>(image.values.at<float>(row, col));
+          pixel[col] = cv::Vec4b(gray, gray, gray, 255u);
+          break;
+        }
+        case Encoding::kColor: {
+          const cv::Vec3f& bgr = image.values.at<cv::Vec3f>(row, col);
+          pixel[col] = cv::Vec4b(cv::saturate_cast<uchar>(bgr[0]),
+                                 cv::saturate_cast<uchar>(bgr[1]),
+                                 cv::saturate_cast<uchar>(bgr[2]), 255u);
+          break;
+        }
+        case Encoding::kTerrainRgb: {
+          const double code = std::round(
+              (image.values.at<float>(row, col) - kTerrainRgbOffset) /
+              kTerrainRgbScale);
+          const uint32_t clamped_code = static_cast<uint32_t>(
+              std::min(std::max(code, 0.0),
+                       static_cast<double>(kTerrainRgbMaxCode)));
+          pixel[col] = cv::Vec4b(clamped_code & 0xffu,
+                                 (clamped_code >> 8) & 0xffu,
+                                 (clamped_code >> 16) & 0xffu, 255u);
+          break;
+        }
+      }
+    }
+  }
+
+  // Replace the tile atomically.
+  const std::string filename = getTileFilename(layer, tile, zoom, true);
+  const std::string temporary_filename =
+      filename.substr(0u, filename.size() - 4u) + ".tmp.png";
+  CHECK(cv::imwrite(temporary_filename, encoded))
+      << "Cannot write " << temporary_filename;
+  CHECK_EQ(std::rename(temporary_filename.c_str(), filename.c_str()), 0)
+      << "Cannot write " << filename << ": " << std::strerror(errno);
+}
+
+void WebTileExporter::removeTile(const std::string& layer,
+                                 const Eigen::Array2i& tile, int zoom) const {
+  const std::string filename = getTileFilename(layer, tile, zoom, false);
+  CHECK(std::remove(filename.c_str()) == 0 || errno == ENOENT)
+      << "Cannot remove " << filename << ": " << std::strerror(errno);
+}
+
+}  // namespace io
@@ -13,7 +13,13 @@
 #include <string>
 
 // NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-elevation-bounds.h>
+#include <aerial-mapper-grid-map/aerial-mapper-tiled-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
+#include <aerial-mapper-ortho/ortho-batch-projection.h>
+#include <aerial-mapper-utils/utils-thread-pool.h>
+#include <aerial-mapper-utils/utils-tiling.h>
 #include <aslam/cameras/camera.h>
 #include <aslam/cameras/camera-pinhole.h>
 #include <aslam/cameras/ncamera.h>
@@ -38,6 +44,12 @@ struct Settings {
   bool use_digital_elevation_map = true;
   bool colored_ortho = false;
   bool use_multi_threads = true;
+  // Number of worker threads, 0 uses all hardware threads.
+  int num_threads = 0;
+  bool pin_threads_to_cores = false;
+  // Number of images that are taken from an io::ImageStream and rendered
+  // together. Bounds the number of decoded images held in memory.
+  size_t num_images_per_batch = 16u;
 };
 
 class OrthoBackwardGrid {
@@ -47,26 +59,99 @@ class OrthoBackwardGrid {
                     const Settings& settings, grid_map::GridMap* map = nullptr);
 
   void process(const Poses& T_G_Bs, const Images& images,
-               grid_map::GridMap* map) const;
+               grid_map::GridMap* map);
+
+  /// Renders the images of the stream batch by batch. The result is the same
+  /// as rendering all images at once, but only one batch is decoded at a time.
+  void process(const Poses& T_G_Bs, io::ImageStream* images,
+               grid_map::GridMap* map);
+
+  /// Image reduction factor (1, 2, 4 or 8) whose pixels match the cells of
+  /// the map, based on the median ground sampling distance of the images at
+  /// the mean elevation of the map. Can be used for the reduction_factor of
+  /// io::ImageStreamSettings; process() accepts images at any reduction.
+  size_t computeImageReductionFactor(const Poses& T_G_Bs,
+                                     const grid_map::GridMap& map) const;
+
+  /// Renders a map that does not fit into memory tile by tile.
+  void process(const Poses& T_G_Bs, const Images& images,
+               grid_map::TiledGridMap* tiled_map);
+
+  /// Elevation bounds of the map, kept up to date by the caller. The images
+  /// are then culled with the elevation range around their footprint instead
+  /// of scanning the whole elevation layer in every call to process(). Only
+  /// used for maps of the geometry of the bounds. nullptr detaches them.
+  inline void setElevationBounds(
+      const grid_map::ElevationBounds* elevation_bounds) {
+    elevation_bounds_ = elevation_bounds;
+  }
+
+  /// Cells that are covered by the footprint of at least one image of the
+  /// last call to process(). Only these cells were re-rendered.
+  inline const utils::CellRange& getLastUpdatedCells() const {
+    return last_updated_cells_;
+  }
 
  private:
+  void computeCameraPoses(const Poses& T_G_Bs, Poses* T_G_Cs,
+                          Poses* T_C_Gs) const;
 
-  void updateOrthomosaicLayer(const Poses& T_G_Cs, const Images& images,
-                              grid_map::GridMap* map) const;
+  void updateMap(const Poses& T_G_Cs, const Poses& T_C_Gs,
+                 const Images& images, grid_map::GridMap* map);
+
+  /// Layer the orthomosaic is written to in the current mode.
+  inline const char* getOrthoLayer() const {
+    return settings_.colored_ortho ? "colored_ortho" : "ortho";
+  }
+
+  void updateOrthomosaicLayer(const Poses& T_G_Cs, const Poses& T_C_Gs,
+                              const Images& images, grid_map::GridMap* map);
 
   void updateOrthomosaicLayerMultiThreaded(const Poses& T_G_Cs,
+                                           const Poses& T_C_Gs,
                                            const Images& images,
-                                           grid_map::GridMap* map) const;
+                                           grid_map::GridMap* map);
+
+  /// Projects all cells of the tile into the candidate images (one batch per
+  /// image) and keeps the observation with the largest elevation angle.
+  void updateTile(const utils::CellRange& tile,
+                  const std::vector<size_t>& candidate_images,
+                  const Poses& T_C_Gs, const Images& images,
+                  grid_map::GridMap* map) const;
+
+  /// Lists for every tile the images whose footprint overlaps with the tile.
+  /// Cells only need to be tested against the candidates of their tile.
+  /// The union of all footprints is returned in dirty_cells.
+  void computeCandidateImages(
+      const Poses& T_G_Cs, const grid_map::GridMap& map,
+      const utils::CellTiling& tiling,
+      std::vector<std::vector<size_t> >* candidate_images_per_tile,
+      utils::CellRange* dirty_cells) const;
+
+  /// Computes the cells that can potentially be observed by the camera, i.e.
+  /// the bounding box of the camera frustum between the minimum and maximum
+  /// elevation. Returns false if the footprint does not overlap with the map.
+  bool computeImageFootprint(const Pose& T_G_C, const grid_map::GridMap& map,
+                             double min_elevation, double max_elevation,
+                             utils::CellRange* footprint) const;
 
   void printParams() const;
 
   std::shared_ptr<aslam::NCamera> ncameras_;
   static constexpr size_t kFrameIdx = 0u;
+  // Cells are culled and handed out to the workers in square tiles.
+  static constexpr int kTileSizeCells = 32;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+  std::unique_ptr<BatchProjection> projection_;
+  static constexpr int kNumFootprintSamplesPerEdge = 8;
+  static constexpr int kFootprintPaddingCells = 2;
+  static constexpr size_t kMaxImageReductionFactor = 8u;
   Settings settings_;
-
-  // Multi-threading.
-  std::unordered_map<size_t, grid_map::Index> map_sample_to_cell_index_;
-  std::vector<size_t> samples_idx_range_;
+  utils::CellRange last_updated_cells_;
+  const grid_map::ElevationBounds* elevation_bounds_;
+  // Index of the first passed image in the whole sequence, which is stored in
+  // the observation_index layer.
+  size_t first_image_index_;
 };
 }  // namespace ortho
 
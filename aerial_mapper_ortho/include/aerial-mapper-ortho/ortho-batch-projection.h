@@ -0,0 +1,56 @@
+/*
+ *    Filename: ortho-batch-projection.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef ORTHO_BATCH_PROJECTION_H_
+#define ORTHO_BATCH_PROJECTION_H_
+
+// NON-SYSTEM
+#include <aslam/cameras/camera.h>
+#include <Eigen/Dense>
+
+namespace ortho {
+
+/// Projects a batch of points (e.g. all cell centers of a tile) into a
+/// camera. For pinhole cameras without distortion, with radial-tangential or
+/// with equidistant distortion, the intrinsics are extracted once and the
+/// projection is evaluated with Eigen array expressions over the whole batch.
+/// Other camera models fall back to aslam::Camera::project3 per point.
+class BatchProjection {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  typedef Eigen::Array<bool, 1, Eigen::Dynamic> VisibilityMask;
+
+  /// The camera must outlive this object.
+  explicit BatchProjection(const aslam::Camera& camera);
+
+  /// Transforms the points G_points into the camera frame (C_points) and
+  /// projects them (keypoints). A point is visible if it is in front of the
+  /// camera and its keypoint lies inside the image.
+  void project(const Eigen::Matrix3Xd& G_points, const Eigen::Matrix3d& R_C_G,
+               const Eigen::Vector3d& t_C_G, Eigen::Matrix3Xd* C_points,
+               Eigen::Matrix2Xd* keypoints, VisibilityMask* visible) const;
+
+  inline bool isVectorized() const { return distortion_model_ != kGeneric; }
+
+ private:
+  enum DistortionModel { kNoDistortion, kRadTan, kEquidistant, kGeneric };
+
+  void projectGeneric(const Eigen::Matrix3Xd& C_points,
+                      Eigen::Matrix2Xd* keypoints,
+                      VisibilityMask* visible) const;
+
+  const aslam::Camera& camera_;
+  DistortionModel distortion_model_;
+  double fu_, fv_, cu_, cv_;
+  // radtan: k1, k2, p1, p2, equidistant: k1, k2, k3, k4.
+  Eigen::Vector4d distortion_coefficients_;
+  double image_width_, image_height_;
+};
+
+}  // namespace ortho
+
+#endif  // ORTHO_BATCH_PROJECTION_H_
@@ -12,6 +12,7 @@
 #include <memory>
 
 // NON-SYSTEM
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
 #include <aerial-mapper-io/aerial-mapper-io.h>
 #include <aslam/cameras/ncamera.h>
 #include <aslam/pipeline/undistorter.h>
@@ -51,6 +52,15 @@ class OrthoForwardHomography {
                          const Image& image);
   void batch(const Poses& T_G_Bs, const Images& images);
 
+  /// Same as above, the images are warped one by one as they are decoded.
+  void batch(const Poses& T_G_Bs, io::ImageStream* images);
+
+  /// Warps the image onto the ground plane and feeds it to the blender.
+  void addToBatch(const Pose& T_G_B, const Image& image);
+
+  /// Blends all images added since the construction and writes the mosaic.
+  void finishBatch();
+
  private:
   void addImage(cv::Mat image_warped, cv::Mat mask_image);
   void addImage(cv::Mat image_warped);
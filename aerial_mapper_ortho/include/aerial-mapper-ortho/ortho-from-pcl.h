@@ -14,7 +14,9 @@
 #include <string>
 
 // NON-SYSTEM
+#include <aerial-mapper-utils/utils-downsampling.h>
 #include <aerial-mapper-utils/utils-nearest-neighbor.h>
+#include <aerial-mapper-utils/utils-thread-pool.h>
 #include <aslam/cameras/ncamera.h>
 #include <Eigen/Dense>
 #include <grid_map_core/GridMap.hpp>
@@ -32,6 +34,14 @@ struct Settings {
   bool use_adaptive_interpolation = false;
   bool save_orthomosaic_jpg = false;
   std::string orthomosaic_jpg_filename = "";
+  bool use_multi_threads = true;
+  // Number of worker threads, 0 uses all hardware threads.
+  int num_threads = 0;
+  // The points are reduced to one per bin of this fraction of the map
+  // resolution before the kd-tree is built, see
+  // utils::downsamplePointCloud(). A non-positive value keeps all points.
+  double downsampling_bin_size_ratio = 0.0;
+  utils::BinStatistic downsampling_statistic = utils::BinStatistic::Mean;
 };
 
 class OrthoFromPcl {
@@ -40,15 +50,34 @@ class OrthoFromPcl {
 
   OrthoFromPcl(const Settings& settings);
 
+  /// Downsamples the points (and intensities) if enabled in the settings.
   void process(const AlignedType<std::vector,
                Eigen::Vector3d>::type& pointcloud,
                const std::vector<int>& intensities,
                grid_map::GridMap* map) const;
 
+  /// Same for single precision points relative to origin, e.g. of a
+  /// memory-mapped io::BinaryPointCloud. The points are not copied, unless
+  /// downsampling copies them into a double precision point cloud.
+  void process(const PointCloudSoAView<float>& points,
+               const Eigen::Vector3d& origin, const int* intensities,
+               grid_map::GridMap* map) const;
+
  private:
+  /// Interpolates the intensities of the points in the kd-tree adaptor. The
+  /// points are relative to cloud_origin.
+  template <typename PC2KD>
+  void processWithAdaptor(const PC2KD& pc2kd,
+                          const Eigen::Vector2d& cloud_origin,
+                          const int* intensities,
+                          grid_map::GridMap* map) const;
+
   void printParams() const;
   Settings settings_;
-  PointCloud<double> cloud_kdtree_;
+
+  // Multi-threading: cells are handed out to the workers in square tiles.
+  static constexpr int kTileSizeCells = 64;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
 };
 }  // namespace ortho
 #endif  // ORTHO_FROM_PCL_H_
@@ -9,11 +9,14 @@
 #include "aerial-mapper-ortho/ortho-backward-grid.h"
 
 // SYSTEM
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <math.h>
 
 // NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
 #include <aerial-mapper-utils/utils-common.h>
 #include <aslam/pipeline/undistorter.h>
 #include <aslam/pipeline/undistorter-mapped.h>
@@ -23,102 +26,44 @@ namespace ortho {
 OrthoBackwardGrid::OrthoBackwardGrid(
     const std::shared_ptr<aslam::NCamera> ncameras, const Settings& settings,
     grid_map::GridMap* map)
-    : ncameras_(ncameras), settings_(settings) {
+    : ncameras_(ncameras),
+      settings_(settings),
+      elevation_bounds_(nullptr),
+      first_image_index_(0u) {
   CHECK(ncameras_);
   printParams();
-
   if (settings_.use_multi_threads) {
-    // Create one sample for every cell.
-    samples_idx_range_.clear();
-    size_t sample_counter = 0u;
-    for (grid_map::GridMapIterator it(*map); !it.isPastEnd(); ++it) {
-      samples_idx_range_.push_back(sample_counter);
-      map_sample_to_cell_index_.insert(std::make_pair(sample_counter, *it));
-      ++sample_counter;
-    }
+    utils::ThreadPoolSettings thread_pool_settings;
+    thread_pool_settings.num_threads = std::max(settings_.num_threads, 0);
+    thread_pool_settings.pin_threads_to_cores = settings_.pin_threads_to_cores;
+    thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
   }
+  projection_.reset(new BatchProjection(ncameras_->getCamera(kFrameIdx)));
+  LOG_IF(WARNING, !projection_->isVectorized())
+      << "Falling back to per-cell projection.";
 }
 
 void OrthoBackwardGrid::updateOrthomosaicLayer(const Poses& T_G_Cs,
+                                               const Poses& T_C_Gs,
                                                const Images& images,
-                                               grid_map::GridMap* map) const {
-  CHECK(ncameras_);
-  const aslam::Camera& camera = ncameras_->getCamera(kFrameIdx);
-
-  grid_map::Matrix& layer_ortho = (*map)["ortho"];
-  grid_map::Matrix& layer_num_observations = (*map)["num_observations"];
-  grid_map::Matrix& layer_elevation_angle = (*map)["elevation_angle"];
-  const grid_map::Matrix& layer_elevation = (*map)["elevation"];
-  grid_map::Matrix& layer_observation_index = (*map)["observation_index"];
-  grid_map::Matrix& layer_colored_ortho = (*map)["colored_ortho"];
-
+                                               grid_map::GridMap* map) {
+  CHECK(map);
   ros::Time time1 = ros::Time::now();
-  for (grid_map::GridMapIterator it(*map); !it.isPastEnd(); ++it) {
-    grid_map::Position position;
-    map->getPosition(*it, position);
-    const grid_map::Index index(*it);
-    double x = index(0);
-    double y = index(1);
-    Eigen::Vector3d landmark_UTM =
-        Eigen::Vector3d(position.x(), position.y(), layer_elevation(x, y));
-
-    // Loop over all images.
-    for (size_t i = 0u; i < images.size(); ++i) {
-      const Eigen::Vector3d& C_landmark =
-          T_G_Cs[i].inverse().transform(landmark_UTM);
-      Eigen::Vector2d keypoint;
-      const aslam::ProjectionResult& projection_result =
-          camera.project3(C_landmark, &keypoint);
-
-      // Check if keypoint visible.
-      const bool keypoint_visible =
-          (keypoint(0) >= 0.0) && (keypoint(1) >= 0.0) &&
-          (keypoint(0) < static_cast<double>(camera.imageWidth())) &&
-          (keypoint(1) < static_cast<double>(camera.imageHeight())) &&
-          (projection_result.getDetailedStatus() !=
-           aslam::ProjectionResult::POINT_BEHIND_CAMERA) &&
-          (projection_result.getDetailedStatus() !=
-           aslam::ProjectionResult::PROJECTION_INVALID);
-      if (keypoint_visible) {
-        Eigen::Vector3d u = C_landmark;
-        // Observation vector.
-        double norm_u = sqrt(u(0) * u(0) + u(1) * u(1) + u(2) * u(2));
-        // Angle (observation_in_camera, cell_center).
-        double alpha = asin(std::fabs(u(2)) / norm_u);
-        CHECK(alpha > 0.0);
-
-        if (std::fabs(alpha) > layer_elevation_angle(x, y)) {
-          layer_elevation_angle(x, y) = std::fabs(alpha);
-          layer_observation_index(x, y) = i;
-          layer_num_observations(x, y) += layer_num_observations(x, y);
-
-          // Retrieve pixel intensity.
-          const Eigen::Vector3d& C_landmark =
-              T_G_Cs[i].inverse().transform(landmark_UTM);
-          Eigen::Vector2d keypoint;
-          camera.project3(C_landmark, &keypoint);
-          const int kp_y = std::min(static_cast<int>(std::round(keypoint(1))),
-                                    static_cast<int>(camera.imageHeight()) - 1);
-          const int kp_x = std::min(static_cast<int>(std::round(keypoint(0))),
-                                    static_cast<int>(camera.imageWidth()) - 1);
-          if (settings_.colored_ortho) {
-            const cv::Vec3b rgb = images[i].at<cv::Vec3b>(kp_y, kp_x);
-            const Eigen::Vector3f color_vector_bgr(
-                static_cast<float>(rgb[2]) / 255.0,
-                static_cast<float>(rgb[1]) / 255.0,
-                static_cast<float>(rgb[0]) / 255.0);
-            float color_concatenated;
-            grid_map::colorVectorToValue(color_vector_bgr, color_concatenated);
-            layer_colored_ortho(x, y) = color_concatenated;
-          } else {
-            const double gray_value = images[i].at<uchar>(kp_y, kp_x);
-            // Update orthomosaic.
-            layer_ortho(x, y) = gray_value;
-          }
-        }  // if better observation angle
-      }    // if visible
-    }      // loop images
-  }        // loop cells
+  const utils::CellTiling tiling(map->getSize(), kTileSizeCells);
+  std::vector<std::vector<size_t> > candidate_images_per_tile;
+  computeCandidateImages(T_G_Cs, *map, tiling, &candidate_images_per_tile,
+                         &last_updated_cells_);
+
+  const utils::CellRange tiles =
+      tiling.getTilesCovering(last_updated_cells_);
+  for (int tile_y = tiles.start(1); tile_y < tiles.getEnd()(1); ++tile_y) {
+    for (int tile_x = tiles.start(0); tile_x < tiles.getEnd()(0); ++tile_x) {
+      const size_t tile_index =
+          tiling.getTileIndex(Eigen::Array2i(tile_x, tile_y));
+      updateTile(tiling.getTileCells(tile_index).intersect(last_updated_cells_),
+                 candidate_images_per_tile[tile_index], T_C_Gs, images, map);
+    }
+  }
 
   const ros::Time time2 = ros::Time::now();
   const ros::Duration& delta_time = time2 - time1;
@@ -126,116 +71,429 @@ void OrthoBackwardGrid::updateOrthomosaicLayer(const Poses& T_G_Cs,
 }
 
 void OrthoBackwardGrid::updateOrthomosaicLayerMultiThreaded(
-    const Poses& T_G_Cs, const Images& images, grid_map::GridMap* map) const {
-  CHECK(ncameras_);
-  const aslam::Camera& camera = ncameras_->getCamera(kFrameIdx);
+    const Poses& T_G_Cs, const Poses& T_C_Gs, const Images& images,
+    grid_map::GridMap* map) {
+  CHECK(map);
+  ros::Time time1 = ros::Time::now();
+  const utils::CellTiling tiling(map->getSize(), kTileSizeCells);
+  std::vector<std::vector<size_t> > candidate_images_per_tile;
+  computeCandidateImages(T_G_Cs, *map, tiling, &candidate_images_per_tile,
+                         &last_updated_cells_);
+
+  auto generateTileWiseOrthomosaic = [&](size_t tile_index,
+                                         const utils::CellRange& tile) {
+    updateTile(tile, candidate_images_per_tile[tile_index], T_C_Gs, images,
+               map);
+  };
+  utils::parForTiles(tiling, last_updated_cells_, generateTileWiseOrthomosaic,
+                     thread_pool_.get());
+
+  const ros::Time time2 = ros::Time::now();
+  const ros::Duration& delta_time = time2 - time1;
+  VLOG(1) << "dt(backward_grid, multi-threads): " << delta_time;
+}
 
-  grid_map::Matrix& layer_ortho = (*map)["ortho"];
+void OrthoBackwardGrid::updateTile(
+    const utils::CellRange& tile, const std::vector<size_t>& candidate_images,
+    const Poses& T_C_Gs, const Images& images, grid_map::GridMap* map) const {
+  CHECK(map);
+  if (candidate_images.empty() || tile.isEmpty()) {
+    return;
+  }
+  // The layers are created in updateMap().
+  grid_map::Matrix& layer_ortho = (*map)[getOrthoLayer()];
   grid_map::Matrix& layer_num_observations = (*map)["num_observations"];
   grid_map::Matrix& layer_elevation_angle = (*map)["elevation_angle"];
   const grid_map::Matrix& layer_elevation = (*map)["elevation"];
   grid_map::Matrix& layer_observation_index = (*map)["observation_index"];
-  grid_map::Matrix& layer_colored_ortho = (*map)["colored_ortho"];
+  const double camera_width =
+      static_cast<double>(ncameras_->getCamera(kFrameIdx).imageWidth());
 
-  ros::Time time1 = ros::Time::now();
+  // Cell centers of the tile, in the order of the inner loops below.
+  const grid_map::Index tile_end = tile.getEnd();
+  Eigen::Matrix3Xd G_cells(3, tile.getNumCells());
+  int k = 0;
+  for (int y = tile.start(1); y < tile_end(1); ++y) {
+    for (int x = tile.start(0); x < tile_end(0); ++x, ++k) {
+      grid_map::Position position;
+      map->getPosition(grid_map::Index(x, y), position);
+      G_cells.col(k) << position.x(), position.y(), layer_elevation(x, y);
+    }
+  }
 
-  auto generateCellWiseOrthomosaic =
-      [&](const std::vector<size_t>& sample_idx_range_) {
-    for (size_t sample_idx : sample_idx_range_) {
-      grid_map::Index index = map_sample_to_cell_index_.at(sample_idx);
-      double x = index(0);
-      double y = index(1);
+  // Project all cells at once into every image that can observe the tile.
+  // The images are visited in the same order for every cell as before.
+  Eigen::Matrix3Xd C_cells;
+  Eigen::Matrix2Xd keypoints;
+  BatchProjection::VisibilityMask visible;
+  Eigen::Array<double, 1, Eigen::Dynamic> elevation_angles;
+  for (const size_t i : candidate_images) {
+    const cv::Mat& image = images[i];
+    if (image.empty()) {
+      continue;
+    }
+    projection_->project(G_cells, T_C_Gs[i].getRotationMatrix(),
+                         T_C_Gs[i].getPosition(), &C_cells, &keypoints,
+                         &visible);
+    if (!visible.any()) {
+      continue;
+    }
+    // Angle (observation_in_camera, cell_center).
+    elevation_angles = (C_cells.row(2).array().abs() /
+                        C_cells.colwise().norm().array()).asin();
+    // The image may be decoded at a reduced resolution, see
+    // computeImageReductionFactor().
+    const double image_scale = static_cast<double>(image.cols) / camera_width;
+    const int max_kp_x = image.cols - 1;
+    const int max_kp_y = image.rows - 1;
 
-      grid_map::Position position;
-      map->getPosition(index, position);
-
-      Eigen::Vector3d landmark_UTM =
-          Eigen::Vector3d(position.x(), position.y(), layer_elevation(x, y));
-
-      // Loop over all images.
-      for (size_t i = 0u; i < images.size(); ++i) {
-        const Eigen::Vector3d& C_landmark =
-            T_G_Cs[i].inverse().transform(landmark_UTM);
-        Eigen::Vector2d keypoint;
-        const aslam::ProjectionResult& projection_result =
-            camera.project3(C_landmark, &keypoint);
-
-        // Check if keypoint visible.
-        const bool keypoint_visible =
-            (keypoint(0) >= 0.0) && (keypoint(1) >= 0.0) &&
-            (keypoint(0) < static_cast<double>(camera.imageWidth())) &&
-            (keypoint(1) < static_cast<double>(camera.imageHeight())) &&
-            (projection_result.getDetailedStatus() !=
-             aslam::ProjectionResult::POINT_BEHIND_CAMERA) &&
-            (projection_result.getDetailedStatus() !=
-             aslam::ProjectionResult::PROJECTION_INVALID);
-        if (keypoint_visible) {
-          const Eigen::Vector3d& u = C_landmark;
-          // Observation vector.
-          double norm_u = sqrt(u(0) * u(0) + u(1) * u(1) + u(2) * u(2));
-          // Angle (observation_in_camera, cell_center).
-          double alpha = asin(std::fabs(u(2)) / norm_u);
-          CHECK(alpha > 0.0);
-
-          if (std::fabs(alpha) > layer_elevation_angle(x, y)) {
-            layer_elevation_angle(x, y) = std::fabs(alpha);
-            layer_observation_index(x, y) = i;
-            layer_num_observations(x, y) += layer_num_observations(x, y);
-
-            // Retrieve pixel intensity.
-            const Eigen::Vector3d& C_landmark =
-                T_G_Cs[i].inverse().transform(landmark_UTM);
-            Eigen::Vector2d keypoint;
-            camera.project3(C_landmark, &keypoint);
-            const int kp_y = std::min(static_cast<int>(std::round(keypoint(1))),
-                                      static_cast<int>(camera.imageHeight()) - 1);
-            const int kp_x = std::min(static_cast<int>(std::round(keypoint(0))),
-                                      static_cast<int>(camera.imageWidth()) - 1);
-            if (settings_.colored_ortho) {
-              const cv::Vec3b rgb = images[i].at<cv::Vec3b>(kp_y, kp_x);
-              const Eigen::Vector3f color_vector_bgr(
-                  static_cast<float>(rgb[2]) / 255.0,
-                  static_cast<float>(rgb[1]) / 255.0,
-                  static_cast<float>(rgb[0]) / 255.0);
-              float color_concatenated;
-              grid_map::colorVectorToValue(color_vector_bgr, color_concatenated);
-              layer_colored_ortho(x, y) = color_concatenated;
-            } else {
-              const double gray_value = images[i].at<uchar>(kp_y, kp_x);
-              // Update orthomosaic.
-              layer_ortho(x, y) = gray_value;
-            }
-          }  // if better observation angle
-        }    // if visible
-      }      // loop images
-    }        // loop samples
-  };         // lambda function
-
-  const size_t num_samples = samples_idx_range_.size();
-  const size_t num_threads = std::thread::hardware_concurrency();
-  utils::parFor(num_samples, generateCellWiseOrthomosaic, num_threads);
+    k = 0;
+    for (int y = tile.start(1); y < tile_end(1); ++y) {
+      for (int x = tile.start(0); x < tile_end(0); ++x, ++k) {
+        if (!visible(k) ||
+            !(elevation_angles(k) > layer_elevation_angle(x, y))) {
+          continue;
+        }
+        layer_elevation_angle(x, y) = elevation_angles(k);
+        layer_observation_index(x, y) = first_image_index_ + i;
+        layer_num_observations(x, y) += layer_num_observations(x, y);
 
-  const ros::Time time2 = ros::Time::now();
-  const ros::Duration& delta_time = time2 - time1;
-  VLOG(1) << "dt(backward_grid, multi-threads): " << delta_time;
+        // Retrieve pixel intensity.
+        const int kp_y = std::min(
+            static_cast<int>(
+                std::round((keypoints(1, k) + 0.5) * image_scale - 0.5)),
+            max_kp_y);
+        const int kp_x = std::min(
+            static_cast<int>(
+                std::round((keypoints(0, k) + 0.5) * image_scale - 0.5)),
+            max_kp_x);
+        if (settings_.colored_ortho) {
+          const cv::Vec3b rgb = image.at<cv::Vec3b>(kp_y, kp_x);
+          const Eigen::Vector3f color_vector_bgr(
+              static_cast<float>(rgb[2]) / 255.0,
+              static_cast<float>(rgb[1]) / 255.0,
+              static_cast<float>(rgb[0]) / 255.0);
+          float color_concatenated;
+          grid_map::colorVectorToValue(color_vector_bgr, color_concatenated);
+          layer_ortho(x, y) = color_concatenated;
+        } else {
+          const double gray_value = image.at<uchar>(kp_y, kp_x);
+          // Update orthomosaic.
+          layer_ortho(x, y) = gray_value;
+        }
+      }  // loop x
+    }    // loop y
+  }      // loop images
+}
+
+void OrthoBackwardGrid::computeCandidateImages(
+    const Poses& T_G_Cs, const grid_map::GridMap& map,
+    const utils::CellTiling& tiling,
+    std::vector<std::vector<size_t> >* candidate_images_per_tile,
+    utils::CellRange* dirty_cells) const {
+  CHECK_NOTNULL(candidate_images_per_tile);
+  CHECK_NOTNULL(dirty_cells);
+  candidate_images_per_tile->clear();
+  candidate_images_per_tile->resize(tiling.getNumTiles());
+  *dirty_cells = utils::CellRange();
+
+  // The frustum is clipped against the elevation range of the map. Cells
+  // without a finite elevation cannot be projected into any image.
+  const bool use_elevation_bounds =
+      elevation_bounds_ != nullptr && elevation_bounds_->hasGeometryOf(map);
+  double min_elevation = std::numeric_limits<double>::max();
+  double max_elevation = std::numeric_limits<double>::lowest();
+  if (use_elevation_bounds) {
+    // May be wider than the range of the map, which is refined per image.
+    elevation_bounds_->getElevationRange(&min_elevation, &max_elevation);
+  } else {
+    const grid_map::Matrix& layer_elevation = map["elevation"];
+    const float* elevation_ptr = layer_elevation.data();
+    for (Eigen::Index k = 0; k < layer_elevation.size(); ++k) {
+      if (std::isfinite(elevation_ptr[k])) {
+        min_elevation = std::min<double>(min_elevation, elevation_ptr[k]);
+        max_elevation = std::max<double>(max_elevation, elevation_ptr[k]);
+      }
+    }
+  }
+  if (min_elevation > max_elevation) {
+    LOG(WARNING) << "Elevation layer contains no finite values.";
+    return;
+  }
+
+  size_t num_candidates = 0u;
+  for (size_t i = 0u; i < T_G_Cs.size(); ++i) {
+    utils::CellRange footprint;
+    if (!computeImageFootprint(T_G_Cs[i], map, min_elevation, max_elevation,
+                               &footprint)) {
+      continue;
+    }
+    // Every cell the camera can see lies within the footprint, so the
+    // footprint at the elevation range of its cells still contains them.
+    double min_footprint_elevation, max_footprint_elevation;
+    if (use_elevation_bounds &&
+        (!elevation_bounds_->getElevationRange(footprint,
+                                               &min_footprint_elevation,
+                                               &max_footprint_elevation) ||
+         !computeImageFootprint(T_G_Cs[i], map, min_footprint_elevation,
+                                max_footprint_elevation, &footprint))) {
+      continue;
+    }
+    dirty_cells->extend(footprint);
+    const utils::CellRange tiles = tiling.getTilesCovering(footprint);
+    for (int tile_y = tiles.start(1); tile_y < tiles.getEnd()(1); ++tile_y) {
+      for (int tile_x = tiles.start(0); tile_x < tiles.getEnd()(0); ++tile_x) {
+        (*candidate_images_per_tile)[tiling.getTileIndex(
+                                         Eigen::Array2i(tile_x, tile_y))]
+            .push_back(i);
+        ++num_candidates;
+      }
+    }
+  }
+  VLOG(1) << "Avg. candidate images per tile: "
+          << static_cast<double>(num_candidates) /
+                 static_cast<double>(tiling.getNumTiles());
+}
+
+bool OrthoBackwardGrid::computeImageFootprint(
+    const Pose& T_G_C, const grid_map::GridMap& map, double min_elevation,
+    double max_elevation, utils::CellRange* footprint) const {
+  CHECK_NOTNULL(footprint);
+  const utils::CellRange all_cells(Eigen::Array2i::Zero(), map.getSize());
+  const aslam::Camera& camera = ncameras_->getCamera(kFrameIdx);
+  const double max_u = static_cast<double>(camera.imageWidth() - 1u);
+  const double max_v = static_cast<double>(camera.imageHeight() - 1u);
+  const Eigen::Matrix3d R_G_C = T_G_C.getRotationMatrix();
+  const Eigen::Vector3d& t_G_C = T_G_C.getPosition();
+
+  // Intersect the rays through the image border with the lowest and the
+  // highest terrain plane. For a pinhole camera the bounding box of these
+  // intersections contains every cell the camera can see.
+  Eigen::Vector2d min_xy =
+      Eigen::Vector2d::Constant(std::numeric_limits<double>::max());
+  Eigen::Vector2d max_xy =
+      Eigen::Vector2d::Constant(std::numeric_limits<double>::lowest());
+  bool bounded = true;
+  auto addBorderPixel = [&](const Eigen::Vector2d& keypoint) {
+    Eigen::Vector3d C_ray;
+    if (!camera.backProject3(keypoint, &C_ray)) {
+      bounded = false;
+      return;
+    }
+    const Eigen::Vector3d G_ray = R_G_C * C_ray;
+    for (const double elevation : {min_elevation, max_elevation}) {
+      const double scale = (elevation - t_G_C(2)) / G_ray(2);
+      if (!std::isfinite(scale) || scale <= 0.0) {
+        // Ray does not hit the plane (e.g. above the horizon).
+        bounded = false;
+        return;
+      }
+      const Eigen::Vector2d G_xy = (t_G_C + scale * G_ray).head<2>();
+      min_xy = min_xy.cwiseMin(G_xy);
+      max_xy = max_xy.cwiseMax(G_xy);
+    }
+  };
+  for (int k = 0; k <= kNumFootprintSamplesPerEdge && bounded; ++k) {
+    const double s = static_cast<double>(k) / kNumFootprintSamplesPerEdge;
+    addBorderPixel(Eigen::Vector2d(s * max_u, 0.0));
+    addBorderPixel(Eigen::Vector2d(s * max_u, max_v));
+    addBorderPixel(Eigen::Vector2d(0.0, s * max_v));
+    addBorderPixel(Eigen::Vector2d(max_u, s * max_v));
+  }
+  if (!bounded) {
+    // Fall back to testing every cell.
+    *footprint = all_cells;
+    return true;
+  }
+
+  // Pad the bounding box to account for lens distortion between the samples.
+  const double resolution = map.getResolution();
+  const Eigen::Vector2d padding =
+      Eigen::Vector2d::Constant(kFootprintPaddingCells * resolution);
+  min_xy -= padding;
+  max_xy += padding;
+  const Eigen::Vector2d half_length = 0.5 * map.getLength().matrix();
+  const Eigen::Vector2d map_min = map.getPosition() - half_length;
+  const Eigen::Vector2d map_max = map.getPosition() + half_length;
+  if ((max_xy.array() < map_min.array()).any() ||
+      (min_xy.array() > map_max.array()).any()) {
+    return false;
+  }
+
+  // Clamp to cell centers inside the map before converting to indices.
+  const Eigen::Vector2d margin = Eigen::Vector2d::Constant(0.5 * resolution);
+  min_xy = min_xy.cwiseMax(map_min + margin).cwiseMin(map_max - margin);
+  max_xy = max_xy.cwiseMax(map_min + margin).cwiseMin(map_max - margin);
+  grid_map::Index index_min_xy, index_max_xy;
+  CHECK(map.getIndex(grid_map::Position(min_xy), index_min_xy));
+  CHECK(map.getIndex(grid_map::Position(max_xy), index_max_xy));
+  const grid_map::Index start = index_min_xy.min(index_max_xy);
+  *footprint = utils::CellRange(
+                   start, index_min_xy.max(index_max_xy) - start + 1)
+                   .intersect(all_cells);
+  return !footprint->isEmpty();
 }
 
 void OrthoBackwardGrid::process(const Poses& T_G_Bs, const Images& images,
-                                grid_map::GridMap* map) const {
+                                grid_map::GridMap* map) {
   CHECK(!T_G_Bs.empty());
   CHECK(T_G_Bs.size() == images.size());
   CHECK(map);
   LOG(INFO) << "Num. images = " << images.size();
 
-  Poses T_G_Cs;
+  Poses T_G_Cs, T_C_Gs;
+  computeCameraPoses(T_G_Bs, &T_G_Cs, &T_C_Gs);
+  updateMap(T_G_Cs, T_C_Gs, images, map);
+}
+
+void OrthoBackwardGrid::process(const Poses& T_G_Bs, io::ImageStream* images,
+                                grid_map::GridMap* map) {
+  CHECK_NOTNULL(images);
+  CHECK(!T_G_Bs.empty());
+  CHECK(T_G_Bs.size() == images->size());
+  CHECK(map);
+  CHECK_GT(settings_.num_images_per_batch, 0u);
+  LOG(INFO) << "Num. images = " << images->size();
+
+  Poses T_G_Cs, T_C_Gs;
+  computeCameraPoses(T_G_Bs, &T_G_Cs, &T_C_Gs);
+  // Every cell keeps the observation with the largest elevation angle, so the
+  // batches can be rendered one after the other.
+  utils::CellRange updated_cells;
+  Images batch_images;
+  while (images->hasNext()) {
+    const size_t first = images->getNextIndex();
+    batch_images.clear();
+    cv::Mat image;
+    while (batch_images.size() < settings_.num_images_per_batch &&
+           images->next(&image)) {
+      batch_images.push_back(image);
+    }
+    const size_t last = first + batch_images.size();
+    first_image_index_ = first;
+    updateMap(Poses(T_G_Cs.begin() + first, T_G_Cs.begin() + last),
+              Poses(T_C_Gs.begin() + first, T_C_Gs.begin() + last),
+              batch_images, map);
+    updated_cells.extend(last_updated_cells_);
+  }
+  first_image_index_ = 0u;
+  last_updated_cells_ = updated_cells;
+}
+
+void OrthoBackwardGrid::process(const Poses& T_G_Bs, const Images& images,
+                                grid_map::TiledGridMap* tiled_map) {
+  CHECK(!T_G_Bs.empty());
+  CHECK(T_G_Bs.size() == images.size());
+  CHECK(tiled_map);
+  LOG(INFO) << "Num. images = " << images.size();
+
+  Poses T_G_Cs, T_C_Gs;
+  computeCameraPoses(T_G_Bs, &T_G_Cs, &T_C_Gs);
+  tiled_map->forEachTile(
+      [&](size_t /*tile_index*/, grid_map::GridMap* tile) {
+        updateMap(T_G_Cs, T_C_Gs, images, tile);
+      });
+  // The updated cells refer to a single tile.
+  last_updated_cells_ = utils::CellRange();
+}
+
+size_t OrthoBackwardGrid::computeImageReductionFactor(
+    const Poses& T_G_Bs, const grid_map::GridMap& map) const {
+  // Ground plane at the mean elevation of the map.
+  double elevation = settings_.orthomosaic_elevation_m;
+  if (map.exists("elevation")) {
+    const grid_map::Matrix& layer_elevation = map["elevation"];
+    double sum = 0.0;
+    size_t num_finite = 0u;
+    for (Eigen::Index k = 0; k < layer_elevation.size(); ++k) {
+      if (std::isfinite(layer_elevation.data()[k])) {
+        sum += layer_elevation.data()[k];
+        ++num_finite;
+      }
+    }
+    if (num_finite > 0u) {
+      elevation = sum / static_cast<double>(num_finite);
+    }
+  }
+
+  // Ground sampling distance at the image center of every image.
+  const aslam::Camera& camera = ncameras_->getCamera(kFrameIdx);
+  const Eigen::Vector2d center_pixel(0.5 * camera.imageWidth(),
+                                     0.5 * camera.imageHeight());
+  Eigen::Vector3d C_ray_center, C_ray_neighbor;
+  if (!camera.backProject3(center_pixel, &C_ray_center) ||
+      !camera.backProject3(center_pixel + Eigen::Vector2d::UnitX(),
+                           &C_ray_neighbor)) {
+    return 1u;
+  }
+  std::vector<double> ground_sampling_distances;
   for (const Pose& T_G_B : T_G_Bs) {
-    T_G_Cs.push_back(T_G_B * ncameras_->get_T_C_B(0u).inverse());
+    const Pose T_G_C = T_G_B * ncameras_->get_T_C_B(kFrameIdx).inverse();
+    const Eigen::Matrix3d R_G_C = T_G_C.getRotationMatrix();
+    const Eigen::Vector3d& t_G_C = T_G_C.getPosition();
+    Eigen::Vector2d G_xy[2];
+    bool valid = true;
+    const Eigen::Vector3d C_rays[2] = {C_ray_center, C_ray_neighbor};
+    for (int k = 0; k < 2; ++k) {
+      const Eigen::Vector3d G_ray = R_G_C * C_rays[k];
+      const double scale = (elevation - t_G_C(2)) / G_ray(2);
+      valid = valid && std::isfinite(scale) && scale > 0.0;
+      G_xy[k] = (t_G_C + scale * G_ray).head<2>();
+    }
+    if (valid) {
+      ground_sampling_distances.push_back((G_xy[1] - G_xy[0]).norm());
+    }
+  }
+  if (ground_sampling_distances.empty()) {
+    return 1u;
+  }
+  std::vector<double>::iterator median =
+      ground_sampling_distances.begin() + ground_sampling_distances.size() / 2u;
+  std::nth_element(ground_sampling_distances.begin(), median,
+                   ground_sampling_distances.end());
+
+  // Largest factor whose reduced pixels are still smaller than the cells.
+  const double pixels_per_cell = map.getResolution() / *median;
+  size_t reduction_factor = 1u;
+  while (reduction_factor < kMaxImageReductionFactor &&
+         2.0 * reduction_factor <= pixels_per_cell) {
+    reduction_factor *= 2u;
+  }
+  LOG(INFO) << "Ground sampling distance: " << *median
+            << " m, image reduction factor: " << reduction_factor;
+  return reduction_factor;
+}
+
+void OrthoBackwardGrid::computeCameraPoses(const Poses& T_G_Bs, Poses* T_G_Cs,
+                                           Poses* T_C_Gs) const {
+  CHECK_NOTNULL(T_G_Cs);
+  CHECK_NOTNULL(T_C_Gs);
+  T_G_Cs->clear();
+  T_C_Gs->clear();
+  for (const Pose& T_G_B : T_G_Bs) {
+    T_G_Cs->push_back(T_G_B * ncameras_->get_T_C_B(0u).inverse());
+    T_C_Gs->push_back(T_G_Cs->back().inverse());
+  }
+}
+
+void OrthoBackwardGrid::updateMap(const Poses& T_G_Cs, const Poses& T_C_Gs,
+                                  const Images& images,
+                                  grid_map::GridMap* map) {
+  CHECK(map);
+  // Create the layers before the map is accessed by multiple threads. Only
+  // the orthomosaic layer of the current mode is written.
+  for (const std::string& layer :
+       {getOrthoLayer(), "num_observations", "elevation_angle", "elevation",
+        "observation_index"}) {
+    grid_map::getOrCreateLayer(layer, map);
   }
   if (settings_.use_multi_threads) {
-    updateOrthomosaicLayerMultiThreaded(T_G_Cs, images, map);
+    updateOrthomosaicLayerMultiThreaded(T_G_Cs, T_C_Gs, images, map);
   } else {
-    updateOrthomosaicLayer(T_G_Cs, images, map);
+    updateOrthomosaicLayer(T_G_Cs, T_C_Gs, images, map);
   }
+  VLOG(1) << "Updated " << last_updated_cells_.getNumCells() << " of "
+          << map->getSize().prod() << " cells";
 }
 
 void OrthoBackwardGrid::printParams() const {
@@ -248,6 +506,8 @@ void OrthoBackwardGrid::printParams() const {
                               settings_.save_orthomosaic_jpg)
       << utils::paramToString("Orthomosaic filename",
                               settings_.orthomosaic_jpg_filename)
+      << utils::paramToString("Use multi threads", settings_.use_multi_threads)
+      << utils::paramToString("Num. threads", settings_.num_threads)
       << std::string(50, '*') << std::endl;
   LOG(INFO) << out.str();
 }
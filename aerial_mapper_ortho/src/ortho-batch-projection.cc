@@ -0,0 +1,141 @@
+/*
+ *    Filename: ortho-batch-projection.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-ortho/ortho-batch-projection.h"
+
+// NON-SYSTEM
+#include <aslam/cameras/camera-pinhole.h>
+#include <aslam/cameras/distortion.h>
+#include <glog/logging.h>
+
+namespace ortho {
+
+BatchProjection::BatchProjection(const aslam::Camera& camera)
+    : camera_(camera),
+      distortion_model_(kGeneric),
+      fu_(0.0),
+      fv_(0.0),
+      cu_(0.0),
+      cv_(0.0),
+      distortion_coefficients_(Eigen::Vector4d::Zero()),
+      image_width_(static_cast<double>(camera.imageWidth())),
+      image_height_(static_cast<double>(camera.imageHeight())) {
+  if (camera_.getType() != aslam::Camera::Type::kPinhole) {
+    LOG(WARNING) << "Batch projection is only vectorized for pinhole cameras.";
+    return;
+  }
+  const aslam::PinholeCamera& pinhole_camera =
+      static_cast<const aslam::PinholeCamera&>(camera_);
+  fu_ = pinhole_camera.fu();
+  fv_ = pinhole_camera.fv();
+  cu_ = pinhole_camera.cu();
+  cv_ = pinhole_camera.cv();
+
+  if (!camera_.hasDistortion()) {
+    distortion_model_ = kNoDistortion;
+    return;
+  }
+  const aslam::Distortion& distortion = camera_.getDistortion();
+  switch (distortion.getType()) {
+    case aslam::Distortion::Type::kNoDistortion:
+      distortion_model_ = kNoDistortion;
+      break;
+    case aslam::Distortion::Type::kRadTan:
+      CHECK_EQ(distortion.getParameters().size(), 4);
+      distortion_model_ = kRadTan;
+      distortion_coefficients_ = distortion.getParameters();
+      break;
+    case aslam::Distortion::Type::kEquidistant:
+      CHECK_EQ(distortion.getParameters().size(), 4);
+      distortion_model_ = kEquidistant;
+      distortion_coefficients_ = distortion.getParameters();
+      break;
+    default:
+      LOG(WARNING) << "Batch projection is not vectorized for this "
+                   << "distortion model.";
+      break;
+  }
+}
+
+void BatchProjection::project(const Eigen::Matrix3Xd& G_points,
+                              const Eigen::Matrix3d& R_C_G,
+                              const Eigen::Vector3d& t_C_G,
+                              Eigen::Matrix3Xd* C_points,
+                              Eigen::Matrix2Xd* keypoints,
+                              VisibilityMask* visible) const {
+  CHECK_NOTNULL(C_points);
+  CHECK_NOTNULL(keypoints);
+  CHECK_NOTNULL(visible);
+  C_points->noalias() = R_C_G * G_points;
+  C_points->colwise() += t_C_G;
+  if (distortion_model_ == kGeneric) {
+    projectGeneric(*C_points, keypoints, visible);
+    return;
+  }
+
+  typedef Eigen::Array<double, 1, Eigen::Dynamic> RowArray;
+  const auto z = C_points->row(2).array();
+  RowArray x = C_points->row(0).array() / z;
+  RowArray y = C_points->row(1).array() / z;
+
+  // Same models as aslam::RadTanDistortion / aslam::EquidistantDistortion.
+  const Eigen::Vector4d& k = distortion_coefficients_;
+  if (distortion_model_ == kRadTan) {
+    const RowArray mx2 = x.square();
+    const RowArray my2 = y.square();
+    const RowArray mxy = x * y;
+    const RowArray rho2 = mx2 + my2;
+    const RowArray rad_dist = k(0) * rho2 + k(1) * rho2.square();
+    const RowArray x_distorted = x + x * rad_dist + 2.0 * k(2) * mxy +
+                                 k(3) * (rho2 + 2.0 * mx2);
+    y += y * rad_dist + 2.0 * k(3) * mxy + k(2) * (rho2 + 2.0 * my2);
+    x = x_distorted;
+  } else if (distortion_model_ == kEquidistant) {
+    static constexpr double kMinRadius = 1e-8;
+    const RowArray r = (x.square() + y.square()).sqrt();
+    const RowArray theta = r.atan();
+    const RowArray theta2 = theta.square();
+    const RowArray thetad =
+        theta *
+        (1.0 + theta2 * (k(0) + theta2 * (k(1) + theta2 * (k(2) +
+                                                            theta2 * k(3)))));
+    const RowArray scaling = (r > kMinRadius).select(thetad / r, 1.0);
+    x *= scaling;
+    y *= scaling;
+  }
+
+  keypoints->resize(2, G_points.cols());
+  keypoints->row(0) = (fu_ * x + cu_).matrix();
+  keypoints->row(1) = (fv_ * y + cv_).matrix();
+  const auto u = keypoints->row(0).array();
+  const auto v = keypoints->row(1).array();
+  *visible = (z > 0.0) && (u >= 0.0) && (v >= 0.0) && (u < image_width_) &&
+             (v < image_height_);
+}
+
+void BatchProjection::projectGeneric(const Eigen::Matrix3Xd& C_points,
+                                     Eigen::Matrix2Xd* keypoints,
+                                     VisibilityMask* visible) const {
+  keypoints->resize(2, C_points.cols());
+  visible->resize(C_points.cols());
+  for (int k = 0; k < C_points.cols(); ++k) {
+    Eigen::Vector2d keypoint;
+    const aslam::ProjectionResult& projection_result =
+        camera_.project3(C_points.col(k), &keypoint);
+    keypoints->col(k) = keypoint;
+    (*visible)(k) =
+        (keypoint(0) >= 0.0) && (keypoint(1) >= 0.0) &&
+        (keypoint(0) < image_width_) && (keypoint(1) < image_height_) &&
+        (projection_result.getDetailedStatus() !=
+         aslam::ProjectionResult::POINT_BEHIND_CAMERA) &&
+        (projection_result.getDetailedStatus() !=
+         aslam::ProjectionResult::PROJECTION_INVALID);
+  }
+}
+
+}  // namespace ortho
@@ -132,46 +132,65 @@ void OrthoForwardHomography::updateOrthomosaic(const Pose& T_G_B,
 }
 
 void OrthoForwardHomography::batch(const Poses& T_G_Bs, const Images& images) {
+  CHECK(T_G_Bs.size() == images.size());
   for (size_t i = 0u; i < images.size(); ++i) {
-    cv::Mat image_undistorted;
-    undistorter_->processImage(images[i], &image_undistorted);
-
-    const aslam::Transformation& T_G_C =
-        T_G_Bs[i] * ncameras_->get_T_C_B(kFrameIdx).inverse();
-    std::vector<cv::Point2f> ground_points, image_points;
-    for (int border_pixel_index = 0;
-         border_pixel_index < border_keypoints_.cols(); ++border_pixel_index) {
-      Eigen::Vector3d C_ray;
-      const Eigen::Vector2d& keypoint =
-          border_keypoints_.col(border_pixel_index);
-      ncameras_->getCameraShared(kFrameIdx)->backProject3(keypoint, &C_ray);
-      const double scale =
-          -(T_G_C.getPosition()(2) - settings_.ground_plane_elevation_m) /
-          (T_G_C.getRotationMatrix() * C_ray)(2);
-      const Eigen::Vector3d& G_landmark =
-          T_G_C.getPosition() + scale * T_G_C.getRotationMatrix() * C_ray -
-          settings_.origin;
-      ground_points.push_back(cv::Point2f(
-          G_landmark(1) +
-              static_cast<double>(settings_.width_mosaic_pixels) / 2.0,
-          G_landmark(0) +
-              static_cast<double>(settings_.width_mosaic_pixels) / 2.0));
-      image_points.push_back(
-          cv::Point2f(border_keypoints_.col(border_pixel_index)(0),
-                      border_keypoints_.col(border_pixel_index)(1)));
-    }
-    CHECK_EQ(ground_points.size(), 4u);
-    CHECK_EQ(image_points.size(), 4u);
-    const cv::Mat& perspective_transformation_matrix =
-        cv::getPerspectiveTransform(image_points, ground_points);
-    cv::Mat image_warped;
-    cv::warpPerspective(
-        image_undistorted, image_warped, perspective_transformation_matrix,
-        cv::Size(settings_.width_mosaic_pixels, settings_.height_mosaic_pixels),
-        cv::INTER_NEAREST, cv::BORDER_CONSTANT);
-    addImage(image_warped);
+    addToBatch(T_G_Bs[i], images[i]);
   }
+  finishBatch();
+}
+
+void OrthoForwardHomography::batch(const Poses& T_G_Bs,
+                                   io::ImageStream* images) {
+  CHECK_NOTNULL(images);
+  CHECK(T_G_Bs.size() == images->size());
+  cv::Mat image;
+  for (size_t i = 0u; images->next(&image); ++i) {
+    addToBatch(T_G_Bs[i], image);
+  }
+  finishBatch();
+}
+
+void OrthoForwardHomography::addToBatch(const Pose& T_G_B,
+                                        const Image& image) {
+  cv::Mat image_undistorted;
+  undistorter_->processImage(image, &image_undistorted);
+
+  const aslam::Transformation& T_G_C =
+      T_G_B * ncameras_->get_T_C_B(kFrameIdx).inverse();
+  std::vector<cv::Point2f> ground_points, image_points;
+  for (int border_pixel_index = 0;
+       border_pixel_index < border_keypoints_.cols(); ++border_pixel_index) {
+    Eigen::Vector3d C_ray;
+    const Eigen::Vector2d& keypoint = border_keypoints_.col(border_pixel_index);
+    ncameras_->getCameraShared(kFrameIdx)->backProject3(keypoint, &C_ray);
+    const double scale =
+        -(T_G_C.getPosition()(2) - settings_.ground_plane_elevation_m) /
+        (T_G_C.getRotationMatrix() * C_ray)(2);
+    const Eigen::Vector3d& G_landmark =
+        T_G_C.getPosition() + scale * T_G_C.getRotationMatrix() * C_ray -
+        settings_.origin;
+    ground_points.push_back(cv::Point2f(
+        G_landmark(1) +
+            static_cast<double>(settings_.width_mosaic_pixels) / 2.0,
+        G_landmark(0) +
+            static_cast<double>(settings_.width_mosaic_pixels) / 2.0));
+    image_points.push_back(
+        cv::Point2f(border_keypoints_.col(border_pixel_index)(0),
+                    border_keypoints_.col(border_pixel_index)(1)));
+  }
+  CHECK_EQ(ground_points.size(), 4u);
+  CHECK_EQ(image_points.size(), 4u);
+  const cv::Mat& perspective_transformation_matrix =
+      cv::getPerspectiveTransform(image_points, ground_points);
+  cv::Mat image_warped;
+  cv::warpPerspective(
+      image_undistorted, image_warped, perspective_transformation_matrix,
+      cv::Size(settings_.width_mosaic_pixels, settings_.height_mosaic_pixels),
+      cv::INTER_NEAREST, cv::BORDER_CONSTANT);
+  addImage(image_warped);
+}
 
+void OrthoForwardHomography::finishBatch() {
   blender_->blend(result_, result_mask_);
   showOrthomosaicCvWindow(result_);
   // publishOrthomosaic(result_);
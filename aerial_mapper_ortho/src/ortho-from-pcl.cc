@@ -8,13 +8,23 @@
 // HEADER
 #include "aerial-mapper-ortho/ortho-from-pcl.h"
 
+// SYSTEM
+#include <algorithm>
+
 // NON-SYSTEM
+#include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
 #include <aerial-mapper-utils/utils-common.h>
+#include <aerial-mapper-utils/utils-tiling.h>
 
 namespace ortho {
 
 OrthoFromPcl::OrthoFromPcl(const Settings& settings) : settings_(settings) {
   printParams();
+  if (settings_.use_multi_threads) {
+    utils::ThreadPoolSettings thread_pool_settings;
+    thread_pool_settings.num_threads = std::max(settings_.num_threads, 0);
+    thread_pool_.reset(new utils::ThreadPool(thread_pool_settings));
+  }
 }
 
 void OrthoFromPcl::process(
@@ -24,86 +34,144 @@ void OrthoFromPcl::process(
   CHECK(map);
 
   LOG(INFO) << "Number of points: " << pointcloud.size();
-  PointCloud<double> cloud_kdtree;
-  cloud_kdtree.pts.resize(pointcloud.size());
-  for (size_t i = 0u; i < pointcloud.size(); ++i) {
-    cloud_kdtree.pts[i].x = pointcloud[i](0);
-    cloud_kdtree.pts[i].y = pointcloud[i](1);
-    CHECK(i < intensities.size());
-    cloud_kdtree.pts[i].z = double(intensities[i]);
+  CHECK(pointcloud.size() <= intensities.size());
+  if (settings_.downsampling_bin_size_ratio > 0.0) {
+    utils::DownsamplingSettings downsampling_settings;
+    downsampling_settings.bin_size_m =
+        settings_.downsampling_bin_size_ratio * map->getResolution();
+    downsampling_settings.statistic = settings_.downsampling_statistic;
+    AlignedType<std::vector, Eigen::Vector3d>::type pointcloud_downsampled;
+    std::vector<int> intensities_downsampled;
+    utils::downsamplePointCloud(downsampling_settings, pointcloud,
+                                intensities.data(), &pointcloud_downsampled,
+                                &intensities_downsampled, thread_pool_.get());
+    LOG(INFO) << "Downsampled to " << pointcloud_downsampled.size()
+              << " points";
+    processWithAdaptor(EigenPointCloudAdaptor2D(pointcloud_downsampled),
+                       Eigen::Vector2d::Zero(),
+                       intensities_downsampled.data(), map);
+    return;
+  }
+  processWithAdaptor(EigenPointCloudAdaptor2D(pointcloud),
+                     Eigen::Vector2d::Zero(), intensities.data(), map);
+}
+
+void OrthoFromPcl::process(const PointCloudSoAView<float>& points,
+                           const Eigen::Vector3d& origin,
+                           const int* intensities,
+                           grid_map::GridMap* map) const {
+  CHECK(points.num_points > 0u);
+  CHECK_NOTNULL(intensities);
+  CHECK(map);
+
+  if (settings_.downsampling_bin_size_ratio > 0.0) {
+    AlignedType<std::vector, Eigen::Vector3d>::type pointcloud(
+        points.num_points);
+    for (size_t i = 0u; i < points.num_points; ++i) {
+      pointcloud[i] =
+          origin + Eigen::Vector3d(points.x[i], points.y[i], points.z[i]);
+    }
+    process(pointcloud,
+            std::vector<int>(intensities, intensities + points.num_points),
+            map);
+    return;
   }
 
-  // Construct a kd-tree index.
-  typedef PointCloudAdaptor<PointCloud<double> > PC2KD;
-  const PC2KD pc2kd(cloud_kdtree);
+  LOG(INFO) << "Number of points: " << points.num_points;
+  processWithAdaptor(PointCloudSoAAdaptor2D<float>(points), origin.head<2>(),
+                     intensities, map);
+}
+
+template <typename PC2KD>
+void OrthoFromPcl::processWithAdaptor(const PC2KD& pc2kd,
+                                      const Eigen::Vector2d& cloud_origin,
+                                      const int* intensities,
+                                      grid_map::GridMap* map) const {
+  // Construct a kd-tree index directly on the passed point cloud.
+  typedef typename PC2KD::coord_t coord_t;
   const size_t kDimensionKdTree = 2u;
   const size_t kMaxLeaf = 10u;
   typedef nanoflann::KDTreeSingleIndexAdaptor<
-      nanoflann::L2_Adaptor<double, PC2KD>, PC2KD, kDimensionKdTree>
+      nanoflann::L2_Adaptor<coord_t, PC2KD, double>, PC2KD, kDimensionKdTree>
       my_kd_tree_t;
   my_kd_tree_t kd_tree(kDimensionKdTree, pc2kd,
                        nanoflann::KDTreeSingleIndexAdaptorParams(kMaxLeaf));
   kd_tree.buildIndex();
 
-  // Loop over all cells.
+  // Loop over all cells, tile by tile.
   const ros::Time time1 = ros::Time::now();
-  grid_map::Matrix& layer_ortho = (*map)["ortho"];
-  for (grid_map::GridMapIterator it(*map); !it.isPastEnd(); ++it) {
-    grid_map::Position position;
-    map->getPosition(*it, position);
-    const grid_map::Index index(*it);
-    double x = index(0);
-    double y = index(1);
-    std::vector<std::pair<int, double> > indices_dists;
-    nanoflann::RadiusResultSet<double, int> result_set(
-        settings_.interpolation_radius, indices_dists);
-    const double query_pt[3] = {position.x(), position.y(), 0.0};
-    kd_tree.findNeighbors(result_set, query_pt, nanoflann::SearchParams());
-    // Adaptive interpolation.
-    if (settings_.use_adaptive_interpolation) {
-      int lambda = 10;
-      while (result_set.size() == 0u) {
-        nanoflann::RadiusResultSet<double, int> tmp(
-            lambda * settings_.interpolation_radius, indices_dists);
-        kd_tree.findNeighbors(tmp, query_pt, nanoflann::SearchParams());
-        lambda *= 10;
-      }
-    }
-    bool samples_in_interpolation_radius = result_set.size() > 0u;
-    if (samples_in_interpolation_radius) {
-      std::vector<double> distances;
-      std::vector<double> heights;
-      CHECK(result_set.size() > 0);
-      distances.clear();
-      heights.clear();
-      for (const std::pair<int, double>& s : result_set.m_indices_dists) {
-        distances.push_back(s.second);
-        heights.push_back(cloud_kdtree.pts[s.first].z);
-      }
-      CHECK(distances.size() > 0u);
-      CHECK(heights.size() > 0u);
-      CHECK(distances.size() == heights.size());
-      double idw_numerator = 0.0;
-      double idw_denominator = 0.0;
-      bool idw_perfect_match = false;
-      for (size_t i = 0u; i < heights.size(); ++i) {
-        // Inverse distance weighing.
-        if (distances[i] == 0.0) {
-          // Perfect match, no interpolation needed.
-          idw_numerator = heights[i];
-          idw_denominator = 1.0;
-          idw_perfect_match = true;
+  grid_map::Matrix& layer_ortho = grid_map::getOrCreateLayer("ortho", map);
+  auto generateTileWiseOrthomosaic = [&](size_t /*tile_index*/,
+                                         const utils::CellRange& tile) {
+    const grid_map::Index tile_end = tile.getEnd();
+    for (int y = tile.start(1); y < tile_end(1); ++y) {
+      for (int x = tile.start(0); x < tile_end(0); ++x) {
+        grid_map::Position position;
+        map->getPosition(grid_map::Index(x, y), position);
+        std::vector<std::pair<int, double> > indices_dists;
+        nanoflann::RadiusResultSet<double, int> result_set(
+            settings_.interpolation_radius, indices_dists);
+        const coord_t query_pt[2] = {
+            static_cast<coord_t>(position.x() - cloud_origin.x()),
+            static_cast<coord_t>(position.y() - cloud_origin.y())};
+        kd_tree.findNeighbors(result_set, query_pt, nanoflann::SearchParams());
+        // Adaptive interpolation.
+        if (settings_.use_adaptive_interpolation) {
+          int lambda = 10;
+          while (result_set.size() == 0u) {
+            nanoflann::RadiusResultSet<double, int> tmp(
+                lambda * settings_.interpolation_radius, indices_dists);
+            kd_tree.findNeighbors(tmp, query_pt, nanoflann::SearchParams());
+            lambda *= 10;
+          }
         }
-        if (!idw_perfect_match) {
-          CHECK(distances[i] > 0.0);
-          idw_numerator += heights[i] / (distances[i]);
-          idw_denominator += 1.0 / (distances[i]);
+        bool samples_in_interpolation_radius = result_set.size() > 0u;
+        if (samples_in_interpolation_radius) {
+          std::vector<double> distances;
+          std::vector<double> heights;
+          CHECK(result_set.size() > 0);
+          for (const std::pair<int, double>& s : result_set.m_indices_dists) {
+            distances.push_back(s.second);
+            heights.push_back(static_cast<double>(intensities[s.first]));
+          }
+          CHECK(distances.size() > 0u);
+          CHECK(heights.size() > 0u);
+          CHECK(distances.size() == heights.size());
+          double idw_numerator = 0.0;
+          double idw_denominator = 0.0;
+          bool idw_perfect_match = false;
+          for (size_t i = 0u; i < heights.size(); ++i) {
+            // Inverse distance weighing.
+            if (distances[i] == 0.0) {
+              // Perfect match, no interpolation needed.
+              idw_numerator = heights[i];
+              idw_denominator = 1.0;
+              idw_perfect_match = true;
+            }
+            if (!idw_perfect_match) {
+              CHECK(distances[i] > 0.0);
+              idw_numerator += heights[i] / (distances[i]);
+              idw_denominator += 1.0 / (distances[i]);
+            }
+          }
+          // Inverse distance weighing.
+          CHECK(idw_denominator > 0.0);
+          const double idw_height = idw_numerator / idw_denominator;
+          layer_ortho(x, y) = idw_height;
         }
-      }
-      // Inverse distance weighing.
-      CHECK(idw_denominator > 0.0);
-      const double idw_height = idw_numerator / idw_denominator;
-      layer_ortho(x, y) = idw_height;
+      }  // loop x
+    }    // loop y
+  };     // lambda function
+
+  const utils::CellTiling tiling(map->getSize(), kTileSizeCells);
+  if (thread_pool_) {
+    utils::parForTiles(tiling, generateTileWiseOrthomosaic,
+                       thread_pool_.get());
+  } else {
+    for (size_t tile_index = 0u; tile_index < tiling.getNumTiles();
+         ++tile_index) {
+      generateTileWiseOrthomosaic(tile_index,
+                                  tiling.getTileCells(tile_index));
     }
   }
 
@@ -125,6 +193,10 @@ void OrthoFromPcl::printParams() const {
                               settings_.save_orthomosaic_jpg)
       << utils::paramToString("Orthomosaic jpg filename",
                               settings_.orthomosaic_jpg_filename)
+      << utils::paramToString("Use multi threads", settings_.use_multi_threads)
+      << utils::paramToString("Num. threads", settings_.num_threads)
+      << utils::paramToString("Downsampling bin ratio",
+                              settings_.downsampling_bin_size_ratio)
       << std::string(50, '*') << std::endl;
   LOG(INFO) << out.str();
 }
@@ -0,0 +1,39 @@
+/*
+ *    Filename: elevation-height-prior.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef ELEVATION_HEIGHT_PRIOR_H_
+#define ELEVATION_HEIGHT_PRIOR_H_
+
+// NON-SYSTEM
+#include <aerial-mapper-dense-pcl/disparity-range-predictor.h>
+#include <aerial-mapper-grid-map/aerial-mapper-elevation-bounds.h>
+#include <Eigen/Dense>
+
+namespace pipeline {
+
+/// Terrain height of the elevation layer for the disparity search range
+/// guidance of the stereo module, taken from the block-wise elevation bounds
+/// of the map.
+class ElevationHeightPrior : public stereo::TerrainHeightPrior {
+ public:
+  /// The bounds must outlive the prior.
+  explicit ElevationHeightPrior(const grid_map::ElevationBounds& bounds)
+      : bounds_(bounds) {}
+
+  bool getHeightRange(const Eigen::Vector2d& min_xy,
+                      const Eigen::Vector2d& max_xy, double* min_height,
+                      double* max_height) const {
+    return bounds_.getElevationRange(min_xy, max_xy, min_height, max_height);
+  }
+
+ private:
+  const grid_map::ElevationBounds& bounds_;
+};
+
+}  // namespace pipeline
+
+#endif  // ELEVATION_HEIGHT_PRIOR_H_
@@ -0,0 +1,138 @@
+/*
+ *    Filename: pipeline.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+// SYSTEM
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// NON-SYSTEM
+#include <aerial-mapper-dense-pcl/stereo.h>
+#include <aerial-mapper-dsm/dsm.h>
+#include <aerial-mapper-grid-map/aerial-mapper-grid-map.h>
+#include <aerial-mapper-io/aerial-mapper-image-stream.h>
+#include <aerial-mapper-io/aerial-mapper-io.h>
+#include <aerial-mapper-io/aerial-mapper-web-tiles.h>
+#include <aerial-mapper-ortho/ortho-backward-grid.h>
+#include <aerial-mapper-pipeline/elevation-height-prior.h>
+#include <aerial-mapper-utils/utils-bounded-queue.h>
+#include <aerial-mapper-utils/utils-tiling.h>
+#include <Eigen/Dense>
+
+namespace pipeline {
+
+struct Settings {
+  // Capacity of every queue between two stages [batches]. Bounds the number
+  // of decoded images and point clouds in flight.
+  size_t queue_capacity = 2u;
+  // Only every n-th image is densified. All images are rendered into the
+  // orthomosaic, batch by batch between two densified images.
+  size_t use_every_nth_image = 1u;
+};
+
+/// Incremental mapping pipeline: dense reconstruction, DSM and orthomosaic
+/// updates and publication of the changed cells. Every stage runs on its own
+/// thread and passes its results through a bounded queue:
+///
+///   load -> rectify -> match -> DSM -> ortho -> publish
+///
+/// load: decodes the images (on the calling thread, io::ImageStream decodes
+///       ahead in the background).
+/// rectify: pairs consecutive densified images, undistorts and rectifies.
+/// match: block matching and triangulation of the point cloud.
+/// DSM: updates the elevation layer with the point cloud.
+/// ortho: renders the images of the batch into the orthomosaic.
+/// publish: hands the changed cells to the background publisher of the map
+///          and updates the web map tiles from a copy of the changed cells.
+///
+/// While the map stages work on one batch, the stereo stages already process
+/// the next ones, so the throughput approaches the slowest stage instead of
+/// the sum of all stages. The map stages read and write the same map; they
+/// hold the map lock while they access it and are therefore serialized among
+/// each other.
+///
+/// With search range guidance enabled, the stereo module predicts the
+/// disparities of every pair from the elevation of the terrain mapped so far,
+/// see stereo::DisparityRangePredictor. The orthomosaic culls the images with
+/// the same elevation bounds.
+class Pipeline {
+ public:
+  /// The modules are configured by the caller and must outlive the pipeline.
+  /// web_tiles is optional.
+  Pipeline(const Settings& settings, stereo::Stereo* stereo, dsm::Dsm* dsm,
+           ortho::OrthoBackwardGrid* mosaic, grid_map::AerialGridMap* map,
+           io::WebTileExporter* web_tiles = nullptr);
+
+  /// Detaches the elevation bounds from the stereo and ortho modules.
+  ~Pipeline();
+
+  /// Processes the images of the stream, T_G_Bs holds one pose per image.
+  /// Blocks until the last batch is published. The images after the last
+  /// densified image are rendered into the orthomosaic without a DSM update.
+  /// Call map->stopPublishing() to flush the background publisher.
+  void process(const Poses& T_G_Bs, io::ImageStream* images);
+
+ private:
+  /// Images between two densified images and the results of the stages.
+  struct Batch {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    Poses T_G_Bs;
+    Images images;
+    // False for the batch after the last densified image.
+    bool has_stereo_frame = false;
+    stereo::StereoFrame stereo_frame;
+    stereo::RectifiedStereoPair rectified_stereo_pair;
+    AlignedType<std::vector, Eigen::Vector3d>::type point_cloud;
+    utils::CellRange updated_cells;
+  };
+  typedef std::unique_ptr<Batch> BatchPtr;
+  typedef utils::BoundedQueue<BatchPtr> BatchQueue;
+
+  /// Accumulated time a stage spent working, i.e. not waiting on a queue.
+  struct StageStatistics {
+    explicit StageStatistics(const std::string& name_) : name(name_) {}
+    const std::string name;
+    double busy_s = 0.0;
+    size_t num_batches = 0u;
+  };
+
+  void load(const Poses& T_G_Bs, io::ImageStream* images, BatchQueue* output);
+  void rectify(BatchQueue* input, BatchQueue* output);
+  void match(BatchQueue* input, BatchQueue* output);
+  void updateDsm(BatchQueue* input, BatchQueue* output);
+  void updateOrthomosaic(BatchQueue* input, BatchQueue* output);
+  void publish(BatchQueue* input);
+
+  void logStatistics() const;
+
+  const Settings settings_;
+  stereo::Stereo* stereo_;
+  dsm::Dsm* dsm_;
+  ortho::OrthoBackwardGrid* mosaic_;
+  grid_map::AerialGridMap* map_;
+  io::WebTileExporter* web_tiles_;
+
+  // Serializes the stages that access the map.
+  std::mutex map_mutex_;
+
+  // Elevation bounds of the DSM for the stereo and ortho modules, updated by
+  // the DSM stage.
+  grid_map::ElevationBounds elevation_bounds_;
+  ElevationHeightPrior height_prior_;
+
+  enum Stage { kLoad, kRectify, kMatch, kDsm, kOrtho, kPublish, kNumStages };
+  std::vector<StageStatistics> statistics_;
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_H_
@@ -0,0 +1,243 @@
+/*
+ *    Filename: pipeline.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-pipeline/pipeline.h"
+
+// SYSTEM
+#include <chrono>
+#include <thread>
+#include <utility>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace pipeline {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double getSecondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+Pipeline::Pipeline(const Settings& settings, stereo::Stereo* stereo,
+                   dsm::Dsm* dsm, ortho::OrthoBackwardGrid* mosaic,
+                   grid_map::AerialGridMap* map,
+                   io::WebTileExporter* web_tiles)
+    : settings_(settings),
+      stereo_(CHECK_NOTNULL(stereo)),
+      dsm_(CHECK_NOTNULL(dsm)),
+      mosaic_(CHECK_NOTNULL(mosaic)),
+      map_(CHECK_NOTNULL(map)),
+      web_tiles_(web_tiles),
+      elevation_bounds_(*map_->getMutable()),
+      height_prior_(elevation_bounds_) {
+  CHECK_GT(settings_.queue_capacity, 0u);
+  CHECK_GT(settings_.use_every_nth_image, 0u);
+  elevation_bounds_.update(*map_->getMutable(),
+                           utils::CellRange(grid_map::Index::Zero(),
+                                            map_->getMutable()->getSize()));
+  stereo_->setTerrainHeightPrior(&height_prior_);
+  mosaic_->setElevationBounds(&elevation_bounds_);
+}
+
+Pipeline::~Pipeline() {
+  stereo_->setTerrainHeightPrior(nullptr);
+  mosaic_->setElevationBounds(nullptr);
+}
+
+void Pipeline::process(const Poses& T_G_Bs, io::ImageStream* images) {
+  CHECK_NOTNULL(images);
+  CHECK_EQ(T_G_Bs.size(), images->size());
+
+  statistics_.clear();
+  for (const char* name :
+       {"load", "rectify", "match", "dsm", "ortho", "publish"}) {
+    statistics_.emplace_back(name);
+  }
+  CHECK_EQ(statistics_.size(), static_cast<size_t>(kNumStages));
+
+  BatchQueue loaded(settings_.queue_capacity);
+  BatchQueue rectified(settings_.queue_capacity);
+  BatchQueue matched(settings_.queue_capacity);
+  BatchQueue dsm_updated(settings_.queue_capacity);
+  BatchQueue ortho_updated(settings_.queue_capacity);
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(&Pipeline::rectify, this, &loaded, &rectified);
+  threads.emplace_back(&Pipeline::match, this, &rectified, &matched);
+  threads.emplace_back(&Pipeline::updateDsm, this, &matched, &dsm_updated);
+  threads.emplace_back(&Pipeline::updateOrthomosaic, this, &dsm_updated,
+                       &ortho_updated);
+  threads.emplace_back(&Pipeline::publish, this, &ortho_updated);
+
+  load(T_G_Bs, images, &loaded);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  logStatistics();
+}
+
+void Pipeline::load(const Poses& T_G_Bs, io::ImageStream* images,
+                    BatchQueue* output) {
+  CHECK_NOTNULL(images);
+  CHECK_NOTNULL(output);
+  // Every loaded image is passed on as a batch of its own; the rectify stage
+  // groups the images between two densified images.
+  cv::Mat image;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0u; images->next(&image); ++i) {
+    BatchPtr frame(new Batch);
+    frame->T_G_Bs.push_back(T_G_Bs[i]);
+    frame->images.push_back(image);
+    statistics_[kLoad].busy_s += getSecondsSince(start);
+    ++statistics_[kLoad].num_batches;
+    output->push(std::move(frame));
+    start = Clock::now();
+  }
+  output->close();
+}
+
+void Pipeline::rectify(BatchQueue* input, BatchQueue* output) {
+  CHECK_NOTNULL(input);
+  CHECK_NOTNULL(output);
+  BatchPtr batch(new Batch);
+  BatchPtr frame;
+  size_t skip = 0u;
+  while (input->pop(&frame)) {
+    const Clock::time_point start = Clock::now();
+    CHECK_EQ(frame->images.size(), 1u);
+    const Pose& T_G_B = frame->T_G_Bs.front();
+    const Image& image = frame->images.front();
+    batch->T_G_Bs.push_back(T_G_B);
+    batch->images.push_back(image);
+    // The first densified image only starts the first stereo pair, its
+    // images are rendered together with the next batch.
+    if (++skip % settings_.use_every_nth_image == 0u &&
+        stereo_->makeStereoFrame(T_G_B, image, &batch->stereo_frame)) {
+      stereo_->rectifyStereoFrame(batch->stereo_frame,
+                                  &batch->rectified_stereo_pair);
+      batch->has_stereo_frame = true;
+    }
+    statistics_[kRectify].busy_s += getSecondsSince(start);
+    if (batch->has_stereo_frame) {
+      ++statistics_[kRectify].num_batches;
+      output->push(std::move(batch));
+      batch.reset(new Batch);
+    }
+  }
+  if (!batch->images.empty()) {
+    output->push(std::move(batch));
+  }
+  output->close();
+}
+
+void Pipeline::match(BatchQueue* input, BatchQueue* output) {
+  CHECK_NOTNULL(input);
+  CHECK_NOTNULL(output);
+  BatchPtr batch;
+  while (input->pop(&batch)) {
+    if (batch->has_stereo_frame) {
+      const Clock::time_point start = Clock::now();
+      stereo_->densifyStereoFrame(batch->stereo_frame,
+                                  batch->rectified_stereo_pair,
+                                  &batch->point_cloud, nullptr);
+      // The stereo images are not needed by the following stages.
+      batch->stereo_frame = stereo::StereoFrame();
+      batch->rectified_stereo_pair = stereo::RectifiedStereoPair();
+      statistics_[kMatch].busy_s += getSecondsSince(start);
+      ++statistics_[kMatch].num_batches;
+    }
+    output->push(std::move(batch));
+  }
+  output->close();
+}
+
+void Pipeline::updateDsm(BatchQueue* input, BatchQueue* output) {
+  CHECK_NOTNULL(input);
+  CHECK_NOTNULL(output);
+  BatchPtr batch;
+  while (input->pop(&batch)) {
+    if (batch->has_stereo_frame) {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      const Clock::time_point start = Clock::now();
+      LOG(INFO) << "Filling DSM with " << batch->point_cloud.size()
+                << " points";
+      dsm_->process(batch->point_cloud, map_->getMutable());
+      batch->updated_cells = dsm_->getLastUpdatedCells();
+      elevation_bounds_.update(*map_->getMutable(), batch->updated_cells);
+      batch->point_cloud.clear();
+      statistics_[kDsm].busy_s += getSecondsSince(start);
+      ++statistics_[kDsm].num_batches;
+    }
+    output->push(std::move(batch));
+  }
+  output->close();
+}
+
+void Pipeline::updateOrthomosaic(BatchQueue* input, BatchQueue* output) {
+  CHECK_NOTNULL(input);
+  CHECK_NOTNULL(output);
+  BatchPtr batch;
+  while (input->pop(&batch)) {
+    {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      const Clock::time_point start = Clock::now();
+      LOG(INFO) << "Updating orthomosaic layer with " << batch->T_G_Bs.size()
+                << " image-pose-pairs";
+      mosaic_->process(batch->T_G_Bs, batch->images, map_->getMutable());
+      batch->updated_cells.extend(mosaic_->getLastUpdatedCells());
+      statistics_[kOrtho].busy_s += getSecondsSince(start);
+      ++statistics_[kOrtho].num_batches;
+    }
+    batch->images.clear();
+    output->push(std::move(batch));
+  }
+  output->close();
+}
+
+void Pipeline::publish(BatchQueue* input) {
+  CHECK_NOTNULL(input);
+  BatchPtr batch;
+  while (input->pop(&batch)) {
+    const utils::CellRange& updated_cells = batch->updated_cells;
+    if (updated_cells.isEmpty()) {
+      continue;
+    }
+    const Clock::time_point start = Clock::now();
+    // Only the copies are made under the map lock; the tiles are encoded and
+    // written from the copy while the map stages continue.
+    grid_map::GridMap submap;
+    utils::CellRange submap_updated_cells;
+    {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      map_->publishAsync(updated_cells.start, updated_cells.size);
+      if (web_tiles_) {
+        web_tiles_->extractChangedSubmap(*map_->getMutable(), updated_cells,
+                                         &submap, &submap_updated_cells);
+      }
+    }
+    if (web_tiles_) {
+      web_tiles_->exportChanged(submap, submap_updated_cells);
+    }
+    statistics_[kPublish].busy_s += getSecondsSince(start);
+    ++statistics_[kPublish].num_batches;
+  }
+}
+
+void Pipeline::logStatistics() const {
+  for (const StageStatistics& statistics : statistics_) {
+    LOG(INFO) << "Stage " << statistics.name << ": " << statistics.num_batches
+              << " batches, busy for " << statistics.busy_s << " s";
+  }
+}
+
+}  // namespace pipeline
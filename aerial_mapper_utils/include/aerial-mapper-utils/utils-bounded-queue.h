@@ -0,0 +1,93 @@
+/*
+ *    Filename: utils-bounded-queue.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef UTILS_BOUNDED_QUEUE_H_
+#define UTILS_BOUNDED_QUEUE_H_
+
+// SYSTEM
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace utils {
+
+/// Blocking first-in first-out queue of limited capacity that connects the
+/// stages of a pipeline. A full queue blocks the producer, so a fast stage
+/// cannot run ahead of a slow one and the memory held by the items in flight
+/// stays bounded. The producer closes the queue after its last item; the
+/// consumer then drains the remaining items.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity), closed_(false) {
+    CHECK_GT(capacity_, 0u);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  inline size_t getCapacity() const { return capacity_; }
+
+  /// Blocks while the queue is full. Returns false (and drops the item) if
+  /// the queue is closed.
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock,
+                   [this]() { return closed_ || items_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /// Blocks while the queue is empty and open. Returns false once the queue
+  /// is closed and drained.
+  bool pop(T* item) {
+    CHECK_NOTNULL(item);
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return false;
+    }
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  /// Wakes up all waiting threads. Pending items can still be popped.
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  bool closed_;
+};
+
+}  // namespace utils
+
+#endif  // UTILS_BOUNDED_QUEUE_H_
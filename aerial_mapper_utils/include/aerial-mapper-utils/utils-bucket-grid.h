@@ -0,0 +1,64 @@
+/*
+ *    Filename: utils-bucket-grid.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef UTILS_BUCKET_GRID_H_
+#define UTILS_BUCKET_GRID_H_
+
+// SYSTEM
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/// Dynamic 2D spatial index for 3D points. Points are sorted into square
+/// buckets in the x-y plane, so inserting a point is O(1) and never requires
+/// rebuilding the index (as opposed to the static nanoflann kd-tree).
+/// Radius searches only visit the buckets overlapping with the search circle;
+/// with a bucket size close to the search radius that are 3x3 buckets.
+class PointBucketGrid {
+ public:
+  struct Point {
+    double x, y, z;
+  };
+
+  explicit PointBucketGrid(double bucket_size);
+
+  void insert(double x, double y, double z);
+
+  void clear();
+
+  inline size_t size() const { return points_.size(); }
+
+  inline const Point& getPoint(size_t index) const { return points_[index]; }
+
+  /// Returns (index, squared distance) of all points whose squared 2D
+  /// distance to (x, y) is smaller than radius_squared. The results are
+  /// appended to indices_dists, similar to nanoflann::RadiusResultSet.
+  void radiusSearch(double x, double y, double radius_squared,
+                    std::vector<std::pair<int, double> >* indices_dists) const;
+
+ private:
+  typedef std::pair<int, int> BucketCoordinates;
+
+  BucketCoordinates getBucketCoordinates(double x, double y) const;
+
+  static inline int64_t getBucketKey(int bucket_x, int bucket_y) {
+    return (static_cast<int64_t>(bucket_x) << 32) ^
+           static_cast<int64_t>(static_cast<uint32_t>(bucket_y));
+  }
+
+  const double bucket_size_;
+  std::vector<Point> points_;
+  std::unordered_map<int64_t, std::vector<int> > buckets_;
+};
+
+}  // namespace utils
+
+#endif  // UTILS_BUCKET_GRID_H_
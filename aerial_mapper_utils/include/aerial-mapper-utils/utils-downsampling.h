@@ -0,0 +1,53 @@
+/*
+ *    Filename: utils-downsampling.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef UTILS_DOWNSAMPLING_H_
+#define UTILS_DOWNSAMPLING_H_
+
+// SYSTEM
+#include <vector>
+
+// NON-SYSTEM
+#include <Eigen/Core>
+
+#include "aerial-mapper-utils/utils-nearest-neighbor.h"
+#include "aerial-mapper-utils/utils-thread-pool.h"
+
+namespace utils {
+
+// Height and intensity of the point that represents a bin.
+enum class BinStatistic { Mean, Median };
+
+struct DownsamplingSettings {
+  // Side length of the square bins in the x-y plane [m], e.g. a fraction of
+  // the grid_map resolution.
+  double bin_size_m = 1.0;
+  BinStatistic statistic = BinStatistic::Mean;
+};
+
+/// Reduces the points of every bin of the x-y plane to one point at their
+/// mean x-y position, with the mean or median height and intensity. Points
+/// much closer than the resolution of a grid_map add little to its cells but
+/// bloat kd-trees and radius searches on them.
+///
+/// Runs on the thread pool if given: the points are distributed over
+/// partitions by bin (counting sort), then every partition is sorted by bin
+/// and reduced independently. The result does not depend on the number of
+/// threads; the bins are ordered by partition and bin. intensities (one per
+/// point) and intensities_downsampled may be nullptr. Points with a non-finite
+/// coordinate are skipped.
+void downsamplePointCloud(
+    const DownsamplingSettings& settings,
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    const int* intensities,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_downsampled,
+    std::vector<int>* intensities_downsampled,
+    ThreadPool* thread_pool = nullptr);
+
+}  // namespace utils
+
+#endif  // UTILS_DOWNSAMPLING_H_
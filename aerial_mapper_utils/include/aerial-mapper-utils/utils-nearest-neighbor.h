@@ -9,7 +9,9 @@
 #define UTILS_NEAREST_NEIGHBOR_H_
 
 // SYSTEM
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 // NON-SYSTEM
 #include <Eigen/Core>
@@ -45,11 +47,13 @@ struct PointCloudAdaptor {
   // Returns the distance between the vector "p1[0:size-1]" and the data point
   // with index "idx_p2" stored in the class:
   inline coord_t kdtree_distance(const coord_t *p1, const size_t idx_p2,
-                                 size_t /*size*/) const {
-    const coord_t d0 = p1[0] - derived().pts[idx_p2].x;
-    const coord_t d1 = p1[1] - derived().pts[idx_p2].y;
-    const coord_t d2 = p1[2] - derived().pts[idx_p2].z;
-    return d0 * d0 + d1 * d1 + d2 * d2;
+                                 size_t size) const {
+    coord_t distance = coord_t();
+    for (size_t dim = 0u; dim < size; ++dim) {
+      const coord_t d = p1[dim] - kdtree_get_pt(idx_p2, static_cast<int>(dim));
+      distance += d * d;
+    }
+    return distance;
   }
   // Returns the dim'th component of the idx'th point in the class:
   // Since this is inlined and the "dim" argument is typically an immediate
@@ -75,4 +79,85 @@ struct PointCloudAdaptor {
   }
 };  // end of PointCloudAdaptor
 
+/// Point cloud stored as structure of arrays. Compared to PointCloud<double>,
+/// PointCloudSoA<float> takes half the memory and a 2D search only touches
+/// the x and y arrays.
+template <typename T>
+struct PointCloudSoA {
+  typedef T coord_t;
+  inline void resize(size_t num_points) {
+    x.resize(num_points);
+    y.resize(num_points);
+    z.resize(num_points);
+  }
+  inline size_t size() const { return x.size(); }
+  std::vector<T> x, y, z;
+};
+
+/// Non-owning view of point coordinates stored as structure of arrays, e.g.
+/// of a PointCloudSoA or of arrays owned by the caller.
+template <typename T>
+struct PointCloudSoAView {
+  typedef T coord_t;
+  PointCloudSoAView() : x(nullptr), y(nullptr), z(nullptr), num_points(0u) {}
+  PointCloudSoAView(const T *x_, const T *y_, const T *z_, size_t num_points_)
+      : x(x_), y(y_), z(z_), num_points(num_points_) {}
+  explicit PointCloudSoAView(const PointCloudSoA<T> &cloud)
+      : x(cloud.x.data()),
+        y(cloud.y.data()),
+        z(cloud.z.data()),
+        num_points(cloud.size()) {}
+  const T *x;
+  const T *y;
+  const T *z;
+  size_t num_points;
+};
+
+/// 2D kd-tree adaptor (x, y) referencing a PointCloudSoAView. The data is
+/// not copied and must outlive the adaptor and the kd-tree.
+template <typename T>
+struct PointCloudSoAAdaptor2D {
+  typedef T coord_t;
+  explicit PointCloudSoAAdaptor2D(const PointCloudSoAView<T> &view_)
+      : view(view_) {}
+  inline size_t kdtree_get_point_count() const { return view.num_points; }
+  inline T kdtree_distance(const T *p1, const size_t idx_p2,
+                           size_t /*size*/) const {
+    const T d0 = p1[0] - view.x[idx_p2];
+    const T d1 = p1[1] - view.y[idx_p2];
+    return d0 * d0 + d1 * d1;
+  }
+  inline T kdtree_get_pt(const size_t idx, int dim) const {
+    return dim == 0 ? view.x[idx] : view.y[idx];
+  }
+  template <class BBOX>
+  bool kdtree_get_bbox(BBOX & /*bb*/) const {
+    return false;
+  }
+  const PointCloudSoAView<T> view;
+};
+
+/// 2D kd-tree adaptor (x, y) referencing the caller's point cloud without
+/// copying it. The cloud must outlive the adaptor and the kd-tree.
+struct EigenPointCloudAdaptor2D {
+  typedef double coord_t;
+  typedef AlignedType<std::vector, Eigen::Vector3d>::type Cloud;
+  explicit EigenPointCloudAdaptor2D(const Cloud &cloud_) : cloud(cloud_) {}
+  inline size_t kdtree_get_point_count() const { return cloud.size(); }
+  inline double kdtree_distance(const double *p1, const size_t idx_p2,
+                                size_t /*size*/) const {
+    const double d0 = p1[0] - cloud[idx_p2].x();
+    const double d1 = p1[1] - cloud[idx_p2].y();
+    return d0 * d0 + d1 * d1;
+  }
+  inline double kdtree_get_pt(const size_t idx, int dim) const {
+    return cloud[idx](dim);
+  }
+  template <class BBOX>
+  bool kdtree_get_bbox(BBOX & /*bb*/) const {
+    return false;
+  }
+  const Cloud &cloud;
+};
+
 #endif  // UTILS_NEAREST_NEIGHBOR_H_
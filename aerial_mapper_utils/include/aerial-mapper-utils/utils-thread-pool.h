@@ -0,0 +1,146 @@
+/*
+ *    Filename: utils-thread-pool.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef UTILS_THREAD_POOL_H_
+#define UTILS_THREAD_POOL_H_
+
+// SYSTEM
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace utils {
+
+struct ThreadPoolSettings {
+  /// Number of worker threads. 0 uses all available hardware threads.
+  size_t num_threads = 0u;
+  /// Pin worker k to core k (modulo the number of cores).
+  bool pin_threads_to_cores = false;
+};
+
+/// Persistent pool of worker threads. Every worker owns a task queue; idle
+/// workers steal from the queues of the others, so uneven tasks (e.g. tiles
+/// with and without visible images) are balanced automatically.
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+  static constexpr size_t kAnyWorker = std::numeric_limits<size_t>::max();
+
+  explicit ThreadPool(const ThreadPoolSettings& settings =
+                          ThreadPoolSettings());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  inline size_t getNumThreads() const { return workers_.size(); }
+
+  /// Index of the calling worker thread in its pool, or kAnyWorker if the
+  /// caller is not a pool thread. Can be used to select per-worker scratch
+  /// buffers.
+  static size_t getCurrentWorkerIndex();
+
+  /// Queues a task. With a worker index the task is placed in the queue of
+  /// that worker (affinity); it may still be stolen by an idle worker.
+  void submit(const Task& task, size_t worker_index = kAnyWorker);
+
+  /// Calls functor(begin, end) for consecutive chunks of [0, num_items) and
+  /// blocks until all chunks are processed. The calling thread helps with the
+  /// work, so nested calls from within a task do not deadlock. A chunk size of
+  /// 0 picks a size that yields a few chunks per worker.
+  template <typename Functor>
+  void parallelFor(size_t num_items, const Functor& functor,
+                   size_t chunk_size = 0u);
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void workerLoop(size_t worker_index);
+
+  /// Queue to serve first: the own queue for workers of this pool.
+  size_t getHomeQueueIndex() const;
+
+  /// Pops from the back of the own queue or steals from the front of another.
+  bool tryPopTask(size_t worker_index, Task* task);
+
+  void pinToCore(size_t worker_index);
+
+  ThreadPoolSettings settings_;
+  std::vector<std::unique_ptr<WorkerQueue> > queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_condition_;
+  std::atomic<size_t> num_queued_tasks_;
+  std::atomic<size_t> next_queue_;
+  bool shutdown_;
+
+  static constexpr size_t kChunksPerWorker = 4u;
+};
+
+template <typename Functor>
+void ThreadPool::parallelFor(size_t num_items, const Functor& functor,
+                             size_t chunk_size) {
+  if (num_items == 0u) {
+    return;
+  }
+  if (chunk_size == 0u) {
+    chunk_size = std::max<size_t>(
+        1u, num_items / (kChunksPerWorker * getNumThreads()));
+  }
+  const size_t num_chunks = (num_items + chunk_size - 1u) / chunk_size;
+  if (num_chunks == 1u) {
+    functor(size_t(0u), num_items);
+    return;
+  }
+
+  struct Group {
+    std::atomic<size_t> num_remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+  std::shared_ptr<Group> group = std::make_shared<Group>();
+  group->num_remaining = num_chunks;
+  for (size_t chunk = 0u; chunk < num_chunks; ++chunk) {
+    const size_t begin = chunk * chunk_size;
+    const size_t end = std::min(begin + chunk_size, num_items);
+    submit([group, &functor, begin, end]() {
+      functor(begin, end);
+      if (--group->num_remaining == 0u) {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->done.notify_all();
+      }
+    }, chunk % getNumThreads());
+  }
+
+  // Help until all queues are drained. After that, the remaining chunks of
+  // this group are being executed by other threads.
+  const size_t home_queue_index = getHomeQueueIndex();
+  Task task;
+  while (group->num_remaining > 0u && tryPopTask(home_queue_index, &task)) {
+    task();
+  }
+  std::unique_lock<std::mutex> lock(group->mutex);
+  group->done.wait(lock, [&group]() { return group->num_remaining == 0u; });
+}
+
+}  // namespace utils
+
+#endif  // UTILS_THREAD_POOL_H_
@@ -0,0 +1,185 @@
+/*
+ *    Filename: utils-tiling.h
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+#ifndef UTILS_TILING_H_
+#define UTILS_TILING_H_
+
+// SYSTEM
+#include <algorithm>
+#include <cstddef>
+
+// NON-SYSTEM
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include "aerial-mapper-utils/utils-thread-pool.h"
+
+namespace utils {
+
+/// Tiles are coarse enough to be scheduled one by one; stealing single tiles
+/// balances tiles of very different cost.
+static constexpr size_t kTilesPerTask = 1u;
+
+/// Rectangular block of cells [start, start + size) in grid_map index space.
+struct CellRange {
+  CellRange()
+      : start(Eigen::Array2i::Zero()), size(Eigen::Array2i::Zero()) {}
+  CellRange(const Eigen::Array2i& start_, const Eigen::Array2i& size_)
+      : start(start_), size(size_) {}
+
+  inline bool isEmpty() const { return (size <= 0).any(); }
+
+  inline size_t getNumCells() const {
+    return isEmpty() ? 0u : static_cast<size_t>(size(0)) *
+                                static_cast<size_t>(size(1));
+  }
+
+  inline Eigen::Array2i getEnd() const { return start + size; }
+
+  inline bool contains(const Eigen::Array2i& index) const {
+    return (index >= start).all() && (index < getEnd()).all();
+  }
+
+  /// Returns the cells that are part of both ranges.
+  inline CellRange intersect(const CellRange& other) const {
+    const Eigen::Array2i intersection_start = start.max(other.start);
+    const Eigen::Array2i intersection_end = getEnd().min(other.getEnd());
+    return CellRange(intersection_start,
+                     (intersection_end - intersection_start).max(0));
+  }
+
+  /// Grows the range to the bounding box of both ranges.
+  inline void extend(const CellRange& other) {
+    if (other.isEmpty()) {
+      return;
+    }
+    if (isEmpty()) {
+      *this = other;
+      return;
+    }
+    const Eigen::Array2i extended_end = getEnd().max(other.getEnd());
+    start = start.min(other.start);
+    size = extended_end - start;
+  }
+
+  Eigen::Array2i start;
+  Eigen::Array2i size;
+};
+
+/// Partitions a map of map_size cells into square tiles of tile_size cells.
+/// Tiles along the border may be smaller. The linear tile index runs fastest
+/// along the first index dimension, which matches the column-major storage of
+/// the grid_map layers.
+class CellTiling {
+ public:
+  CellTiling(const Eigen::Array2i& map_size, int tile_size)
+      : map_size_(map_size), tile_size_(tile_size) {
+    CHECK_GT(tile_size_, 0);
+    CHECK((map_size_ >= 0).all());
+    num_tiles_ = (map_size_ + tile_size_ - 1) / tile_size_;
+  }
+
+  inline size_t getNumTiles() const {
+    return static_cast<size_t>(num_tiles_(0)) *
+           static_cast<size_t>(num_tiles_(1));
+  }
+
+  inline const Eigen::Array2i& getNumTilesPerDimension() const {
+    return num_tiles_;
+  }
+
+  inline const Eigen::Array2i& getMapSize() const { return map_size_; }
+
+  inline int getTileSize() const { return tile_size_; }
+
+  inline size_t getTileIndex(const Eigen::Array2i& tile_coordinates) const {
+    DCHECK((tile_coordinates >= 0).all());
+    DCHECK((tile_coordinates < num_tiles_).all());
+    return static_cast<size_t>(tile_coordinates(0)) +
+           static_cast<size_t>(tile_coordinates(1)) *
+               static_cast<size_t>(num_tiles_(0));
+  }
+
+  /// Linear index of the tile that contains the given cell.
+  inline size_t getTileIndexOfCell(const Eigen::Array2i& cell_index) const {
+    return getTileIndex(cell_index / tile_size_);
+  }
+
+  /// Cells covered by the tile with the given linear index.
+  inline CellRange getTileCells(size_t tile_index) const {
+    DCHECK_LT(tile_index, getNumTiles());
+    const int num_tiles_x = num_tiles_(0);
+    const Eigen::Array2i tile_coordinates(
+        static_cast<int>(tile_index % num_tiles_x),
+        static_cast<int>(tile_index / num_tiles_x));
+    const Eigen::Array2i start = tile_coordinates * tile_size_;
+    return CellRange(start,
+                     (map_size_ - start).min(Eigen::Array2i::Constant(
+                         tile_size_)));
+  }
+
+  /// Tile coordinates [start, start + size) of all tiles that overlap with the
+  /// given cell range.
+  inline CellRange getTilesCovering(const CellRange& cells) const {
+    const CellRange cells_in_map =
+        cells.intersect(CellRange(Eigen::Array2i::Zero(), map_size_));
+    if (cells_in_map.isEmpty()) {
+      return CellRange();
+    }
+    const Eigen::Array2i first_tile = cells_in_map.start / tile_size_;
+    const Eigen::Array2i last_tile =
+        (cells_in_map.getEnd() - 1) / tile_size_;
+    return CellRange(first_tile, last_tile - first_tile + 1);
+  }
+
+ private:
+  Eigen::Array2i map_size_;
+  Eigen::Array2i num_tiles_;
+  int tile_size_;
+};
+
+/// Processes all tiles on the thread pool. The functor is called once per
+/// tile as functor(tile_index, tile_cells). Within a tile, cells should be
+/// visited with the first index in the inner loop to follow the memory layout.
+template <typename Functor>
+void parForTiles(const CellTiling& tiling, const Functor& functor,
+                 ThreadPool* thread_pool) {
+  CHECK_NOTNULL(thread_pool);
+  thread_pool->parallelFor(
+      tiling.getNumTiles(),
+      [&](size_t begin, size_t end) {
+        for (size_t tile_index = begin; tile_index < end; ++tile_index) {
+          functor(tile_index, tiling.getTileCells(tile_index));
+        }
+      },
+      kTilesPerTask);
+}
+
+/// Processes only the tiles that overlap with the given cell range. The
+/// functor receives the part of each tile that lies inside the range.
+template <typename Functor>
+void parForTiles(const CellTiling& tiling, const CellRange& cells,
+                 const Functor& functor, ThreadPool* thread_pool) {
+  CHECK_NOTNULL(thread_pool);
+  const CellRange tiles = tiling.getTilesCovering(cells);
+  thread_pool->parallelFor(
+      tiles.getNumCells(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const Eigen::Array2i tile_coordinates(
+              tiles.start(0) + static_cast<int>(i % tiles.size(0)),
+              tiles.start(1) + static_cast<int>(i / tiles.size(0)));
+          const size_t tile_index = tiling.getTileIndex(tile_coordinates);
+          functor(tile_index, tiling.getTileCells(tile_index).intersect(cells));
+        }
+      },
+      kTilesPerTask);
+}
+
+}  // namespace utils
+
+#endif  // UTILS_TILING_H_
@@ -0,0 +1,74 @@
+/*
+ *    Filename: utils-bucket-grid.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-utils/utils-bucket-grid.h"
+
+// SYSTEM
+#include <cmath>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace utils {
+
+PointBucketGrid::PointBucketGrid(double bucket_size)
+    : bucket_size_(bucket_size) {
+  CHECK_GT(bucket_size_, 0.0);
+}
+
+void PointBucketGrid::insert(double x, double y, double z) {
+  const BucketCoordinates bucket = getBucketCoordinates(x, y);
+  buckets_[getBucketKey(bucket.first, bucket.second)].push_back(
+      static_cast<int>(points_.size()));
+  points_.push_back(Point{x, y, z});
+}
+
+void PointBucketGrid::clear() {
+  points_.clear();
+  buckets_.clear();
+}
+
+void PointBucketGrid::radiusSearch(
+    double x, double y, double radius_squared,
+    std::vector<std::pair<int, double> >* indices_dists) const {
+  CHECK_NOTNULL(indices_dists);
+  if (radius_squared <= 0.0 || points_.empty()) {
+    return;
+  }
+  const double radius = std::sqrt(radius_squared);
+  const BucketCoordinates min_bucket =
+      getBucketCoordinates(x - radius, y - radius);
+  const BucketCoordinates max_bucket =
+      getBucketCoordinates(x + radius, y + radius);
+  for (int bucket_y = min_bucket.second; bucket_y <= max_bucket.second;
+       ++bucket_y) {
+    for (int bucket_x = min_bucket.first; bucket_x <= max_bucket.first;
+         ++bucket_x) {
+      const auto bucket = buckets_.find(getBucketKey(bucket_x, bucket_y));
+      if (bucket == buckets_.end()) {
+        continue;
+      }
+      for (const int index : bucket->second) {
+        const double dx = x - points_[index].x;
+        const double dy = y - points_[index].y;
+        const double distance_squared = dx * dx + dy * dy;
+        if (distance_squared < radius_squared) {
+          indices_dists->emplace_back(index, distance_squared);
+        }
+      }
+    }
+  }
+}
+
+PointBucketGrid::BucketCoordinates PointBucketGrid::getBucketCoordinates(
+    double x, double y) const {
+  return BucketCoordinates(static_cast<int>(std::floor(x / bucket_size_)),
+                           static_cast<int>(std::floor(y / bucket_size_)));
+}
+
+}  // namespace utils
@@ -0,0 +1,209 @@
+/*
+ *    Filename: utils-downsampling.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-utils/utils-downsampling.h"
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+// NON-SYSTEM
+#include <glog/logging.h>
+
+namespace utils {
+
+namespace {
+
+// Fixed, so the result does not depend on the number of threads.
+constexpr size_t kNumPartitions = 64u;
+constexpr size_t kNumChunks = 64u;
+
+// Bin key and index of a point.
+typedef std::pair<uint64_t, uint32_t> BinEntry;
+
+// Bin indices are limited to (INT32_MIN, INT32_MAX], so the key of the bin
+// (INT32_MIN, 0) marks the points that are skipped.
+constexpr double kMinBinIndex = static_cast<double>(INT32_MIN) + 1.0;
+constexpr double kMaxBinIndex = static_cast<double>(INT32_MAX);
+constexpr uint64_t kSkippedKey = static_cast<uint64_t>(1u) << 63;
+
+/// Key of the bin of the point, kSkippedKey if it is not finite.
+inline uint64_t getBinKey(const Eigen::Vector3d& point,
+                          double inverse_bin_size) {
+  if (!point.allFinite()) {
+    return kSkippedKey;
+  }
+  const double x = std::floor(point(0) * inverse_bin_size);
+  const double y = std::floor(point(1) * inverse_bin_size);
+  CHECK(x >= kMinBinIndex && x <= kMaxBinIndex && y >= kMinBinIndex &&
+        y <= kMaxBinIndex)
+      << "Bin of point " << point.transpose() << " exceeds the int32 range, "
+      << "the bins are too small for the extent of the point cloud.";
+  return (static_cast<uint64_t>(static_cast<uint32_t>(static_cast<int32_t>(x)))
+          << 32) |
+         static_cast<uint64_t>(static_cast<uint32_t>(static_cast<int32_t>(y)));
+}
+
+inline size_t getPartition(uint64_t key) {
+  // Scatters neighboring bins over the partitions.
+  return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) %
+         kNumPartitions;
+}
+
+template <typename Functor>
+void parallelFor(size_t num_items, const Functor& functor,
+                 ThreadPool* thread_pool) {
+  if (thread_pool) {
+    thread_pool->parallelFor(num_items, functor, 1u);
+  } else {
+    functor(size_t(0u), num_items);
+  }
+}
+
+/// Median by partial sorting; the upper median for an even count.
+template <typename T>
+T getMedian(std::vector<T>* values) {
+  CHECK(!values->empty());
+  const auto middle = values->begin() + values->size() / 2u;
+  std::nth_element(values->begin(), middle, values->end());
+  return *middle;
+}
+
+}  // namespace
+
+void downsamplePointCloud(
+    const DownsamplingSettings& settings,
+    const AlignedType<std::vector, Eigen::Vector3d>::type& point_cloud,
+    const int* intensities,
+    AlignedType<std::vector, Eigen::Vector3d>::type* point_cloud_downsampled,
+    std::vector<int>* intensities_downsampled, ThreadPool* thread_pool) {
+  CHECK_NOTNULL(point_cloud_downsampled);
+  CHECK_NE(&point_cloud, point_cloud_downsampled);
+  CHECK_GT(settings.bin_size_m, 0.0);
+  const size_t num_points = point_cloud.size();
+  CHECK_LT(num_points, static_cast<size_t>(UINT32_MAX));
+
+  // 1. Bin keys, and the number of points per chunk and partition.
+  const double inverse_bin_size = 1.0 / settings.bin_size_m;
+  const size_t chunk_size = (num_points + kNumChunks - 1u) / kNumChunks;
+  std::vector<uint64_t> keys(num_points);
+  std::vector<size_t> counts(kNumChunks * kNumPartitions, 0u);
+  parallelFor(kNumChunks, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      size_t* chunk_counts = &counts[chunk * kNumPartitions];
+      const size_t chunk_end = std::min(num_points, (chunk + 1u) * chunk_size);
+      for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+        keys[i] = getBinKey(point_cloud[i], inverse_bin_size);
+        if (keys[i] != kSkippedKey) {
+          ++chunk_counts[getPartition(keys[i])];
+        }
+      }
+    }
+  }, thread_pool);
+
+  // 2. Scatter the points into their partitions. Every chunk writes from the
+  // number of points of the preceding partitions and chunks.
+  std::vector<size_t> partition_offsets(kNumPartitions + 1u, 0u);
+  std::vector<size_t> offsets(kNumChunks * kNumPartitions);
+  size_t offset = 0u;
+  for (size_t partition = 0u; partition < kNumPartitions; ++partition) {
+    partition_offsets[partition] = offset;
+    for (size_t chunk = 0u; chunk < kNumChunks; ++chunk) {
+      offsets[chunk * kNumPartitions + partition] = offset;
+      offset += counts[chunk * kNumPartitions + partition];
+    }
+  }
+  partition_offsets[kNumPartitions] = offset;
+  std::vector<BinEntry> entries(offset);
+  parallelFor(kNumChunks, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      size_t* chunk_offsets = &offsets[chunk * kNumPartitions];
+      const size_t chunk_end = std::min(num_points, (chunk + 1u) * chunk_size);
+      for (size_t i = chunk * chunk_size; i < chunk_end; ++i) {
+        if (keys[i] != kSkippedKey) {
+          entries[chunk_offsets[getPartition(keys[i])]++] =
+              BinEntry(keys[i], static_cast<uint32_t>(i));
+        }
+      }
+    }
+  }, thread_pool);
+  keys.clear();
+  keys.shrink_to_fit();
+
+  // 3. Sort every partition by bin and count its bins.
+  std::vector<size_t> bin_offsets(kNumPartitions + 1u, 0u);
+  parallelFor(kNumPartitions, [&](size_t begin, size_t end) {
+    for (size_t partition = begin; partition < end; ++partition) {
+      const auto partition_begin =
+          entries.begin() + partition_offsets[partition];
+      const auto partition_end =
+          entries.begin() + partition_offsets[partition + 1u];
+      std::sort(partition_begin, partition_end);
+      size_t num_bins = 0u;
+      for (auto it = partition_begin; it != partition_end; ++it) {
+        num_bins += (it == partition_begin || it->first != (it - 1)->first);
+      }
+      bin_offsets[partition + 1u] = num_bins;
+    }
+  }, thread_pool);
+  for (size_t partition = 0u; partition < kNumPartitions; ++partition) {
+    bin_offsets[partition + 1u] += bin_offsets[partition];
+  }
+
+  // 4. Reduce every bin to one point.
+  point_cloud_downsampled->resize(bin_offsets.back());
+  if (intensities_downsampled) {
+    intensities_downsampled->assign(bin_offsets.back(), 0);
+  }
+  const bool use_median = settings.statistic == BinStatistic::Median;
+  parallelFor(kNumPartitions, [&](size_t begin, size_t end) {
+    std::vector<double> heights;
+    std::vector<int> bin_intensities;
+    for (size_t partition = begin; partition < end; ++partition) {
+      size_t bin = bin_offsets[partition];
+      size_t i = partition_offsets[partition];
+      while (i < partition_offsets[partition + 1u]) {
+        const uint64_t key = entries[i].first;
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        double intensity_sum = 0.0;
+        heights.clear();
+        bin_intensities.clear();
+        size_t num_bin_points = 0u;
+        for (; i < partition_offsets[partition + 1u] &&
+               entries[i].first == key;
+             ++i, ++num_bin_points) {
+          const uint32_t index = entries[i].second;
+          sum += point_cloud[index];
+          const int intensity = intensities ? intensities[index] : 0;
+          intensity_sum += intensity;
+          if (use_median) {
+            heights.push_back(point_cloud[index](2));
+            bin_intensities.push_back(intensity);
+          }
+        }
+        Eigen::Vector3d point = sum / num_bin_points;
+        int intensity =
+            static_cast<int>(std::lround(intensity_sum / num_bin_points));
+        if (use_median) {
+          point(2) = getMedian(&heights);
+          intensity = getMedian(&bin_intensities);
+        }
+        (*point_cloud_downsampled)[bin] = point;
+        if (intensities_downsampled) {
+          (*intensities_downsampled)[bin] = intensity;
+        }
+        ++bin;
+      }
+      DCHECK_EQ(bin, bin_offsets[partition + 1u]);
+    }
+  }, thread_pool);
+}
+
+}  // namespace utils
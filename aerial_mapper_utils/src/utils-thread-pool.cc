@@ -0,0 +1,149 @@
+/*
+ *    Filename: utils-thread-pool.cc
+ *  Created on: Oct 15, 2026
+ *      Author: Timo Hinzmann
+ *   Institute: ETH Zurich, Autonomous Systems Lab
+ */
+
+// HEADER
+#include "aerial-mapper-utils/utils-thread-pool.h"
+
+// SYSTEM
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace utils {
+
+namespace {
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker_index = ThreadPool::kAnyWorker;
+}  // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolSettings& settings)
+    : settings_(settings),
+      num_queued_tasks_(0u),
+      next_queue_(0u),
+      shutdown_(false) {
+  size_t num_threads = settings_.num_threads;
+  if (num_threads == 0u) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0u; i < num_threads; ++i) {
+    queues_.emplace_back(new WorkerQueue());
+  }
+  for (size_t i = 0u; i < num_threads; ++i) {
+    workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+  VLOG(3) << "Started thread pool with " << num_threads << " workers.";
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    shutdown_ = true;
+  }
+  wake_condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getCurrentWorkerIndex() { return current_worker_index; }
+
+size_t ThreadPool::getHomeQueueIndex() const {
+  if (current_pool == this) {
+    return current_worker_index;
+  }
+  return next_queue_ % queues_.size();
+}
+
+void ThreadPool::submit(const Task& task, size_t worker_index) {
+  if (worker_index == kAnyWorker) {
+    worker_index = (current_pool == this) ? current_worker_index
+                                          : next_queue_++ % queues_.size();
+  }
+  CHECK_LT(worker_index, queues_.size());
+  {
+    WorkerQueue& queue = *queues_[worker_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+  ++num_queued_tasks_;
+  {
+    // Taking the lock orders the notification after a concurrent predicate
+    // check of a worker that is about to sleep.
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+  }
+  wake_condition_.notify_one();
+}
+
+bool ThreadPool::tryPopTask(size_t worker_index, Task* task) {
+  CHECK_NOTNULL(task);
+  if (num_queued_tasks_ == 0u) {
+    return false;
+  }
+  const size_t num_queues = queues_.size();
+  for (size_t k = 0u; k < num_queues; ++k) {
+    const size_t queue_index = (worker_index + k) % num_queues;
+    WorkerQueue& queue = *queues_[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    if (k == 0u) {
+      // Own queue: newest task first, its data is most likely still cached.
+      *task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      // Steal the oldest task, which tends to be the largest chunk of work.
+      *task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    --num_queued_tasks_;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t worker_index) {
+  current_pool = this;
+  current_worker_index = worker_index;
+  if (settings_.pin_threads_to_cores) {
+    pinToCore(worker_index);
+  }
+  Task task;
+  while (true) {
+    if (tryPopTask(worker_index, &task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_condition_.wait(lock, [this]() {
+      return shutdown_ || num_queued_tasks_ > 0u;
+    });
+    if (shutdown_ && num_queued_tasks_ == 0u) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::pinToCore(size_t worker_index) {
+#ifdef __linux__
+  const size_t num_cores = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(worker_index % num_cores, &cpu_set);
+  const int result =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+  LOG_IF(WARNING, result != 0) << "Could not pin worker " << worker_index
+                               << " to a core (error " << result << ").";
+#else
+  LOG(WARNING) << "Pinning threads to cores is not supported on this "
+               << "platform.";
+#endif
+}
+
+}  // namespace utils